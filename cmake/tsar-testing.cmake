@@ -32,7 +32,15 @@ function(tsar_test)
 
   set(OPTION_LIST --total-time --failed f -s)
   set(PLUGIN_LIST -I ${PTS_PLUGIN_PATH})
-  set(TASK_CONFIG -T . -T ${PTS_SETENV_PATH} setenv:tsar=$<TARGET_FILE:tsar> parallel)
+  # Intermediate files of tests should be placed in a build directory.
+  set(TT_ENV tsar=$<TARGET_FILE:tsar>,workdir=${CMAKE_CURRENT_BINARY_DIR})
+  if(TSAR_TEST_CLANG)
+    set(TT_ENV ${TT_ENV},clang=${TSAR_TEST_CLANG})
+  endif()
+  if(TSAR_TEST_OPT)
+    set(TT_ENV ${TT_ENV},opt=${TSAR_TEST_OPT})
+  endif()
+  set(TASK_CONFIG -T . -T ${PTS_SETENV_PATH} setenv:${TT_ENV} parallel)
 
   add_custom_target(${TT_TEST_TARGET}
     COMMAND ${PERL_EXECUTABLE} ${PTS_EXECUTABLE} ${OPTION_LIST} ${PLUGIN_LIST} ${TASK_CONFIG} check
@@ -34,6 +34,8 @@
 //  * RegionDFTraits - It must be specialized to determine data-flow framework
 //                     for a hierarchy of regions.
 //  * solveDataFlow...() - It should be used to solve data-flow problem.
+//  * DFSolverKind - It selects an algorithm to solve data-flow problem for
+//                   a graph which contains cycles.
 //  * SmallDFNode - It can be inherited to represent nodes of a data-flow graph.
 //
 //===----------------------------------------------------------------------===//
@@ -41,12 +43,19 @@
 #ifndef TSAR_DATA_FLOW_H
 #define TSAR_DATA_FLOW_H
 
+#include "tsar/ADT/GraphUtils.h"
+#include <llvm/ADT/DenseMap.h>
 #include <llvm/ADT/GraphTraits.h>
 #include <llvm/ADT/iterator_range.h>
 #include <llvm/ADT/SmallVector.h>
 #include <llvm/ADT/PostOrderIterator.h>
+#include <llvm/Support/ThreadPool.h>
 #include <algorithm>
+#include <atomic>
+#include <functional>
 #include <iterator>
+#include <memory>
+#include <queue>
 #include <type_traits>
 #include <vector>
 #include <bcl/utility.h>
@@ -170,6 +179,93 @@ template<class DFFwk> void solveDataFlowIteratively(DFFwk DFF,
   } while (isChanged);
 }
 
+/// \brief Iteratively solves data-flow problem using a worklist.
+///
+/// This computes the same solution as solveDataFlowIteratively() but it
+/// avoids sweeps over all nodes of the graph. At first, each node is evaluated
+/// once in a reverse postorder. Afterwards, a node is evaluated again only
+/// if a data-flow value of at least one of its predecessors (in a data-flow
+/// direction) has been changed. The worklist is a priority queue ordered by
+/// reverse postorder numbers, so all predecessors of a node are evaluated
+/// before the node if it is possible. Each node is presented in the worklist
+/// at most once.
+/// \param [in, out] DFF Data-flow framework, it can not be null.
+/// \param [in, out] DFG Data-flow graph specified in the data-flow framework.
+/// Subgraph of this graph also can be used.
+/// \attention The DataFlowTraits class should be specialized by DFFwk.
+/// Note that DFFwk is generally a pointer type.
+/// The GraphTraits class should be specialized by
+/// DataFlowTraits<DFFwk>::GraphType and by
+/// llvm::Inverse<DataFlowTraits<DFFwk>::GraphType>.
+/// \pre The graph must not contain unreachable nodes.
+template<class DFFwk> void solveDataFlowWorklist(DFFwk DFF,
+    typename DataFlowTraits<DFFwk>::GraphType DFG) {
+  typedef DataFlowTraits<DFFwk> DFT;
+  typedef typename DFT::ValueType ValueType;
+  typedef typename DFT::GraphType GraphType;
+  typedef llvm::GraphTraits<GraphType> GT;
+  typedef llvm::GraphTraits<llvm::Inverse<GraphType>> IGT;
+  typedef typename GT::nodes_iterator nodes_iterator;
+  typedef typename GT::ChildIteratorType ChildIteratorType;
+  typedef typename GT::NodeRef NodeRef;
+  typedef llvm::po_iterator<
+    GraphType, llvm::SmallPtrSet<NodeRef, 8>, false, IGT> po_iterator;
+  // Nodes in reverse postorder, the entry node has number 0.
+  std::vector<NodeRef> RPOT;
+  std::copy(po_iterator::begin(DFG), po_iterator::end(DFG),
+            std::back_inserter(RPOT));
+  std::reverse(RPOT.begin(), RPOT.end());
+  assert(!RPOT.empty() && RPOT.front() == GT::getEntryNode(DFG) &&
+    "The first node in the topological order differs from the entry node in the data-flow framework!");
+  llvm::DenseMap<NodeRef, unsigned> RPONumbers;
+  for (unsigned I = 0, EI = RPOT.size(); I < EI; ++I)
+    RPONumbers.try_emplace(RPOT[I], I);
+  for (nodes_iterator I = GT::nodes_begin(DFG), E = GT::nodes_end(DFG);
+       I != E; ++I) {
+    DFT::initialize(*I, DFF, DFG);
+    DFT::setValue(DFT::topElement(DFF, DFG), *I, DFF);
+    // A node which is not reachable in a data-flow direction is evaluated
+    // after all reachable nodes.
+    if (RPONumbers.try_emplace(*I, RPOT.size()).second)
+      RPOT.push_back(*I);
+  }
+  DFT::initialize(GT::getEntryNode(DFG), DFF, DFG);
+  DFT::setValue(DFT::boundaryCondition(DFF, DFG), GT::getEntryNode(DFG), DFF);
+  std::priority_queue<unsigned, std::vector<unsigned>, std::greater<unsigned>>
+    Worklist;
+  std::vector<bool> IsDirty(RPOT.size(), true);
+  IsDirty.front() = false;
+  for (unsigned I = 1, EI = RPOT.size(); I < EI; ++I)
+    Worklist.push(I);
+  while (!Worklist.empty()) {
+    unsigned Idx = Worklist.top();
+    Worklist.pop();
+    IsDirty[Idx] = false;
+    NodeRef N = RPOT[Idx];
+    assert((N == GT::getEntryNode(DFG) ||
+      GT::child_begin(N) != GT::child_end(N)) &&
+      "Data-flow graph must not contain unreachable nodes!");
+    ValueType Value(DFT::topElement(DFF, DFG));
+    for (ChildIteratorType CI = GT::child_begin(N), CE = GT::child_end(N);
+         CI != CE; ++CI) {
+      DFT::meetOperator(DFT::getValue(*CI, DFF), Value, DFF, DFG);
+    }
+    if (!DFT::transferFunction(std::move(Value), N, DFF, DFG))
+      continue;
+    for (auto SI = IGT::child_begin(N), SE = IGT::child_end(N); SI != SE;
+         ++SI) {
+      auto NumItr = RPONumbers.find(*SI);
+      // Successors outside the graph (for example, exit nodes of outer regions)
+      // and the entry node are not evaluated.
+      if (NumItr == RPONumbers.end() || NumItr->second == 0 ||
+          IsDirty[NumItr->second])
+        continue;
+      IsDirty[NumItr->second] = true;
+      Worklist.push(NumItr->second);
+    }
+  }
+}
+
 /// \brief Solves data-flow problem in topological order during one iteration.
 ///
 /// This computes IN and OUT for each node in the specified data-flow graph
@@ -234,6 +330,28 @@ template<class DFFwk> void solveDataFlowTopologicaly(DFFwk DFF,
   }
 }
 
+/// Algorithm which is used to solve a data-flow problem for a graph
+/// which contains cycles.
+enum class DFSolverKind {
+  /// Evaluate all nodes until no value changes (solveDataFlowIteratively()).
+  RoundRobin,
+  /// Evaluate successors of changed nodes only (solveDataFlowWorklist()).
+  Worklist
+};
+
+namespace detail {
+/// Solves data-flow problem for a single region in a hierarchy of regions.
+template<class DFFwk> void solveDataFlowRegion(DFFwk DFF,
+    typename DataFlowTraits<DFFwk>::GraphType DFG, DFSolverKind Solver) {
+  if (isDAG(DFG))
+    solveDataFlowTopologicaly(DFF, DFG);
+  else if (Solver == DFSolverKind::Worklist)
+    solveDataFlowWorklist(DFF, DFG);
+  else
+    solveDataFlowIteratively(DFF, DFG);
+}
+}
+
 /// \brief Data-flow framework for a hierarchy of regions.
 ///
 /// This class should be specialized by different region types
@@ -282,6 +400,7 @@ template<class DFFwk > struct RegionDFTraits {
 /// \param [in, out] DFF Data-flow framework, it can not be null.
 /// \param [in, out] DFG Data-flow graph specified in the data-flow framework.
 /// Subgraph of this graph also can be used.
+/// \param [in] Solver Algorithm to solve the problem for regions with cycles.
 /// \attention DataFlowTraits and RegionDFTraits classes should be specialized
 /// by DFFwk. Note that DFFwk is generally a pointer type.
 /// The llvm::GraphTraits class should be specialized by type of each
@@ -289,17 +408,15 @@ template<class DFFwk > struct RegionDFTraits {
 /// Note that type of region is generally a pointer type.
 /// \pre The graph must not contain unreachable nodes.
 template<class DFFwk> void solveDataFlowUpward(DFFwk DFF,
-    typename DataFlowTraits<DFFwk>::GraphType DFG) {
+    typename DataFlowTraits<DFFwk>::GraphType DFG,
+    DFSolverKind Solver = DFSolverKind::Worklist) {
   typedef RegionDFTraits<DFFwk> RT;
   typedef typename RT::region_iterator region_iterator;
   RT::expand(DFF, DFG);
   for (region_iterator I = RT::region_begin(DFG), E = RT::region_end(DFG);
        I != E; ++I)
-    solveDataFlowUpward(DFF, *I);
-  if (isDAG(DFG))
-    solveDataFlowTopologicaly(DFF, DFG);
-  else
-    solveDataFlowIteratively(DFF, DFG);
+    solveDataFlowUpward(DFF, *I, Solver);
+  detail::solveDataFlowRegion(DFF, DFG, Solver);
   RT::collapse(DFF, DFG);
 }
 
@@ -319,6 +436,7 @@ template<class DFFwk> void solveDataFlowUpward(DFFwk DFF,
 /// \param [in, out] DFF Data-flow framework, it can not be null.
 /// \param [in, out] DFG Data-flow graph specified in the data-flow framework.
 /// Subgraph of this graph also can be used.
+/// \param [in] Solver Algorithm to solve the problem for regions with cycles.
 /// \attention DataFlowTraits and RegionDFTraits classes should b e specialized
 /// by DFFwk. Note that DFFwk is generally a pointer type.
 /// The llvm::GraphTraits class should be specialized by type of each
@@ -326,20 +444,124 @@ template<class DFFwk> void solveDataFlowUpward(DFFwk DFF,
 /// Note that type of region is generally a pointer type.
 /// \pre The graph must not contain unreachable nodes.
 template<class DFFwk> void solveDataFlowDownward(DFFwk DFF,
-  typename DataFlowTraits<DFFwk>::GraphType DFG) {
+  typename DataFlowTraits<DFFwk>::GraphType DFG,
+  DFSolverKind Solver = DFSolverKind::Worklist) {
   typedef RegionDFTraits<DFFwk> RT;
   typedef typename RT::region_iterator region_iterator;
   RT::expand(DFF, DFG);
-  if (isDAG(DFG))
-    solveDataFlowTopologicaly(DFF, DFG);
-  else
-    solveDataFlowIteratively(DFF, DFG);
+  detail::solveDataFlowRegion(DFF, DFG, Solver);
   for (region_iterator I = RT::region_begin(DFG), E = RT::region_end(DFG);
        I != E; ++I)
-    solveDataFlowDownward(DFF, *I);
+    solveDataFlowDownward(DFF, *I, Solver);
   RT::collapse(DFF, DFG);
 }
 
+namespace detail {
+/// Flat representation of a hierarchy of regions which is used to solve
+/// data-flow problems for independent regions concurrently.
+///
+/// Regions are stored in a breadth-first order, so each parent region
+/// precedes its inner regions and inner regions of each region are stored
+/// contiguously.
+template<class DFFwk> class RegionHierarchy {
+public:
+  typedef typename DataFlowTraits<DFFwk>::GraphType GraphType;
+  typedef RegionDFTraits<DFFwk> RT;
+
+  explicit RegionHierarchy(GraphType DFG) {
+    mRegions.push_back(DFG);
+    mParents.push_back(0);
+    for (std::size_t Idx = 0; Idx < mRegions.size(); ++Idx) {
+      GraphType G = mRegions[Idx];
+      mChildBegin.push_back(mRegions.size());
+      for (auto I = RT::region_begin(G), E = RT::region_end(G); I != E; ++I) {
+        mRegions.emplace_back(*I);
+        mParents.push_back(Idx);
+      }
+      mChildEnd.push_back(mRegions.size());
+    }
+    mNumPending.reset(new std::atomic<std::size_t>[mRegions.size()]);
+    for (std::size_t Idx = 0; Idx < mRegions.size(); ++Idx)
+      mNumPending[Idx] = mChildEnd[Idx] - mChildBegin[Idx];
+  }
+
+  /// Returns number of regions in the hierarchy.
+  std::size_t size() const noexcept { return mRegions.size(); }
+
+  /// Returns a region with a specified index, the outermost region has
+  /// index 0.
+  GraphType region(std::size_t Idx) const { return mRegions[Idx]; }
+
+  /// Returns range of indexes of inner regions for a specified region.
+  std::pair<std::size_t, std::size_t> children(std::size_t Idx) const {
+    return std::make_pair(mChildBegin[Idx], mChildEnd[Idx]);
+  }
+
+  /// Returns true if a specified region has no inner regions.
+  bool isLeaf(std::size_t Idx) const {
+    return mChildBegin[Idx] == mChildEnd[Idx];
+  }
+
+  /// Notifies that processing of a specified region has been finished and
+  /// returns true if all inner regions of its parent have been processed.
+  ///
+  /// This function is thread-safe.
+  bool finish(std::size_t Idx) {
+    assert(Idx != 0 && "The outermost region has no parent!");
+    return --mNumPending[mParents[Idx]] == 0;
+  }
+
+  /// Returns index of a parent region.
+  std::size_t parent(std::size_t Idx) const { return mParents[Idx]; }
+
+private:
+  std::vector<GraphType> mRegions;
+  std::vector<std::size_t> mParents;
+  std::vector<std::size_t> mChildBegin;
+  std::vector<std::size_t> mChildEnd;
+  std::unique_ptr<std::atomic<std::size_t>[]> mNumPending;
+};
+}
+
+/// \brief Solves data-flow problem for the specified hierarchy of regions
+/// using a specified pool of threads.
+///
+/// This is a parallel version of solveDataFlowDownward(). When a region has
+/// been solved its inner regions are solved concurrently. A region is
+/// collapsed by a thread which collapses the last of its inner regions.
+/// \attention Functions from DataFlowTraits and RegionDFTraits may be
+/// concurrently evaluated for nodes from different sibling regions. So,
+/// the framework must not change shared state (for example, insert new
+/// elements into a map of data-flow values) while problem is solved.
+/// \post This function returns when all tasks in the pool have finished.
+template<class DFFwk> void solveDataFlowDownward(DFFwk DFF,
+    typename DataFlowTraits<DFFwk>::GraphType DFG, llvm::ThreadPool &Pool,
+    DFSolverKind Solver = DFSolverKind::Worklist) {
+  typedef RegionDFTraits<DFFwk> RT;
+  detail::RegionHierarchy<DFFwk> RH(DFG);
+  std::function<void(std::size_t)> Finish = [DFF, &RH,
+                                              &Finish](std::size_t Idx) {
+    RT::collapse(DFF, RH.region(Idx));
+    if (Idx != 0 && RH.finish(Idx))
+      Finish(RH.parent(Idx));
+  };
+  std::function<void(std::size_t)> Solve = [DFF, Solver, &RH, &Pool, &Solve,
+                                             &Finish](std::size_t Idx) {
+    RT::expand(DFF, RH.region(Idx));
+    detail::solveDataFlowRegion(DFF, RH.region(Idx), Solver);
+    if (RH.isLeaf(Idx)) {
+      Finish(Idx);
+      return;
+    }
+    auto Children = RH.children(Idx);
+    for (auto ChildIdx = Children.first; ChildIdx < Children.second;
+         ++ChildIdx)
+      Pool.async([&Solve, ChildIdx]() { Solve(ChildIdx); });
+  };
+  Pool.async([&Solve]() { Solve(0); });
+  Pool.wait();
+}
+
 namespace detail{
 /// This covers an IN value for a data-flwo node.
 template<class InTy> class DFValueIn {
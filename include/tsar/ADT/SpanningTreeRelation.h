@@ -21,15 +21,24 @@
 // This file defines classes to check whether two nodes in spanning tree are
 // connected and to determine ancestor and descendant.
 //
+// Nodes of a spanning tree are enumerated once, so relation between two nodes
+// is determined in constant time after their identifiers are found. Nodes may
+// store their identifiers (see SpanningTreeNodeTraits), otherwise identifiers
+// are looked up in a map. The lowest common ancestor of two nodes is
+// determined in logarithmic time with a binary lifting technique.
+//
 //===----------------------------------------------------------------------===//
 
 #ifndef TSAR_SPANNING_TREE_RELATION_H
 #define TSAR_SPANNING_TREE_RELATION_H
 
-#include "GraphNumbering.h"
+#include <llvm/ADT/DenseMap.h>
 #include <llvm/ADT/GraphTraits.h>
 #include <llvm/ADT/Optional.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/Support/MathExtras.h>
 #include <type_traits>
+#include <vector>
 
 namespace tsar {
 /// Represents node relation in a tree.
@@ -44,36 +53,119 @@ enum TreeRelation : int8_t {
   NUMBER_TR = INVALID_TR
 };
 
+/// Provides access to an identifier of a node in a spanning tree which is
+/// stored in the node.
+///
+/// This should be specialized for references to nodes which can store
+/// an identifier, so identifiers of these nodes are found without lookups.
+/// Specialization must provide the following members:
+/// - static constexpr bool HasId = true;
+/// - static unsigned getId(NodeRef);
+/// - static void setId(NodeRef, unsigned);
+///
+/// A node stores its identifier in the last built spanning tree only,
+/// identifiers in other trees are looked up in a map.
+template<class NodeRef> struct SpanningTreeNodeTraits {
+  static constexpr bool HasId = false;
+};
+
 /// This determine relation between two nodes in a spanning tree.
 template<class GraphType>
 class SpanningTreeRelation {
-  using NodeRef = typename llvm::GraphTraits<GraphType>::NodeRef;
+  using GT = llvm::GraphTraits<GraphType>;
+  using NodeRef = typename GT::NodeRef;
+  using NT = SpanningTreeNodeTraits<NodeRef>;
+
+  /// Description of a node in a spanning tree.
+  struct NodeInfo {
+    NodeInfo(NodeRef N, unsigned P, unsigned Pre, unsigned D) :
+      Node(N), Parent(P), Preorder(Pre), Depth(D) {}
+
+    NodeRef Node;
+    unsigned Parent;
+    unsigned Preorder;
+    unsigned Depth;
+    unsigned Postorder = 0;
+  };
 public:
+  /// Identifier of a node in a spanning tree.
+  ///
+  /// Relation between nodes is evaluated without lookups if their identifiers
+  /// are known, so identifiers should be used when the same node is compared
+  /// with a lot of other nodes.
+  using NodeId = unsigned;
 
   /// Performs initialization to determine relation of two nodes.
-  explicit SpanningTreeRelation(const GraphType &G) {
-    numberGraph(G, &mNumbering);
+  explicit SpanningTreeRelation(const GraphType &G) : mGraph(G) {
+    auto Size = GT::size(G);
+    mIds.reserve(Size);
+    mNodes.reserve(Size);
+    // Perform depth-first traversal of the graph to number nodes and to
+    // build a spanning tree.
+    using ChildItrT = typename GT::ChildIteratorType;
+    llvm::SmallVector<std::pair<unsigned, ChildItrT>, 16> Stack;
+    auto visit = [this, &Stack](NodeRef N, unsigned Parent, unsigned Depth) {
+      unsigned Id = mNodes.size();
+      mIds.try_emplace(N, Id);
+      if constexpr (NT::HasId)
+        NT::setId(N, Id);
+      mNodes.emplace_back(N, Parent, Id, Depth);
+      Stack.emplace_back(Id, GT::child_begin(N));
+    };
+    visit(GT::getEntryNode(G), 0, 0);
+    unsigned Postorder = 0;
+    while (!Stack.empty()) {
+      auto &Top = Stack.back();
+      auto Id = Top.first;
+      if (Top.second == GT::child_end(mNodes[Id].Node)) {
+        mNodes[Id].Postorder = Postorder++;
+        Stack.pop_back();
+        continue;
+      }
+      NodeRef Child = *Top.second++;
+      if (!mIds.count(Child))
+        visit(Child, Id, mNodes[Id].Depth + 1);
+    }
+    // Build a table of 2^K-th ancestors of each node.
+    auto NumNodes = mNodes.size();
+    mLog = llvm::Log2_32_Ceil(NumNodes) + 1;
+    mUp.resize(mLog * NumNodes);
+    for (unsigned I = 0; I < NumNodes; ++I)
+      mUp[I] = mNodes[I].Parent;
+    for (unsigned K = 1; K < mLog; ++K)
+      for (unsigned I = 0; I < NumNodes; ++I)
+        mUp[K * NumNodes + I] = mUp[(K - 1) * NumNodes +
+                                    mUp[(K - 1) * NumNodes + I]];
+  }
+
+  /// Returns identifier of a specified node.
+  NodeId getId(NodeRef N) const {
+    if constexpr (NT::HasId) {
+      auto Id = NT::getId(N);
+      if (Id < mNodes.size() && mNodes[Id].Node == N)
+        return Id;
+    }
+    auto I = mIds.find(N);
+    assert(I != mIds.end() && "Node must be a node of a spanning tree!");
+    return I->second;
   }
 
   /// Determines relation between two nodes in a spanning tree.
   TreeRelation compare(NodeRef LHS, NodeRef RHS) const {
     if (LHS == RHS)
       return TR_EQUAL;
-    auto LeftItr = mNumbering.find(LHS);
-    auto RightItr = mNumbering.find(RHS);
-    assert(LeftItr != mNumbering.end() &&
-      "LHS must be a node of a spanning tree!");
-    assert(RightItr != mNumbering.end() &&
-      "RHS must be a node of a spanning tree!");
-    if (LeftItr->template get<Preorder>() <
-            RightItr->template get<Preorder>() &&
-        LeftItr->template get<ReversePostorder>() <
-            RightItr->template get<ReversePostorder>())
+    return compare(getId(LHS), getId(RHS));
+  }
+
+  /// Determines relation between two nodes with specified identifiers.
+  TreeRelation compare(NodeId LHS, NodeId RHS) const {
+    if (LHS == RHS)
+      return TR_EQUAL;
+    auto &L = mNodes[LHS];
+    auto &R = mNodes[RHS];
+    if (L.Preorder < R.Preorder && L.Postorder > R.Postorder)
       return TR_ANCESTOR;
-    if (LeftItr->template get<Preorder>() >
-            RightItr->template get<Preorder>() &&
-      LeftItr->template get<ReversePostorder>() >
-            RightItr->template get<ReversePostorder>())
+    if (L.Preorder > R.Preorder && L.Postorder < R.Postorder)
       return TR_DESCENDANT;
     return TR_UNREACHABLE;
   }
@@ -97,15 +189,100 @@ public:
     return compare(LHS, RHS) == TR_UNREACHABLE;
   }
 
+  /// Returns a parent of a specified node in a spanning tree or None if
+  /// a specified node is a root of the tree.
+  llvm::Optional<NodeRef> getParent(NodeRef N) const {
+    auto Id = getId(N);
+    if (mNodes[Id].Parent == Id)
+      return llvm::None;
+    return mNodes[mNodes[Id].Parent].Node;
+  }
+
+  /// Returns identifier of a parent of a specified node, the root of a tree
+  /// is a parent of itself.
+  NodeId getParent(NodeId N) const { return mNodes[N].Parent; }
+
+  /// Returns depth of a specified node, the depth of the root is 0.
+  unsigned getDepth(NodeId N) const { return mNodes[N].Depth; }
+
+  /// Returns a node with a specified identifier.
+  NodeRef getNode(NodeId N) const { return mNodes[N].Node; }
+
+  /// Returns a graph this spanning tree has been built for.
+  const GraphType &getGraph() const noexcept { return mGraph; }
+
+  /// Returns the lowest common ancestor of specified nodes, the result may be
+  /// equal to one of the nodes.
+  NodeRef getLCA(NodeRef LHS, NodeRef RHS) const {
+    return mNodes[getLCA(getId(LHS), getId(RHS))].Node;
+  }
+
+  /// Returns the lowest common ancestor of specified nodes, the result may be
+  /// equal to one of the nodes.
+  ///
+  /// \pre The specified iterator range must not be empty.
+  template<class ItrTy>
+  NodeRef getLCA(ItrTy BeginItr, ItrTy EndItr) const {
+    assert(BeginItr != EndItr &&
+      "At least one node must be in a iterator range!");
+    auto LCA = getId(*BeginItr);
+    for (auto I = std::next(BeginItr); I != EndItr; ++I)
+      LCA = getLCA(LCA, getId(*I));
+    return mNodes[LCA].Node;
+  }
+
 private:
-  GraphNumbering<NodeRef> mNumbering;
+  NodeId getLCA(NodeId LHS, NodeId RHS) const {
+    switch (compare(LHS, RHS)) {
+    case TR_EQUAL: case TR_ANCESTOR: return LHS;
+    case TR_DESCENDANT: return RHS;
+    default: break;
+    }
+    auto NumNodes = mNodes.size();
+    for (unsigned K = mLog; K > 0; --K) {
+      auto Up = mUp[(K - 1) * NumNodes + LHS];
+      if (compare(Up, RHS) != TR_ANCESTOR)
+        LHS = Up;
+    }
+    return mNodes[LHS].Parent;
+  }
+
+  GraphType mGraph;
+  llvm::DenseMap<NodeRef, unsigned> mIds;
+  std::vector<NodeInfo> mNodes;
+  std::vector<unsigned> mUp;
+  unsigned mLog = 0;
 };
 
+namespace detail {
+/// Returns a reference to a specified node of a graph in an inverse graph.
+///
+/// A reference in an inverse graph must be constructible from a reference in
+/// a graph or from a reference in a graph and the graph (for example, see
+/// inverse alias trees).
+template<class GraphType>
+typename llvm::GraphTraits<llvm::Inverse<GraphType>>::NodeRef getInverseNode(
+    const GraphType &G, typename llvm::GraphTraits<GraphType>::NodeRef N) {
+  using GT = llvm::GraphTraits<GraphType>;
+  using NodeRef = typename llvm::GraphTraits<llvm::Inverse<GraphType>>::NodeRef;
+  if constexpr (std::is_constructible<NodeRef, typename GT::NodeRef>::value) {
+    return NodeRef(N);
+  } else {
+    static_assert(
+      std::is_constructible<NodeRef, typename GT::NodeRef, GraphType>::value,
+      "NodeRef of an inverse graph must be constructible from a graph node!");
+    return NodeRef(N, G);
+  }
+}
+}
+
 /// \brief Returns a parent of a specified node in a spanning tree of a graph.
 ///
 /// \pre llvm::GraphTraits must be available for GraphType and
 /// llvm::Inverse<GraphType>. References to a node of a graph must be
-/// assignable from a reference to a node in an inverse graph.
+/// assignable from a reference to a node in an inverse graph. References to
+/// a node of an inverse graph must be constructible as described in
+/// detail::getInverseNode().
 /// \return A parent of a specified node.
 template<class GraphType>
 llvm::Optional<
@@ -118,16 +295,19 @@ llvm::Optional<
   static_assert(std::is_assignable<typename GT::NodeRef, NodeRef>::value ||
     std::is_convertible<NodeRef, typename GT::NodeRef>::value,
     "NodeRef of a graph must be assignable from NodeRef of an inverse graph!");
-  for (auto I = IGT::child_begin(N), E = IGT::child_end(N); I != E; ++I) {
-    if (STR.isDescendant(N, *I))
-      return *I;
-  }
-  return llvm::None;
+  auto Id = STR.getId(N);
+  auto ParentId = STR.getParent(Id);
+  if (ParentId == Id)
+    return llvm::None;
+  return detail::getInverseNode(STR.getGraph(), STR.getNode(ParentId));
 }
 
 /// \brief Finds a lowest common ancestor for specified nodes in
 /// a spanning tree (result is not equal to any node).
 ///
+/// The ancestor is found in O(log N) time per a node in the range, where N is
+/// the number of nodes in the tree.
+///
 /// \pre
 /// - A spanning tree must contains all nodes from a [BeginItr, EndItr).
 /// - The specified iterator range must not be empty.
@@ -136,45 +316,33 @@ llvm::Optional<
 /// - Reference to a node of a graph must be assignable or convertible from
 /// a reference to a node in an inverse graph.
 /// - Reference to a node of an inverse graph must be assignable or convertible
-/// from dereferenced ItrTy.
+/// from dereferenced ItrTy and constructible as described in
+/// detail::getInverseNode().
 template<class GraphType, class ItrTy>
 llvm::Optional<
   typename llvm::GraphTraits<llvm::Inverse<GraphType>>::NodeRef> findLCA(
     const SpanningTreeRelation<GraphType> &STR, ItrTy BeginItr, ItrTy EndItr) {
   assert(BeginItr != EndItr &&
     "At least one node must be in a iterator range!");
-  using STRTy = SpanningTreeRelation<GraphType>;
   using GT = llvm::GraphTraits<GraphType>;
   using IGT = llvm::GraphTraits<llvm::Inverse<GraphType>>;
   using NodeRef = typename IGT::NodeRef;
   static_assert(std::is_assignable<typename GT::NodeRef, NodeRef>::value ||
     std::is_convertible<NodeRef, typename GT::NodeRef>::value,
     "NodeRef of a graph must be assignable from NodeRef of an inverse graph!");
-  auto Parent = findParent(*BeginItr, STR);
-  if (!Parent.hasValue())
-    return llvm::None;
-  NodeRef LCA = *Parent;
-  auto CurrItr = BeginItr;
-  for (++CurrItr; CurrItr != EndItr; ++CurrItr) {
-    auto R = STR.compare(LCA, *CurrItr);
-    for (; R == TR_UNREACHABLE || R == TR_EQUAL;
-           R = STR.compare(LCA, *CurrItr)) {
-      auto Parent = findParent(LCA, STR);
-      if (!Parent.hasValue())
-        return llvm::None;
-      LCA = *Parent;
-    }
-    switch (R) {
-    case TR_ANCESTOR: break;
-    case TR_DESCENDANT:
-      auto Parent = findParent(*CurrItr, STR);
-      if (!Parent.hasValue())
+  auto LCA = STR.getId(STR.getLCA(BeginItr, EndItr));
+  // The result must not be equal to any node from the range.
+  for (auto I = BeginItr; I != EndItr; ++I) {
+    typename GT::NodeRef N = *I;
+    if (N == STR.getNode(LCA)) {
+      auto Parent = STR.getParent(LCA);
+      if (Parent == LCA)
         return llvm::None;
-      LCA = *Parent;
+      LCA = Parent;
       break;
     }
   }
-  return LCA;
+  return detail::getInverseNode(STR.getGraph(), STR.getNode(LCA));
 }
 }
 #endif//TSAR_SPANNING_TREE_RELATION_H
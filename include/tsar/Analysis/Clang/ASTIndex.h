@@ -0,0 +1,101 @@
+//===--- ASTIndex.h ------- Index of Function AST ---------------*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2020 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines a pass which traverses AST of a function once and
+// collects entities (statements and calls) which are necessary for other
+// Clang-based analysis passes.
+// So, these passes may iterate over lists of entities instead of separate
+// traversals of the same AST.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef TSAR_CLANG_AST_INDEX_H
+#define TSAR_CLANG_AST_INDEX_H
+
+#include "tsar/Analysis/Clang/Passes.h"
+#include <bcl/utility.h>
+#include <llvm/Pass.h>
+#include <vector>
+
+namespace clang {
+class CallExpr;
+class Decl;
+class Stmt;
+}
+
+namespace tsar {
+/// \brief Index of AST entities of a function.
+///
+/// Each list contains entities in order of their visitation by a default
+/// clang::RecursiveASTVisitor (a node is visited before its children).
+/// So, a visitor which does not override Traverse...() methods may iterate
+/// over an appropriate list instead of the whole AST traversal.
+class ClangASTIndex {
+public:
+  using StmtList = std::vector<clang::Stmt *>;
+  using CallList = std::vector<clang::CallExpr *>;
+
+  /// Traverses a specified declaration and builds index (previous contents
+  /// of index are discarded).
+  void build(clang::Decl &D);
+
+  /// Removes all entities from the index.
+  void clear() {
+    mStmts.clear();
+    mCalls.clear();
+  }
+
+  /// Returns all statements (including expressions).
+  const StmtList & getStmts() const noexcept { return mStmts; }
+
+  /// Returns call expressions.
+  const CallList & getCalls() const noexcept { return mCalls; }
+
+private:
+  StmtList mStmts;
+  CallList mCalls;
+};
+}
+
+namespace llvm {
+/// This per-function pass builds index of AST entities for a function.
+class ClangASTIndexPass : public FunctionPass, private bcl::Uncopyable {
+public:
+  static char ID;
+
+  ClangASTIndexPass() : FunctionPass(ID) {
+    initializeClangASTIndexPassPass(*PassRegistry::getPassRegistry());
+  }
+
+  bool runOnFunction(Function &F) override;
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override;
+
+  void releaseMemory() override { mIndex.clear(); }
+
+  /// Returns index of the analyzed function (it is empty if AST is not
+  /// available).
+  const tsar::ClangASTIndex & getIndex() const noexcept { return mIndex; }
+
+private:
+  tsar::ClangASTIndex mIndex;
+};
+}
+#endif//TSAR_CLANG_AST_INDEX_H
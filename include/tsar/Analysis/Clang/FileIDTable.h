@@ -0,0 +1,80 @@
+//===--- FileIDTable.h ---- Table of Source Files ---------------*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2020 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines a pass which owns a table of source files shared
+// between high and low level matchers.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef TSAR_CLANG_FILE_ID_TABLE_H
+#define TSAR_CLANG_FILE_ID_TABLE_H
+
+#include "tsar/Analysis/Clang/Matcher.h"
+#include "tsar/Analysis/Clang/Passes.h"
+#include <bcl/utility.h>
+#include <llvm/Pass.h>
+
+namespace llvm {
+/// This immutable pass owns a table of source files, so the table is shared
+/// between matchers of all functions in a module.
+///
+/// The table refers to metadata of a module and to names of files owned by
+/// a source manager, so it is cleared at the end of each run of a pass
+/// manager. Hence, the table never refers to a module which has been
+/// destroyed after the previous run, even if a new module is allocated at
+/// the same address.
+class ClangFileIDTablePass : public ImmutablePass, private bcl::Uncopyable {
+public:
+  static char ID;
+
+  ClangFileIDTablePass() : ImmutablePass(ID) {
+    initializeClangFileIDTablePassPass(*PassRegistry::getPassRegistry());
+  }
+
+  /// Returns a table of files for a specified module. The table is cleared
+  /// if a module or a source manager differs from the previous request.
+  tsar::FileIDTable & getTable(const Module &M,
+      const clang::SourceManager &SrcMgr) {
+    if (mModule != &M || mSrcMgr != &SrcMgr) {
+      mTable.clear();
+      mModule = &M;
+      mSrcMgr = &SrcMgr;
+    }
+    return mTable;
+  }
+
+  bool doFinalization(Module &M) override {
+    releaseMemory();
+    return false;
+  }
+
+  void releaseMemory() override {
+    mTable.clear();
+    mModule = nullptr;
+    mSrcMgr = nullptr;
+  }
+
+private:
+  tsar::FileIDTable mTable;
+  const Module *mModule = nullptr;
+  const clang::SourceManager *mSrcMgr = nullptr;
+};
+}
+#endif//TSAR_CLANG_FILE_ID_TABLE_H
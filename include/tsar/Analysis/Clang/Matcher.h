@@ -31,16 +31,138 @@
 #include "tsar/ADT/Bimap.h"
 #include "tsar/Support/Tags.h"
 #include "tsar/Support/MetadataUtils.h"
+#include <bcl/utility.h>
 #include <clang/Basic/SourceManager.h>
 #include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/Hashing.h>
 #include <llvm/ADT/SmallString.h>
 #include <llvm/ADT/Statistic.h>
+#include <llvm/ADT/StringMap.h>
 #include <llvm/ADT/TinyPtrVector.h>
 #include <llvm/IR/DebugInfoMetadata.h>
 #include <llvm/Support/Path.h>
 #include <set>
 
+namespace tsar {
+/// Location in a source file, the file is identified with FileIDTable.
+struct FileLocation {
+  unsigned File;
+  unsigned Line;
+  unsigned Column;
+};
+
+inline bool operator==(const FileLocation &LHS, const FileLocation &RHS) {
+  return LHS.File == RHS.File && LHS.Line == RHS.Line &&
+    LHS.Column == RHS.Column;
+}
+
+inline bool operator!=(const FileLocation &LHS, const FileLocation &RHS) {
+  return !(LHS == RHS);
+}
+
+/// \brief Table of source files which interns each file to a small integer.
+///
+/// Files of locations from metadata and from Clang AST are identified by
+/// absolute native paths. This table computes a path only once for each
+/// file, so comparison of files in matchers reduces to comparison of integers.
+///
+/// Metadata-level files are uniqued in a context, so they are not freed while
+/// a module is alive. Names of files from Clang are owned by a source manager.
+/// So, a table should not outlive a module and a source manager which have
+/// been used to fill it.
+class FileIDTable : private bcl::Uncopyable {
+public:
+  /// Returns ID of a file a specified scope belongs to.
+  unsigned getID(const llvm::DIScope &Scope) {
+    auto *File = Scope.getFile();
+    auto Itr = mFiles.find(File);
+    if (Itr != mFiles.end())
+      return Itr->second;
+    llvm::SmallString<128> Path;
+    auto ID = getPathID(getAbsolutePath(Scope, Path));
+    mFiles.try_emplace(File, ID);
+    return ID;
+  }
+
+  /// Returns ID of a file a specified location belongs to.
+  unsigned getID(const clang::PresumedLoc &PLoc) {
+    assert(PLoc.isValid() && "Location must be valid!");
+    // Names of files are stored in a source manager, so the same pointer is
+    // returned for all locations from a file.
+    auto Itr = mNames.find(PLoc.getFilename());
+    if (Itr != mNames.end())
+      return Itr->second;
+    llvm::SmallString<128> Path;
+    auto ID = getPathID(getNativePath(PLoc.getFilename(), Path));
+    mNames.try_emplace(PLoc.getFilename(), ID);
+    return ID;
+  }
+
+  /// Returns a specified location with an interned file.
+  FileLocation getLocation(const llvm::DILocation &Loc) {
+    return { getID(*Loc.getScope()), Loc.getLine(), Loc.getColumn() };
+  }
+
+  /// Returns a specified location with an interned file.
+  FileLocation getLocation(const clang::PresumedLoc &PLoc) {
+    return { getID(PLoc), PLoc.getLine(), PLoc.getColumn() };
+  }
+
+  /// Removes all files from the table.
+  void clear() {
+    mFiles.clear();
+    mNames.clear();
+    mPaths.clear();
+  }
+
+private:
+  unsigned getPathID(llvm::StringRef Path) {
+    return mPaths.try_emplace(Path, mPaths.size()).first->second;
+  }
+
+  llvm::DenseMap<const llvm::DIFile *, unsigned> mFiles;
+  llvm::DenseMap<const char *, unsigned> mNames;
+  llvm::StringMap<unsigned> mPaths;
+};
+
+/// Returns true if specified scopes belong to the same file.
+inline bool isSameFile(const llvm::DIScope &LHS, const llvm::DIScope &RHS) {
+  // Files are uniqued, so the same file is usually represented with the
+  // same metadata.
+  if (&LHS == &RHS || LHS.getFile() == RHS.getFile())
+    return true;
+  llvm::SmallString<128> LHSPath, RHSPath;
+  return getAbsolutePath(LHS, LHSPath) == getAbsolutePath(RHS, RHSPath);
+}
+
+/// Returns true if a specified location and scope belong to the same file.
+inline bool isSameFile(const clang::PresumedLoc &LHS,
+    const llvm::DIScope &RHS) {
+  llvm::SmallString<128> LHSPath, RHSPath;
+  return getNativePath(LHS.getFilename(), LHSPath) ==
+    getAbsolutePath(RHS, RHSPath);
+}
+}
+
 namespace llvm {
+template<> struct DenseMapInfo<tsar::FileLocation> {
+  static inline tsar::FileLocation getEmptyKey() {
+    auto Key = DenseMapInfo<unsigned>::getEmptyKey();
+    return { Key, Key, Key };
+  }
+  static inline tsar::FileLocation getTombstoneKey() {
+    auto Key = DenseMapInfo<unsigned>::getTombstoneKey();
+    return { Key, Key, Key };
+  }
+  static unsigned getHashValue(const tsar::FileLocation &Loc) {
+    return hash_combine(Loc.File, Loc.Line, Loc.Column);
+  }
+  static bool isEqual(const tsar::FileLocation &LHS,
+      const tsar::FileLocation &RHS) {
+    return LHS == RHS;
+  }
+};
+
 /// \brief Implementation of a DenseMapInfo for DILocation *.
 ///
 /// To generate hash value pair of line and column is used. It is possible to
@@ -67,22 +189,18 @@ struct DILocationMapInfo {
   static bool isEqual(const DILocation *LHS, const DILocation *RHS) {
     auto TK = getTombstoneKey();
     auto EK = getEmptyKey();
-    llvm::SmallString<128> LHSPath, RHSPath;
     return LHS == RHS ||
       RHS != TK && LHS != TK && RHS != EK && LHS != EK &&
       LHS->getLine() == RHS->getLine() &&
       LHS->getColumn() == RHS->getColumn() &&
-      tsar::getAbsolutePath(*LHS->getScope(), LHSPath) ==
-        tsar::getAbsolutePath(*RHS->getScope(), RHSPath);
+      tsar::isSameFile(*LHS->getScope(), *RHS->getScope());
   }
   static bool isEqual(const clang::PresumedLoc &LHS, const DILocation *RHS) {
-    llvm::SmallString<128> LHSPath, RHSPath;
     return !isEqual(RHS, getTombstoneKey()) &&
       !isEqual(RHS, getEmptyKey()) &&
       LHS.getLine() == RHS->getLine() &&
       LHS.getColumn() == RHS->getColumn() &&
-      tsar::getNativePath(LHS.getFilename(), LHSPath) ==
-      tsar::getAbsolutePath(*RHS->getScope(), RHSPath);
+      tsar::isSameFile(LHS, *RHS->getScope());
   }
 };
 }
@@ -94,8 +212,8 @@ namespace tsar {
 /// \tparam IRPtrTy Pointer to IR entity.
 /// \tparam ASTPtrTy Pointer to AST entity.
 template<class IRPtrTy, class ASTPtrTy,
-  class IRLocationTy = llvm::DILocation *,
-  class IRLocationMapInfo = llvm::DILocationMapInfo,
+  class IRLocationTy = FileLocation,
+  class IRLocationMapInfo = llvm::DenseMapInfo<IRLocationTy>,
   class ASTLocationTy = unsigned,
   class ASTLocationMapInfo = llvm::DenseMapInfo<ASTLocationTy>,
   class MatcherTy = Bimap<
@@ -122,6 +240,8 @@ public:
   /// \brief Constructor.
   ///
   /// \param[in] SrcMgr Clang source manager to deal with locations.
+  /// \param[in, out] Files Table of files which is used to build keys in
+  /// LocToIR map.
   /// \param[in, out] M Representation of match.
   /// \param[in, out] UM Storage for unmatched ast entities.
   /// \param[in, out] LocToIR Map from entity location to a queue
@@ -130,9 +250,9 @@ public:
   /// of AST entities. All entities explicitly (not implicit loops) defined in
   /// macros is going to store in this map. The key in this map is a raw
   /// encoding for expansion location.
-  MatchASTBase(clang::SourceManager &SrcMgr, Matcher &M, UnmatchedASTSet &UM,
-    LocToIRMap &LocToIR, LocToASTMap &LocToMacro) :
-    mSrcMgr(&SrcMgr), mMatcher(&M), mUnmatchedAST(&UM),
+  MatchASTBase(clang::SourceManager &SrcMgr, FileIDTable &Files, Matcher &M,
+    UnmatchedASTSet &UM, LocToIRMap &LocToIR, LocToASTMap &LocToMacro) :
+    mSrcMgr(&SrcMgr), mFiles(&Files), mMatcher(&M), mUnmatchedAST(&UM),
     mLocToIR(&LocToIR), mLocToMacro(&LocToMacro) {}
 
   /// Finds low-level representation of an entity at the specified location.
@@ -154,7 +274,9 @@ public:
     if (Loc.isInvalid())
       return mLocToIR->end();
     auto PLoc = mSrcMgr->getPresumedLoc(Loc, false);
-    return mLocToIR->find_as(PLoc);
+    if (PLoc.isInvalid())
+      return mLocToIR->end();
+    return mLocToIR->find(mFiles->getLocation(PLoc));
   }
 
   /// Evaluates entities located in macros.
@@ -167,7 +289,8 @@ public:
     for (auto &InMacro : *mLocToMacro) {
       clang:: PresumedLoc PLoc = mSrcMgr->getPresumedLoc(
         clang::SourceLocation::getFromRawEncoding(InMacro.first), false);
-      auto IREntityItr = mLocToIR->find_as(PLoc);
+      auto IREntityItr = PLoc.isValid() ?
+        mLocToIR->find(mFiles->getLocation(PLoc)) : mLocToIR->end();
       // If sizes of queues of AST and IR entities are not equal this is mean
       // that there are implicit entities (for example, implicit loops) in
       // a macro. Such entities are not going to be evaluated due to necessity
@@ -193,6 +316,7 @@ public:
 
 protected:
   clang::SourceManager *mSrcMgr;
+  FileIDTable *mFiles;
   Matcher *mMatcher;
   UnmatchedASTSet *mUnmatchedAST;
   LocToIRMap *mLocToIR;
@@ -78,6 +78,15 @@ void initializeClangDIGlobalMemoryMatcherPassPass(PassRegistry &Registry);
 /// and appropriate metadata-level representations of variables.
 ModulePass *createDIGlobalMemoryMatcherPass();
 
+/// Initialize a pass which builds index of AST entities for a function.
+void initializeClangASTIndexPassPass(PassRegistry &Registry);
+
+/// Initialize a pass which owns a table of source files used by matchers.
+void initializeClangFileIDTablePassPass(PassRegistry &Registry);
+
+/// Create a pass which builds index of AST entities for a function.
+FunctionPass * createClangASTIndexPass();
+
 /// Initialize a pass to match high-level and low-level expressions.
 void initializeClangExprMatcherPassPass(PassRegistry &Registry);
 
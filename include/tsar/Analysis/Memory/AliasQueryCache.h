@@ -0,0 +1,191 @@
+//===--- AliasQueryCache.h - Memoized Alias Queries -------------*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2020 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines a front-end for alias analysis which memoizes results of
+// alias and mod/ref queries. The same pairs of locations are queried many
+// times while an alias tree is built and analyzed.
+//
+// A cache is owned by an alias tree and its lifetime is bound to the tree.
+// Alias trees are rebuilt after transformations of IR and existing trees
+// are never updated, so memoized results do not outlive IR they describe.
+//
+// Alias relations between global objects do not depend on a function, so
+// they are memoized once per module and are shared between functions. Alias
+// trees may be built with different alias analyses at different stages, so
+// relations are shared only between trees which are built by the same pass
+// (a scope of relations). Relations are also invalidated at pass barriers
+// (see createGlobalAliasCacheInvalidator()).
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef TSAR_ALIAS_QUERY_CACHE_H
+#define TSAR_ALIAS_QUERY_CACHE_H
+
+#include "tsar/Support/AnalysisWrapperPass.h"
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/Optional.h>
+#include <llvm/Analysis/AliasAnalysis.h>
+#include <llvm/Analysis/MemoryLocation.h>
+#include <llvm/IR/Constant.h>
+#include <llvm/IR/ValueHandle.h>
+#include <utility>
+
+namespace llvm {
+class CallBase;
+class Instruction;
+}
+
+namespace tsar {
+/// \brief Module-level storage of alias relations between locations which are
+/// addressed by constants (global objects and constant expressions).
+///
+/// Relations are grouped into scopes, each scope contains relations which
+/// have been computed with the same alias analysis. A client must create
+/// its own scope with createScope().
+///
+/// Constant expressions may be destroyed by transformations and a new
+/// constant may be allocated at the same address. So, addresses of constants
+/// are tracked with value handles and a relation is ignored if any of its
+/// constants has been destroyed.
+class GlobalAliasCache {
+public:
+  /// Identifier of a group of relations, 0 is not a valid scope.
+  using ScopeId = unsigned;
+
+private:
+  using LocationPair = std::pair<llvm::MemoryLocation, llvm::MemoryLocation>;
+  using ScopedPair = std::pair<ScopeId, LocationPair>;
+
+  struct AliasInfo {
+    llvm::AliasResult Result;
+    llvm::WeakVH LHS;
+    llvm::WeakVH RHS;
+  };
+public:
+  /// Returns true if alias relation of a specified locations can be stored
+  /// in this cache.
+  static bool isGlobal(const llvm::MemoryLocation &LHS,
+      const llvm::MemoryLocation &RHS) {
+    return llvm::isa<llvm::Constant>(LHS.Ptr) &&
+      llvm::isa<llvm::Constant>(RHS.Ptr);
+  }
+
+  /// Creates a new scope of relations.
+  ScopeId createScope() noexcept { return ++mLastScope; }
+
+  /// Returns a stored alias relation between specified locations.
+  llvm::Optional<llvm::AliasResult> find(ScopeId Scope,
+      const llvm::MemoryLocation &LHS, const llvm::MemoryLocation &RHS) const {
+    auto I = mAliases.find(std::make_pair(Scope, std::make_pair(LHS, RHS)));
+    if (I == mAliases.end() || I->second.LHS != LHS.Ptr ||
+        I->second.RHS != RHS.Ptr)
+      return llvm::None;
+    return I->second.Result;
+  }
+
+  /// Stores alias relation between specified locations.
+  void insert(ScopeId Scope, const llvm::MemoryLocation &LHS,
+      const llvm::MemoryLocation &RHS, llvm::AliasResult AR) {
+    assert(Scope != 0 && "Scope must be valid!");
+    assert(isGlobal(LHS, RHS) && "Locations must be addressed by constants!");
+    AliasInfo Info{AR, const_cast<llvm::Value *>(LHS.Ptr),
+                   const_cast<llvm::Value *>(RHS.Ptr)};
+    // Note, that a relation between destroyed constants may be overwritten.
+    auto Pair = mAliases.try_emplace(
+      std::make_pair(Scope, std::make_pair(LHS, RHS)), Info);
+    if (!Pair.second)
+      Pair.first->second = std::move(Info);
+  }
+
+  /// Returns number of stored relations.
+  unsigned size() const { return mAliases.size(); }
+
+  /// Removes all stored relations, this must be called if IR has been changed.
+  void invalidate() { mAliases.clear(); }
+
+private:
+  llvm::DenseMap<ScopedPair, AliasInfo> mAliases;
+  ScopeId mLastScope = 0;
+};
+
+/// \brief Memoizing front-end for llvm::AAResults.
+///
+/// There is no way to invalidate results, so a cache must be destroyed
+/// if IR has been changed.
+class AliasQueryCache {
+public:
+  explicit AliasQueryCache(llvm::AAResults &AA) noexcept : mAA(&AA) {}
+
+  /// Returns the underlying alias analysis.
+  llvm::AAResults & getAliasAnalysis() const noexcept { return *mAA; }
+
+  /// Specifies a module-level cache which is used to memoize alias relations
+  /// between global objects and a scope of relations in this cache.
+  void setGlobalCache(GlobalAliasCache *GC,
+      GlobalAliasCache::ScopeId Scope) noexcept {
+    assert((!GC || Scope != 0) && "Scope must be valid!");
+    mGlobalCache = GC;
+    mGlobalScope = Scope;
+  }
+
+  /// Returns a module-level cache or nullptr if it is not set.
+  GlobalAliasCache * getGlobalCache() const noexcept { return mGlobalCache; }
+
+  /// Returns alias relation between two specified locations.
+  llvm::AliasResult alias(const llvm::MemoryLocation &LHS,
+    const llvm::MemoryLocation &RHS);
+
+  /// Returns alias relation between two specified locations.
+  llvm::AliasResult alias(const llvm::Value *LHSPtr, llvm::LocationSize LHSSize,
+      const llvm::Value *RHSPtr, llvm::LocationSize RHSSize) {
+    return alias(llvm::MemoryLocation(LHSPtr, LHSSize),
+                 llvm::MemoryLocation(RHSPtr, RHSSize));
+  }
+
+  /// Returns information about whether a specified instruction may access
+  /// a specified location.
+  llvm::ModRefInfo getModRefInfo(const llvm::Instruction *I,
+    const llvm::MemoryLocation &Loc);
+
+  /// Returns information about whether a call may access memory
+  /// accessed by other call.
+  llvm::ModRefInfo getModRefInfo(const llvm::CallBase *Call1,
+    const llvm::CallBase *Call2);
+
+private:
+  using LocationPair = std::pair<llvm::MemoryLocation, llvm::MemoryLocation>;
+  using InstLocationPair =
+    std::pair<const llvm::Instruction *, llvm::MemoryLocation>;
+  using CallPair = std::pair<const llvm::CallBase *, const llvm::CallBase *>;
+
+  llvm::AAResults *mAA;
+  GlobalAliasCache *mGlobalCache = nullptr;
+  GlobalAliasCache::ScopeId mGlobalScope = 0;
+  llvm::DenseMap<LocationPair, llvm::AliasResult> mAliasCache;
+  llvm::DenseMap<InstLocationPair, llvm::ModRefInfo> mModRefCache;
+  llvm::DenseMap<CallPair, llvm::ModRefInfo> mCallModRefCache;
+};
+}
+
+namespace llvm {
+/// Wrapper to access alias relations between global objects.
+using GlobalAliasCacheWrapper = AnalysisWrapperPass<tsar::GlobalAliasCache>;
+}
+#endif//TSAR_ALIAS_QUERY_CACHE_H
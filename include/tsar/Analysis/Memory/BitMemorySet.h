@@ -0,0 +1,205 @@
+//===- BitMemorySet.h ---- Dense Memory Location Set -------------*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2018 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines a set of memory locations which uses bit vectors to
+// represent locations which can not partially overlap each other. A numbering
+// of locations (memory universe) must be built before sets are constructed.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef TSAR_BIT_MEMORY_SET_H
+#define TSAR_BIT_MEMORY_SET_H
+
+#include "tsar/Analysis/Memory/MemorySet.h"
+#include <llvm/ADT/BitVector.h>
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/Optional.h>
+#include <vector>
+
+namespace tsar {
+/// \brief Numbering of memory locations accessed in a function.
+///
+/// A location obtains a number if it is the only location with a specified
+/// base pointer, so it can not partially overlap other locations from the
+/// universe. All the other locations are not numbered.
+///
+/// Locations should be registered with insert() and then finalize()
+/// should be called. Numbers are available after that.
+template<class LocationTy, class MemoryInfo = MemorySetInfo<LocationTy>>
+class MemoryUniverse {
+  /// Description of locations with the same base pointer.
+  struct PointerInfo {
+    explicit PointerInfo(const LocationTy &L) : Loc(L) {}
+    LocationTy Loc;
+    unsigned Id = 0;
+    bool IsUnique = true;
+  };
+public:
+  /// Registers a location in the universe.
+  void insert(const LocationTy &Loc) {
+    assert(!mIsFinalized && "Universe must not be finalized!");
+    auto Pair = mPointers.try_emplace(MemoryInfo::getPtr(Loc), Loc);
+    if (!Pair.second && !(Pair.first->second.Loc == Loc))
+      Pair.first->second.IsUnique = false;
+  }
+
+  /// Registers all locations from a specified range in the universe.
+  template<class location_iterator>
+  void insert(const location_iterator &I, const location_iterator &E) {
+    for (auto Itr = I; Itr != E; ++Itr)
+      insert(*Itr);
+  }
+
+  /// Assigns numbers to locations, the universe can not be changed after that.
+  void finalize() {
+    assert(!mIsFinalized && "Universe has been already finalized!");
+    for (auto &Pair : mPointers)
+      if (Pair.second.IsUnique) {
+        Pair.second.Id = mLocations.size();
+        mLocations.push_back(Pair.second.Loc);
+      }
+    mIsFinalized = true;
+  }
+
+  /// Returns true if numbers have been already assigned to locations.
+  bool isFinalized() const noexcept { return mIsFinalized; }
+
+  /// Returns number of numbered locations.
+  unsigned size() const { return mLocations.size(); }
+
+  /// Returns number of a location with a specified base pointer if it exists.
+  llvm::Optional<unsigned> getId(const llvm::Value *Ptr) const {
+    assert(mIsFinalized && "Universe must be finalized!");
+    auto I = mPointers.find(Ptr);
+    if (I == mPointers.end() || !I->second.IsUnique)
+      return llvm::None;
+    return I->second.Id;
+  }
+
+  /// Returns a location with a specified number.
+  const LocationTy & getLocation(unsigned Id) const {
+    assert(Id < mLocations.size() && "Number is out of range!");
+    return mLocations[Id];
+  }
+private:
+  llvm::DenseMap<const llvm::Value *, PointerInfo> mPointers;
+  std::vector<LocationTy> mLocations;
+  bool mIsFinalized = false;
+};
+
+/// \brief This implements a set of memory locations from a specified universe.
+///
+/// Numbered locations are stored in a bit vector, so union and difference
+/// of sets are word-parallel operations. Other locations are stored in
+/// MemorySet which takes into account partially overlapped locations.
+///
+/// \attention All locations which are inserted in the set must be registered
+/// in the universe. The universe must outlive the set.
+template<class LocationTy, class MemoryInfo = MemorySetInfo<LocationTy>>
+class BitMemorySet {
+public:
+  using UniverseTy = MemoryUniverse<LocationTy, MemoryInfo>;
+  using SparseSetTy = MemorySet<LocationTy, MemoryInfo>;
+
+  /// Creates an empty set of locations from a specified universe.
+  explicit BitMemorySet(const UniverseTy &U) :
+      mUniverse(&U), mDense(U.size()) {
+    assert(U.isFinalized() && "Universe must be finalized!");
+  }
+
+  /// Returns universe of locations.
+  const UniverseTy & getUniverse() const noexcept { return *mUniverse; }
+
+  /// Returns numbered locations from this set.
+  const llvm::BitVector & getDenseLocations() const noexcept { return mDense; }
+
+  /// Returns locations from this set which have no numbers.
+  const SparseSetTy & getSparseLocations() const noexcept { return mSparse; }
+
+  /// Returns true if there are no locations in the set.
+  bool empty() const { return mDense.none() && mSparse.empty(); }
+
+  /// Removes all locations from this set.
+  void clear() {
+    mDense.reset();
+    mSparse.clear();
+  }
+
+  /// Inserts a new location into this set, returns false if nothing has been
+  /// added or updated.
+  bool insert(const LocationTy &Loc) {
+    if (auto Id = mUniverse->getId(MemoryInfo::getPtr(Loc))) {
+      assert(mUniverse->getLocation(*Id) == Loc &&
+        "Location must be registered in the universe!");
+      if (mDense.test(*Id))
+        return false;
+      mDense.set(*Id);
+      return true;
+    }
+    return mSparse.insert(Loc).second;
+  }
+
+  /// Inserts numbered locations which are specified by a bit vector.
+  void insert(const llvm::BitVector &Locs) {
+    assert(Locs.size() == mDense.size() && "Universe must be the same!");
+    mDense |= Locs;
+  }
+
+  /// Removes numbered locations which are specified by a bit vector.
+  void reset(const llvm::BitVector &Locs) {
+    assert(Locs.size() == mDense.size() && "Universe must be the same!");
+    mDense.reset(Locs);
+  }
+
+  /// Realizes merger between two sets, returns false if nothing has been
+  /// added or updated.
+  bool merge(const BitMemorySet &With) {
+    assert(mUniverse == With.mUniverse && "Universe must be the same!");
+    if (this == &With)
+      return false;
+    bool IsChanged = With.mDense.test(mDense);
+    mDense |= With.mDense;
+    return mSparse.merge(With.mSparse) || IsChanged;
+  }
+
+  /// Converts this set to a set without numbered locations.
+  SparseSetTy materialize() const {
+    SparseSetTy Result(mSparse);
+    for (unsigned Id : mDense.set_bits())
+      Result.insert(mUniverse->getLocation(Id));
+    return Result;
+  }
+
+  /// Compares two sets.
+  bool operator==(const BitMemorySet &RHS) const {
+    assert(mUniverse == RHS.mUniverse && "Universe must be the same!");
+    return mDense == RHS.mDense && mSparse == RHS.mSparse;
+  }
+
+  /// Compares two sets.
+  bool operator!=(const BitMemorySet &RHS) const { return !(*this == RHS); }
+
+private:
+  const UniverseTy *mUniverse;
+  llvm::BitVector mDense;
+  SparseSetTy mSparse;
+};
+}
+#endif//TSAR_BIT_MEMORY_SET_H
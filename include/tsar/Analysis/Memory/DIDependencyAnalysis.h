@@ -45,6 +45,7 @@ class MDNode;
 }
 
 namespace tsar {
+class AliasNode;
 class AliasTree;
 class BitMemoryTrait;
 class DIAliasMemoryNode;
@@ -151,7 +152,9 @@ private:
   /// Descendant alias node must be already analyzed. This method use results
   /// of IR-level dependence analysis (including variable privatization) and
   /// results of analysis of promoted memory locations.
-  void analyzeNode(tsar::DIAliasMemoryNode &DIN, Optional<unsigned> DWLang,
+  /// \param [in] AN IR-level alias node which is bound to DIN or nullptr.
+  void analyzeNode(tsar::DIAliasMemoryNode &DIN, tsar::AliasNode *AN,
+    Optional<unsigned> DWLang,
     const tsar::SpanningTreeRelation<tsar::AliasTree *> &AliasSTR,
     const tsar::SpanningTreeRelation<const tsar::DIAliasTree *> &DIAliasSTR,
     ArrayRef<const tsar::DIMemory *> LockedTraits,
@@ -28,6 +28,7 @@
 #define TSAR_DI_ESTIMATE_MEMORY_H
 
 #include "tsar/ADT/DenseMapTraits.h"
+#include "tsar/ADT/SpanningTreeRelation.h"
 #include "tsar/Analysis/Memory/Passes.h"
 #include "tsar/Analysis/Memory/DIMemoryLocation.h"
 #include "tsar/Analysis/Memory/DIMemoryEnvironment.h"
@@ -224,10 +225,10 @@ public:
   void bindValue(const ItrTy &I, const ItrTy &E) { mValues.append(I, E); }
 
   /// Returns `true` if there is memory handle associated with this memory.
-  bool hasMemoryHandle() const {  return mEnv.getInt(); }
+  bool hasMemoryHandle() const noexcept { return mHandles; }
 
   /// Returns debug-level memory environment.
-  DIMemoryEnvironment & getEnv() { return *mEnv.getPointer(); }
+  DIMemoryEnvironment & getEnv() { return *mEnv; }
 
   /// Change all uses of this to point to a new memory.
   void replaceAllUsesWith(DIMemory *M);
@@ -237,7 +238,7 @@ protected:
   /// which is represented as a metadata.
   explicit DIMemory(DIMemoryEnvironment &Env, Kind K, llvm::MDNode *MD,
       DIAliasMemoryNode *N = nullptr) :
-    mEnv(&Env, false), mKind(K), mMD(MD), mNode(N) {}
+    mKind(K), mEnv(&Env), mMD(MD), mNode(N) {}
 
   /// Returns flags which are specified for an underlying memory location.
   uint64_t getFlags() const;
@@ -255,11 +256,15 @@ private:
   /// Add this location to a specified node `N` in alias tree.
   void setAliasNode(DIAliasMemoryNode &N) noexcept { mNode = &N; }
 
-  /// Updates a flag that indicates existence of memory handles.
-  void setHasMemoryHandle(bool Value) { mEnv.setInt(Value); }
-
   Kind mKind;
-  llvm::PointerIntPair<DIMemoryEnvironment *, 1, bool> mEnv;
+  DIMemoryEnvironment *mEnv;
+
+  /// \brief Head of a list of handles which point to this memory.
+  ///
+  /// The list is stored in the memory itself, so insertion and removal of
+  /// handles do not look up any map. Memory objects are never moved, hence
+  /// handles may safely point to this member.
+  DIMemoryHandleBase *mHandles = nullptr;
   Property mProperties = NoProperty;
   llvm::MDNode *mMD;
   DIAliasMemoryNode *mNode;
@@ -551,6 +556,13 @@ public:
   /// Returns true in constant time if this node is a leaf.
   bool child_empty() const { return mChildren.empty(); }
 
+  /// Returns identifier of this node in the last built spanning tree of
+  /// an alias tree (see SpanningTreeRelation).
+  unsigned getSpanningTreeId() const noexcept { return mSpanningTreeId; }
+
+  /// Remembers identifier of this node in a spanning tree.
+  void setSpanningTreeId(unsigned Id) const noexcept { mSpanningTreeId = Id; }
+
 protected:
   friend class DIAliasMemoryNode;
 
@@ -568,6 +580,7 @@ protected:
   Kind mKind;
   DIAliasNode *mParent = nullptr;
   ChildList mChildren;
+  mutable unsigned mSpanningTreeId = 0;
 };
 
 /// This represents a root of an alias tree.
@@ -866,6 +879,20 @@ private:
   DIMemorySet mFragments;
   llvm::Function *mFunc;
 };
+
+/// Alias nodes store their identifiers in a spanning tree of an alias tree.
+template<> struct SpanningTreeNodeTraits<const DIAliasNode *> {
+  static constexpr bool HasId = true;
+  static unsigned getId(const DIAliasNode *N) noexcept {
+    return N->getSpanningTreeId();
+  }
+  static void setId(const DIAliasNode *N, unsigned Id) noexcept {
+    N->setSpanningTreeId(Id);
+  }
+};
+
+template<> struct SpanningTreeNodeTraits<DIAliasNode *> :
+  public SpanningTreeNodeTraits<const DIAliasNode *> {};
 }
 
 namespace llvm {
@@ -71,13 +71,10 @@ public:
   ~DIMemoryEnvironment() {
     // It is not possible to delete handles here, because a handle may not be
     // a dynamic object. So, we only check that there is no active handles.
-    assert(mMemoryHandles.empty() &&
+    assert(mNumHandledMemory == 0 &&
       "Memory handles must be deleted before environmment!");
   }
 
-  /// Map from a memory to list of handles.
-  using DIMemoryHandleMap = llvm::DenseMap<DIMemory *, DIMemoryHandleBase *>;
-
   /// Resets alias tree for a specified function with a specified alias tree
   /// and returns pointer to a new tree.
   DIAliasTree * reset(llvm::Function &F, std::unique_ptr<DIAliasTree> &&AT) {
@@ -113,19 +110,17 @@ public:
   /// Returns alias tree for a specified function or nullptr.
   DIAliasTree * operator[](llvm::Function &F) const { return get(F); }
 
-  /// Returns all available memory handles.
-  DIMemoryHandleMap & getMemoryHandles() noexcept {
-    return mMemoryHandles;
-  }
-
-  /// Returns memory handles for a specified memory location.
-  DIMemoryHandleBase *& operator[](DIMemory *M)  {
-    return mMemoryHandles[M];
-  }
+  /// Returns number of memory locations which have active handles.
+  unsigned getNumHandledMemory() const noexcept { return mNumHandledMemory; }
 
 private:
+  friend class DIMemoryHandleBase;
+
   FunctionToTreeMap mTrees;
-  DIMemoryHandleMap mMemoryHandles;
+
+  /// Number of memory locations with active handles, lists of handles
+  /// are stored in memory locations.
+  unsigned mNumHandledMemory = 0;
 };
 }
 
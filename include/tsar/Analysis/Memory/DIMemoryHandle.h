@@ -114,8 +114,8 @@ private:
   /// \brief Returns pointer to a pointer to this handle.
   ///
   /// This pointer is pointed either to the mNext member of a previous handle
-  /// of underlying memory or to the pointer in a container of handles map
-  /// which points to the first handle of underlying memory.
+  /// of underlying memory or to the head of a list which is stored in
+  /// underlying memory and points to the first handle of this memory.
   DIMemoryHandleBase **getPrevPtr() const { return mPrevPair.getPointer(); }
 
   /// Returns kind of this handle.
@@ -56,6 +56,7 @@ void initializeDependenceAnalysisWrapperPassPass(PassRegistry &Registry);
 namespace tsar {
 class AliasTree;
 class DelinearizeInfo;
+class DependenceShapeCache;
 class DFRegionInfo;
 struct GlobalOptions;
 template<class GraphType> class SpanningTreeRelation;
@@ -380,6 +381,13 @@ inline namespace tsar_impl {
 
     Function *getFunction() const { return F; }
 
+    /// Set storage of results which is shared between different runs of
+    /// the analysis. Results for accesses with the same shape of subscripts
+    /// and loop bounds are obtained from this storage if it is not null.
+    void setShapeCache(tsar::DependenceShapeCache *C) noexcept {
+      ShapeCache = C;
+    }
+
   private:
     AliasAnalysis *AA;
     ScalarEvolution *SE;
@@ -394,6 +402,21 @@ inline namespace tsar_impl {
     const DefinedMemoryPass *DMP = nullptr;
     bool AllowNotPromotedAnalysis = false;
 
+    /// Results of tests which are shared between runs of the analysis.
+    tsar::DependenceShapeCache *ShapeCache = nullptr;
+
+    /// Tests for a dependence between the Src and Dst instructions which
+    /// access the same underlying object.
+    std::unique_ptr<Dependence> dependsImpl(Instruction *Src, Instruction *Dst,
+                                            bool PossiblyLoopIndependent,
+                                            unsigned short *ConfusedLevels);
+
+    /// Build a canonical shape of a dependence test for a specified pair of
+    /// accesses to the same underlying object. Return `false` if the shape
+    /// can not be described without references to IR objects.
+    bool getShape(Instruction *Src, Instruction *Dst,
+                  bool PossiblyLoopIndependent, SmallVectorImpl<char> &Shape);
+
     /// Subscript - This private struct represents a pair of subscripts from
     /// a pair of potentially multi-dimensional array references. We use a
     /// vector of them to guide subscript partitioning.
@@ -0,0 +1,102 @@
+//===- DependenceShapeCache.h - Dependence Tests Cache ----------*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2020 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file defines a storage of dependence tests results which is shared
+// between different runs of dependence analysis. Results are keyed by
+// a canonical shape of a test (base of accesses, subscripts, loop bounds,
+// conditions which guard loops, accessed types, 'inbounds' flags and source
+// element types of GEPs). A shape does not refer to IR objects, so results
+// remain valid after transformations of IR which are performed between
+// analysis stages. Tests for bases which are computed inside a loop nest and
+// tests in functions which contain assumptions are not cached. The number of
+// stored results is bounded by -da-shape-cache-limit option.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef TSAR_DEPENDENCE_SHAPE_CACHE_H
+#define TSAR_DEPENDENCE_SHAPE_CACHE_H
+
+#include "tsar/Support/AnalysisWrapperPass.h"
+#include <llvm/ADT/APInt.h>
+#include <llvm/ADT/Optional.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/ADT/StringMap.h>
+
+namespace tsar {
+/// Storage of dependence tests results which are keyed by shapes of tests.
+class DependenceShapeCache {
+public:
+  /// Description of a level of a direction vector.
+  struct DirectionInfo {
+    unsigned char Direction;
+    bool Scalar;
+    bool PeelFirst;
+    bool PeelLast;
+    bool Splitable;
+
+    /// Constant distance if it is known.
+    llvm::Optional<llvm::APInt> Distance;
+  };
+
+  /// Summary of a dependence test.
+  struct Result {
+    enum Kind : uint8_t { Independent, Confused, Full };
+
+    Kind K = Independent;
+
+    /// Number of outermost loops for which results of the test are confused.
+    unsigned short ConfusedLevels = 0;
+
+    // The following fields are available for full dependencies only.
+    unsigned short Levels = 0;
+    unsigned short DependenceConfusedLevels = 0;
+    bool LoopIndependent = false;
+    bool Consistent = false;
+    llvm::SmallVector<DirectionInfo, 4> DV;
+  };
+
+  /// Returns results of a test with a specified shape or nullptr.
+  const Result * find(llvm::StringRef Shape) const {
+    auto I = mResults.find(Shape);
+    return I != mResults.end() ? &I->second : nullptr;
+  }
+
+  /// Stores results of a test with a specified shape.
+  void insert(llvm::StringRef Shape, Result R) {
+    mResults.try_emplace(Shape, std::move(R));
+  }
+
+  /// Returns number of stored results.
+  unsigned size() const { return mResults.size(); }
+
+  /// Removes all stored results.
+  void clear() { mResults.clear(); }
+
+private:
+  llvm::StringMap<Result> mResults;
+};
+}
+
+namespace llvm {
+/// Wrapper to access results of dependence tests shared between passes.
+using DependenceShapeCacheWrapper =
+  AnalysisWrapperPass<tsar::DependenceShapeCache>;
+}
+#endif//TSAR_DEPENDENCE_SHAPE_CACHE_H
@@ -51,7 +51,9 @@
 #ifndef TSAR_ESTIMATE_MEMORY_H
 #define TSAR_ESTIMATE_MEMORY_H
 
+#include "tsar/ADT/SpanningTreeRelation.h"
 #include "tsar/Analysis/DataFlowGraph.h"
+#include "tsar/Analysis/Memory/AliasQueryCache.h"
 #include "tsar/Analysis/Memory/MemoryLocationRange.h"
 #include "tsar/Analysis/Memory/Passes.h"
 #include "tsar/Support/MetadataUtils.h"
@@ -63,6 +65,7 @@
 #include <bcl/utility.h>
 #include <llvm/ADT/DepthFirstIterator.h>
 #include <llvm/ADT/DenseMapInfo.h>
+#include <llvm/ADT/DenseSet.h>
 #include <llvm/ADT/GraphTraits.h>
 #include <llvm/ADT/iterator.h>
 #include <llvm/ADT/simple_ilist.h>
@@ -186,10 +189,20 @@ AliasDescriptor aliasRelation(llvm::AAResults &AA, const llvm::DataLayout &DL,
 AliasDescriptor aliasRelation(llvm::AAResults &AA, const llvm::DataLayout &DL,
   const EstimateMemory &LHS, const EstimateMemory &RHS);
 
+/// This determines alias relation of a first memory location to a second one,
+/// results of alias queries are memoized.
+AliasDescriptor aliasRelation(AliasQueryCache &AA, const llvm::DataLayout &DL,
+  const llvm::MemoryLocation &LHS, const llvm::MemoryLocation &RHS);
+
+/// This determines alias relation of a first estimate location to a second one,
+/// results of alias queries are memoized.
+AliasDescriptor aliasRelation(AliasQueryCache &AA, const llvm::DataLayout &DL,
+  const EstimateMemory &LHS, const EstimateMemory &RHS);
+
 /// This determines alias relation between a specified estimate location'EM' and
 /// locations from a specified range [BeginItr, EndItr).
-template<class ItrTy>
-AliasDescriptor aliasRelation(llvm::AAResults &AA, const llvm::DataLayout &DL,
+template<class AliasAnalysisT, class ItrTy>
+AliasDescriptor aliasRelation(AliasAnalysisT &AA, const llvm::DataLayout &DL,
   const EstimateMemory &EM, const ItrTy &BeginItr, const ItrTy &EndItr) {
   auto I = BeginItr;
   auto MergedAD = aliasRelation(AA, DL, EM, *I);
@@ -704,6 +717,13 @@ public:
     }
     return Dest;
   }
+
+  /// Returns identifier of this node in the last built spanning tree of
+  /// an alias tree (see SpanningTreeRelation).
+  unsigned getSpanningTreeId() const noexcept { return mSpanningTreeId; }
+
+  /// Remembers identifier of this node in a spanning tree.
+  void setSpanningTreeId(unsigned Id) const noexcept { mSpanningTreeId = Id; }
 protected:
   /// Creates an empty node of a specified kind `K`.
   explicit AliasNode(Kind K) : mKind(K) {};
@@ -753,11 +773,11 @@ protected:
   /// \return True in case of alias relation, if a known location is found it
   /// is returned as a second part of a pair.
   std::pair<bool, EstimateMemory *> slowMayAlias(
-    const EstimateMemory &EM, llvm::AAResults &AA);
+    const EstimateMemory &EM, AliasQueryCache &AA);
 
   /// This is a stub for nodes which does not support slowMayAlias().
   std::pair<bool, EstimateMemory *> slowMayAliasImp(
-      const EstimateMemory &/*EM*/, llvm::AAResults &/*AA*/) {
+      const EstimateMemory &/*EM*/, AliasQueryCache &/*AA*/) {
     llvm_unreachable("slowMayAlias() is not implemented for this node!");
     return std::make_pair(false, nullptr);
   }
@@ -771,11 +791,11 @@ protected:
   /// \return True in case of alias relation, if an uknown location is found it
   /// is returned as a second part of a pair.
   std::pair<bool, llvm::Instruction *> slowMayAliasUnknown(
-      const llvm::Instruction *I, llvm::AAResults &AA) const;
+      const llvm::Instruction *I, AliasQueryCache &AA) const;
 
   /// This is a stub for nodes which does not support slowMayAliasUnknown().
   std::pair<bool, llvm::Instruction *> slowMayAliasUnknownImp(
-      const llvm::Instruction */*I*/, llvm::AAResults &/*AA*/) const {
+      const llvm::Instruction */*I*/, AliasQueryCache &/*AA*/) const {
     llvm_unreachable("slowMayAliasUnknown() is not implemented for this node!");
     return std::make_pair(false, nullptr);
   }
@@ -785,6 +805,7 @@ protected:
   ChildList mChildren;
   mutable AliasNode *mForward = nullptr;
   mutable unsigned mRefCount = 0;
+  mutable unsigned mSpanningTreeId = 0;
 };
 
 /// This represents a root of an alias tree.
@@ -853,11 +874,11 @@ private:
 
   /// Implementation for appropriate function from the base class.
   std::pair<bool, EstimateMemory *> slowMayAliasImp(
-    const EstimateMemory &EM, llvm::AAResults &AA);
+    const EstimateMemory &EM, AliasQueryCache &AA);
 
   /// Implementation for appropriate function from the base class.
   std::pair<bool, llvm::Instruction *> slowMayAliasUnknownImp(
-    const llvm::Instruction *I, llvm::AAResults &AA) const;
+    const llvm::Instruction *I, AliasQueryCache &AA) const;
 
    AliasList mAliases;
 };
@@ -924,11 +945,11 @@ private:
 
   /// Implementation for appropriate function from the base class.
   std::pair<bool, EstimateMemory *> slowMayAliasImp(
-    const EstimateMemory &EM, llvm::AAResults &AA);
+    const EstimateMemory &EM, AliasQueryCache &AA);
 
   /// Implementation for appropriate function from the base class.
   std::pair<bool, llvm::Instruction *> slowMayAliasUnknownImp(
-    const llvm::Instruction *I, llvm::AAResults &AA) const;
+    const llvm::Instruction *I, AliasQueryCache &AA) const;
 
   UnknownList mUnknownInsts;
 };
@@ -1013,7 +1034,7 @@ public:
   /// Creates empty alias tree.
   AliasTree(llvm::AAResults &AA,
       const llvm::DataLayout &DL, const llvm::DominatorTree &DT) :
-    mAA(&AA), mDL(&DL), mDT(&DT), mTopLevelNode(new AliasTopNode) {
+    mAA(&AA), mAQC(AA), mDL(&DL), mDT(&DT), mTopLevelNode(new AliasTopNode) {
     mNodes.push_back(mTopLevelNode);
   }
 
@@ -1028,6 +1049,10 @@ public:
   /// Returns the underlying alias analysis object used by this tree.
   llvm::AAResults & getAliasAnalysis() const noexcept { return *mAA; }
 
+  /// Returns memoized results of alias queries for the underlying alias
+  /// analysis. Results are shared between all users of this tree.
+  AliasQueryCache & getAliasQueryCache() const noexcept { return mAQC; }
+
   /// Returns a dominator tree used by this alias tree.
   const llvm::DominatorTree & getDomTree() const noexcept { return *mDT; }
 
@@ -1065,7 +1090,11 @@ public:
     return add(llvm::MemoryLocation(Ptr, Size, AAInfo));
   }
 
-  /// Inserts new estimate memory location.
+  /// \brief Inserts new estimate memory location.
+  ///
+  /// A location is stripped to its base before insertion. If the base has
+  /// been already inserted, the tree is not changed and no alias queries
+  /// are performed.
   void add(const llvm::MemoryLocation &Loc);
 
   /// \brief Inserts unknown memory access.
@@ -1199,6 +1228,7 @@ private:
     insert(const llvm::MemoryLocation &Base);
 
   llvm::AAResults *mAA;
+  mutable AliasQueryCache mAQC;
   const llvm::DataLayout *mDL;
   const llvm::DominatorTree *mDT;
   AliasNodePool mNodes;
@@ -1206,6 +1236,7 @@ private:
   tsar::AmbiguousRef::AmbiguousPool mAmbiguousPool;
   StrippedMap mBases;
   mutable llvm::DenseMap<llvm::MemoryLocation, EstimateMemory *> mSearchCache;
+  llvm::DenseSet<llvm::MemoryLocation> mInsertedBases;
 };
 
 inline void EstimateMemory::setAliasNode(
@@ -1235,7 +1266,7 @@ inline void AliasNode::mergeNodeIn(AliasNode &AN, const AliasTree &G) {
 }
 
 inline std::pair<bool, EstimateMemory *> AliasNode::slowMayAlias(
-    const EstimateMemory &EM, llvm::AAResults &AA) {
+    const EstimateMemory &EM, AliasQueryCache &AA) {
   switch (getKind()) {
   default:
     llvm_unreachable("Unknown kind of an alias node!");
@@ -1250,7 +1281,7 @@ inline std::pair<bool, EstimateMemory *> AliasNode::slowMayAlias(
 }
 
 inline std::pair<bool, llvm::Instruction *> AliasNode::slowMayAliasUnknown(
-    const llvm::Instruction *I, llvm::AAResults &AA) const {
+    const llvm::Instruction *I, AliasQueryCache &AA) const {
   switch (getKind()) {
   default:
     llvm_unreachable("Unknown kind of an alias node!");
@@ -1573,10 +1604,26 @@ public:
 
 private:
   tsar::AliasTree *mAliasTree = nullptr;
+  tsar::GlobalAliasCache *mGlobalAliasCache = nullptr;
+  tsar::GlobalAliasCache::ScopeId mGlobalAliasScope = 0;
 };
 }
 
 namespace tsar {
+/// Alias nodes store their identifiers in a spanning tree of an alias tree.
+template<> struct SpanningTreeNodeTraits<const AliasNode *> {
+  static constexpr bool HasId = true;
+  static unsigned getId(const AliasNode *N) noexcept {
+    return N->getSpanningTreeId();
+  }
+  static void setId(const AliasNode *N, unsigned Id) noexcept {
+    N->setSpanningTreeId(Id);
+  }
+};
+
+template<> struct SpanningTreeNodeTraits<AliasNode *> :
+  public SpanningTreeNodeTraits<const AliasNode *> {};
+
 /// Applies a function to each node which aliases with a specified one.
 template<class FuncTy>
 void for_each_alias(AliasTree *AT, AliasNode *AN, FuncTy &&Func) {
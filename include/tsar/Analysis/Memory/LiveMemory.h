@@ -28,12 +28,16 @@
 #include "tsar/ADT/DataFlow.h"
 #include "tsar/ADT/DenseMapTraits.h"
 #include "tsar/Analysis/DFRegionInfo.h"
+#include "tsar/Analysis/Memory/BitMemorySet.h"
 #include "tsar/Analysis/Memory/DefinedMemory.h"
 #include "tsar/Analysis/Memory/DFMemoryLocation.h"
 #include "tsar/Analysis/Memory/Passes.h"
 #include "tsar/Support/AnalysisWrapperPass.h"
 #include <bcl/utility.h>
+#include <llvm/ADT/BitVector.h>
 #include <llvm/Pass.h>
+#include <llvm/Support/ThreadPool.h>
+#include <memory>
 
 namespace llvm {
 class DominatorTree;
@@ -58,6 +62,32 @@ public:
     bcl::tagged<llvm::Function *, llvm::Function>,
     bcl::tagged<std::unique_ptr<LiveSet>, LiveSet>>> InterprocLiveMemoryInfo;
 
+  /// Numbering of locations which are accessed in a function.
+  typedef MemoryUniverse<MemoryLocationRange> LocationUniverse;
+
+  /// Set of locations which is used to solve a data-flow problem.
+  typedef BitMemorySet<MemoryLocationRange> LocationBitSet;
+
+  /// This covers IN and OUT values and def-use attributes of a node
+  /// which are used to solve a data-flow problem.
+  ///
+  /// Numbered locations are stored in bit vectors, so the transfer function
+  /// and the meet operator do not scan sets of locations unless locations
+  /// partially overlap.
+  struct DenseLiveSet {
+    explicit DenseLiveSet(const LocationUniverse &U) :
+      In(U), Out(U), Uses(U), Defs(U.size()) {}
+
+    LocationBitSet In;
+    LocationBitSet Out;
+
+    /// Locations which get values outside a node.
+    LocationBitSet Uses;
+
+    /// Numbered locations which have definitions in a node.
+    llvm::BitVector Defs;
+  };
+
   LiveDFFwk(LiveMemoryInfo &LiveInfo, DefinedMemoryInfo &DefInfo,
       const llvm::DominatorTree *DT) :
     mLiveInfo(&LiveInfo), mDefInfo(&DefInfo), mDT(DT) {}
@@ -66,10 +96,34 @@ public:
   DefinedMemoryInfo & getDefInfo() noexcept { return *mDefInfo; }
   const DefinedMemoryInfo & getDefInfo() const noexcept { return *mDefInfo; }
   const llvm::DominatorTree * getDomTree() const noexcept { return mDT; }
+
+  /// \brief Numbers locations accessed in a specified hierarchy of regions
+  /// and allocates dense data-flow values for all its nodes.
+  ///
+  /// Value after a specified region must be already available in the map of
+  /// results. Each node has its own storage after this call, so sibling
+  /// regions can be solved in separate threads without changes of the map.
+  void initializeDense(DFRegion *R);
+
+  /// Stores dense data-flow values in the map of results and releases them.
+  void finalizeDense();
+
+  /// Returns dense data-flow value for a specified node.
+  DenseLiveSet & getDenseValue(DFNode *N) {
+    auto I = mDenseInfo.find(N);
+    assert(I != mDenseInfo.end() && I->second &&
+      "Data-flow value must be specified!");
+    return *I->second;
+  }
+
+  /// Returns numbering of locations which are accessed in a function.
+  const LocationUniverse & getUniverse() const noexcept { return mUniverse; }
 private:
   LiveMemoryInfo *mLiveInfo;
   DefinedMemoryInfo *mDefInfo;
   const llvm::DominatorTree *mDT;
+  LocationUniverse mUniverse;
+  llvm::DenseMap<DFNode *, std::unique_ptr<DenseLiveSet>> mDenseInfo;
 };
 
 /// This covers IN and OUT value for a live locations analysis.
@@ -85,48 +139,40 @@ typedef LiveDFFwk::InterprocLiveMemoryInfo InterprocLiveMemoryInfo;
 /// Traits for a data-flow framework which is used to find live locations.
 template<> struct DataFlowTraits<LiveDFFwk *> {
   typedef Backward<DFRegion * > GraphType;
-  typedef MemorySet<MemoryLocationRange> ValueType;
-  static ValueType topElement(LiveDFFwk *, GraphType) { return ValueType(); }
+  typedef LiveDFFwk::LocationBitSet ValueType;
+  static ValueType topElement(LiveDFFwk *DFF, GraphType) {
+    assert(DFF && "Data-flow framework must not be null!");
+    return ValueType(DFF->getUniverse());
+  }
   static ValueType boundaryCondition(LiveDFFwk *DFF, GraphType G) {
     assert(DFF && "Data-flow framework must not be null!");
-    auto I = DFF->getLiveInfo().find(G.Graph);
-    assert(I != DFF->getLiveInfo().end() && I->get<LiveSet>() &&
-      "Data-flow value must be specified!");
-    auto &LS = I->get<LiveSet>();
+    auto &LS = DFF->getDenseValue(G.Graph);
     ValueType V(topElement(DFF, G));
     // If a location is alive before a loop it is alive before each iteration.
     // This occurs due to conservatism of analysis.
     // If a location is alive before iteration with number I then it is alive
     // after iteration with number I-1. So it should be used as a boundary
     // value.
-    meetOperator(LS->getIn(), V, DFF, G);
+    meetOperator(LS.In, V, DFF, G);
     // If a location is alive after a loop it also should be used as a boundary
     // value.
-    meetOperator(LS->getOut(), V, DFF, G);
+    meetOperator(LS.Out, V, DFF, G);
     return V;
   }
   static void setValue(ValueType V, DFNode *N, LiveDFFwk *DFF) {
     assert(N && "Node must not be null!");
     assert(DFF && "Data-flow framework must not be null!");
-    auto I = DFF->getLiveInfo().find(N);
-    assert(I != DFF->getLiveInfo().end() && I->get<LiveSet>() &&
-      "Data-flow value must be specified!");
-    auto & LS = I->get<LiveSet>();
-    LS->setIn(std::move(V));
+    DFF->getDenseValue(N).In = std::move(V);
   }
   static const ValueType & getValue(DFNode *N, LiveDFFwk *DFF) {
     assert(N && "Node must not be null!");
     assert(DFF && "Data-flow framework must not be null!");
-    auto I = DFF->getLiveInfo().find(N);
-    assert(I != DFF->getLiveInfo().end() && I->get<LiveSet>() &&
-      "Data-flow value must be specified!");
-    auto &LS = I->get<LiveSet>();
-    return LS->getIn();
+    return DFF->getDenseValue(N).In;
   }
   static void initialize(DFNode *, LiveDFFwk *, GraphType);
   static void meetOperator(
     const ValueType &LHS, ValueType &RHS, LiveDFFwk *, GraphType) {
-    RHS.insert(LHS.begin(), LHS.end());
+    RHS.merge(LHS);
   }
   static bool transferFunction(ValueType, DFNode *, LiveDFFwk *, GraphType);
 };
@@ -191,6 +237,7 @@ public:
   void releaseMemory() override { mLiveInfo.clear(); }
 private:
   tsar::LiveMemoryInfo mLiveInfo;
+  std::unique_ptr<ThreadPool> mPool;
 };
 
 /// Wrapper to access results of interprocedural live memory analysis.
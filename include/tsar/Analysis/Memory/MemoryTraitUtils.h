@@ -27,17 +27,21 @@
 namespace tsar {
 namespace detail {
 template<template<class Element, class Coll> class InserterT,
-  class DependenceSetT, class AliasNodeT, class CollT>
+  class DependenceSetT, class AliasNodeT, class CollT, class FilterT>
 inline void explicitAccessCoverage(bool IgnoreRedundant,
-    const DependenceSetT &DS, const AliasNodeT &N, CollT &C) {
+    const DependenceSetT &DS, const AliasNodeT &N, CollT &C,
+    const FilterT &Filter) {
   auto ATraitItr = DS.find_as(&N);
   if (ATraitItr == DS.end() ||
       !ATraitItr->template is<trait::ExplicitAccess>() ||
-      (IgnoreRedundant && !ATraitItr->template is<trait::NoRedundant>()))
+      (IgnoreRedundant && !ATraitItr->template is<trait::NoRedundant>())) {
     for (auto &Child : make_range(N.child_begin(), N.child_end()))
-      detail::explicitAccessCoverage<InserterT>(IgnoreRedundant,DS, Child, C);
-  else
+      if (Filter(Child))
+        detail::explicitAccessCoverage<InserterT>(
+          IgnoreRedundant, DS, Child, C, Filter);
+  } else {
     InserterT<const AliasNodeT *, CollT>::insert(&N, C);
+  }
 }
 
 template<
@@ -67,7 +71,24 @@ inline void explicitAccessCoverage(
     const DependenceSetT &DS, const AliasTreeT &AT, CollT &C,
     bool IgnoreRedundant = false) {
   detail::explicitAccessCoverage<InserterT>(
-    IgnoreRedundant, DS, *AT.getTopLevelNode(), C);
+    IgnoreRedundant, DS, *AT.getTopLevelNode(), C,
+    [](const auto &) { return true; });
+}
+
+/// Returns a number of the smallest alias nodes which covers all explicit
+/// memory accesses in the region.
+///
+/// Subtrees with roots which do not satisfy a specified filter are not
+/// visited. So, the filter must accept all nodes from a dependence set and
+/// all their ancestors.
+template<
+  template<class ElementT, class CollT> class InserterT = bcl::PushBackInserter,
+  class DependenceSetT, class AliasTreeT, class CollT, class FilterT>
+inline void explicitAccessCoverage(
+    const DependenceSetT &DS, const AliasTreeT &AT, CollT &C,
+    bool IgnoreRedundant, FilterT &&Filter) {
+  detail::explicitAccessCoverage<InserterT>(
+    IgnoreRedundant, DS, *AT.getTopLevelNode(), C, Filter);
 }
 
 /// Returns a number of the smallest alias nodes which covers all
@@ -191,6 +191,37 @@ ImmutablePass *createGlobalDefinedMemoryStorage();
 /// analysis.
 void initializeGlobalDefinedMemoryWrapperPass(PassRegistry &Registry);
 
+/// Initialize a pass to store results of dependence tests which are shared
+/// between different runs of dependence analysis.
+void initializeDependenceShapeCacheStoragePass(PassRegistry &Registry);
+
+/// Create a pass to store results of dependence tests which are shared
+/// between different runs of dependence analysis.
+ImmutablePass *createDependenceShapeCacheStorage();
+
+/// Initialize a pass to access results of dependence tests which are shared
+/// between different runs of dependence analysis.
+void initializeDependenceShapeCacheWrapperPass(PassRegistry &Registry);
+
+/// Initialize a pass to store alias relations between global objects which
+/// are shared between alias trees for different functions.
+void initializeGlobalAliasCacheStoragePass(PassRegistry &Registry);
+
+/// Create a pass to store alias relations between global objects which
+/// are shared between alias trees for different functions.
+ImmutablePass *createGlobalAliasCacheStorage();
+
+/// Initialize a pass to access alias relations between global objects.
+void initializeGlobalAliasCacheWrapperPass(PassRegistry &Registry);
+
+/// Initialize a pass to invalidate alias relations between global objects
+/// after transformation of IR.
+void initializeGlobalAliasCacheInvalidatorPass(PassRegistry &Registry);
+
+/// Create a pass to invalidate alias relations between global objects
+/// after transformation of IR.
+ModulePass *createGlobalAliasCacheInvalidator();
+
 /// Create analysis server.
 ModulePass *createDIMemoryAnalysisServer();
 
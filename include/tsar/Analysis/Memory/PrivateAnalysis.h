@@ -39,6 +39,7 @@
 #include "tsar/Analysis/Memory/LiveMemory.h"
 #include "tsar/Analysis/Memory/Passes.h"
 #include <bcl/utility.h>
+#include <llvm/ADT/ArrayRef.h>
 #include <llvm/Analysis/MemoryLocation.h>
 #include <llvm/Pass.h>
 #include <forward_list>
@@ -67,6 +68,7 @@ using PrivateInfo =
 namespace detail {
 class DependenceImp;
 struct DependenceCache;
+class RelatedAccesses;
 }
 }
 
@@ -190,8 +192,18 @@ public:
 private:
   /// Uses dependence analysis pass to collect loop-carried dependencies in
   /// a specified loop.
-  void collectDependencies(Loop *L, DependenceMap &Deps,
-    tsar::detail::DependenceCache &Cache);
+  void collectDependencies(Loop *L, const tsar::AliasTreeRelation &AliasSTR,
+    DependenceMap &Deps, tsar::detail::DependenceCache &Cache);
+
+  /// \brief Finds accesses which may depend on each other.
+  ///
+  /// This collects alias nodes which are accessed by instructions from
+  /// a specified list and relations between these nodes. Instructions which
+  /// access memory from unrelated nodes of the alias tree access memory which
+  /// do not alias.
+  void collectRelatedAccesses(ArrayRef<Instruction *> Insts,
+    const tsar::AliasTreeRelation &AliasSTR,
+    tsar::detail::RelatedAccesses &Related);
 
   /// Update collection `Deps` of loop-carried dependencies in a specified loop.
   void insertDependence(const Dependence &Dep,
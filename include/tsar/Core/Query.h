@@ -267,18 +267,30 @@ protected:
 
 /// This performs instrumentation of LLVM IR and prints it to the standard
 /// output stream after instrumentation.
+///
+/// If global options are specified, static analysis is performed before
+/// instrumentation and accesses to memory with traits which are precisely
+/// determined by static analysis are not instrumented. In this case passes
+/// from addInitialTransformations() are run instead of the default list of
+/// passes which prepare IR for instrumentation. Note, that this list also
+/// contains passes which change IR (for example, GlobalDCE and
+/// StripDeadPrototypes), so unused functions and globals are not
+/// instrumented.
 class InstrLLVMQueryManager : public EmitLLVMQueryManager {
 public:
   explicit InstrLLVMQueryManager(llvm::StringRef InstrEntry = "",
-      llvm::ArrayRef<std::string> InstrStart = {}) :
+      llvm::ArrayRef<std::string> InstrStart = {},
+      const GlobalOptions *PruneOptions = nullptr) :
     mInstrEntry(InstrEntry),
-    mInstrStart(InstrStart.begin(), InstrStart.end()) {}
+    mInstrStart(InstrStart.begin(), InstrStart.end()),
+    mPruneOptions(PruneOptions) {}
 
   void run(llvm::Module *M, tsar::TransformationInfo *) override;
 
 private:
   std::string mInstrEntry;
   std::vector<std::string> mInstrStart;
+  const GlobalOptions *mPruneOptions;
 };
 
 /// This performs a specified source-level transformation.
@@ -30,6 +30,7 @@
 #include "tsar/Support/GlobalOptions.h"
 #include <bcl/utility.h>
 #include <clang/Tooling/CompilationDatabase.h>
+#include <llvm/ADT/ArrayRef.h>
 #include <llvm/ADT/SmallVector.h>
 #include <string>
 #include <vector>
@@ -96,9 +97,25 @@ private:
   ///
   void storePrintOptions(OptionList &IncompatibleOpts);
 
+  /// \brief Processes each source in a separate worker process.
+  ///
+  /// Up to mJobs sources are processed at the same time. Output of workers
+  /// is printed in the order of sources in the command line.
+  /// \return Zero on success.
+  int runParallel();
+
+  /// \brief Emits Clang AST files for sources which should be merged.
+  ///
+  /// Names of AST files are appended to `ASTFiles` in the order of sources.
+  /// Sources are processed in parallel if mJobs is greater than 1.
+  void emitASTToMerge(llvm::ArrayRef<std::string> Sources,
+                      std::vector<std::string> &ASTFiles);
+
   GlobalOptions mGlobalOpts;
   std::vector<std::string> mCommandLine;
   std::vector<std::string> mSources;
+  /// Original command line, the first argument is a path to the executable.
+  std::vector<std::string> mArgs;
   std::vector<const llvm::PassInfo *> mOutputPasses;
   std::vector<const llvm::PassInfo *> mPrintPasses;
   ///Bit set of steps that should be printed.
@@ -111,10 +128,12 @@ private:
   bool mDumpAST = false;
   bool mEmitLLVM = false;
   bool mInstrLLVM = false;
+  bool mInstrPrune = false;
   bool mCheck = false;
   bool mPrint = false;
   bool mServer = false;
   bool mLoadSources = true;
+  unsigned mJobs = 1;
   std::string mOutputFilename;
   std::string mLanguage;
   std::string mInstrEntry;
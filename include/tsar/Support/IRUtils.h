@@ -28,11 +28,48 @@
 #include <llvm/Analysis/LoopInfo.h>
 #include <llvm/IR/Type.h>
 #include <llvm/ADT/SmallVector.h>
+#include <cstdint>
+#include <vector>
 
 namespace tsar {
 /// Returns argument with a specified number or nullptr.
 llvm::Argument * getArgument(llvm::Function &F, std::size_t ArgNo);
 
+/// Fingerprint of a function body.
+///
+/// The fingerprint describes structure of a function: attributes, order of
+/// basic blocks and instructions, opcodes, types and other properties of
+/// instructions (predicates, alignment, etc.) and operands. Operands which
+/// are defined in the function are described with their local numbers,
+/// other operands (constants and globals) are described with their addresses.
+/// The fingerprint also takes into account identity of basic blocks and
+/// instructions. So, it changes if any instruction is inserted, removed
+/// or replaced, even if the new instruction looks like the old one.
+///
+/// Fingerprints are compared element-wise rather than by hash. So, equal
+/// fingerprints mean that IR-level values which have been collected in
+/// a function earlier are still valid and have the same meaning.
+class FunctionFingerprint {
+public:
+  /// Creates an empty fingerprint which differs from a fingerprint of
+  /// any function.
+  FunctionFingerprint() = default;
+
+  /// Computes a fingerprint of a specified function.
+  explicit FunctionFingerprint(const llvm::Function &F);
+
+  bool operator==(const FunctionFingerprint &RHS) const {
+    return mData == RHS.mData;
+  }
+
+  bool operator!=(const FunctionFingerprint &RHS) const {
+    return !operator==(RHS);
+  }
+
+private:
+  std::vector<std::uintptr_t> mData;
+};
+
 /// Returns number of dimensions in a specified type or 0 if it is not an array.
 inline unsigned dimensionsNum(const llvm::Type *Ty) {
   unsigned Dims = 0;
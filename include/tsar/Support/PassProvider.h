@@ -35,14 +35,18 @@
 // the pass manager so it is not possible to specify additional parameters to
 // initialize a such passes.
 //
-// To avoid this problems a provider pass could be used.
+// To avoid this problems a provider pass could be used. To avoid re-execution
+// of passes if results for the same function are requested several times
+// OnTheFlyPassCache could be used.
 //===----------------------------------------------------------------------===//
 
 #ifndef TSAR_PASS_PROVIDER_H
 #define TSAR_PASS_PROVIDER_H
 
+#include <llvm/ADT/DenseMap.h>
 #include <llvm/IR/Function.h>
 #include <llvm/IR/LegacyPassManagers.h>
+#include <llvm/IR/ValueHandle.h>
 #include <llvm/Pass.h>
 #include <forward_list>
 #include <type_traits>
@@ -292,6 +296,52 @@ struct is_pass_provider<T, enable_if_pass_provider<T>> : std::true_type {};
 template<class T>
 using pass_provider_analysis =
     decltype(detail::check_pass_provider(std::declval<T>()));
+
+/// \brief Memoizes function passes which have been executed on the fly for
+/// the last requested function.
+///
+/// Each call of getAnalysis<...>(F) from a module pass executes the whole
+/// sequence of function passes which are required on the fly. Results of
+/// these passes are stored in pass objects which are reused for all functions,
+/// so results for the last processed function only are available at a time.
+/// This cache remembers the last function and returns already executed passes
+/// if results for the same function are requested again.
+///
+/// \attention All on the fly requests from a module pass must be performed
+/// with the same cache. The cache must be invalidated if the module pass
+/// changes IR of the last processed function.
+class OnTheFlyPassCache {
+public:
+  /// Returns results of AnalysisType pass for a specified function, executes
+  /// the pass on the fly if it is necessary.
+  template<class AnalysisType>
+  AnalysisType & getAnalysis(llvm::Pass &P, llvm::Function &F) {
+    const void *ID = &AnalysisType::ID;
+    if (mLast == &F) {
+      auto Itr = mPasses.find(ID);
+      if (Itr != mPasses.end())
+        return *static_cast<AnalysisType *>(Itr->second);
+    } else {
+      // Passes which have been executed for the previous function may be
+      // not executed for the current one, so forget all of them.
+      mPasses.clear();
+      mLast = &F;
+    }
+    auto &Result = P.getAnalysis<AnalysisType>(F);
+    mPasses[ID] = &Result;
+    return Result;
+  }
+
+  /// Forgets the last processed function, so passes will be executed again.
+  void invalidate() {
+    mLast = nullptr;
+    mPasses.clear();
+  }
+
+private:
+  llvm::WeakVH mLast;
+  llvm::DenseMap<const void *, llvm::Pass *> mPasses;
+};
 }
 
 #endif//TSAR_PASS_PROVIDER_H
@@ -31,6 +31,7 @@
 #include <bcl/utility.h>
 #include <llvm/ADT/ArrayRef.h>
 #include <llvm/ADT/BitmaskEnum.h>
+#include <llvm/ADT/DenseMap.h>
 #include <llvm/ADT/Optional.h>
 #include <llvm/ADT/StringRef.h>
 #include <llvm/IR/InstVisitor.h>
@@ -178,9 +179,26 @@ private:
   /// will be marked with 'sapfor.da.ignore'.
   void excludeFunctions(llvm::Module &M);
 
+  /// Registers accesses to memory, accesses which are marked with
+  /// 'sapfor.da.ignore' metadata are not registered.
   void regReadMemory(llvm::Instruction &I, llvm::Value &Ptr);
   void regWriteMemory(llvm::Instruction &I, llvm::Value &Ptr);
 
+  /// \brief Registers accesses to memory which are performed by a specified
+  /// instruction in all iterations of a loop with a single call of
+  /// sapforReadArrRange(...) or sapforWriteArrRange(...).
+  ///
+  /// The call is inserted into a loop preheader, so it is executed once per
+  /// loop entry. Accesses are aggregated if -instr-llvm-ranges option is set,
+  /// the instruction is a simple load or store, accessed addresses form
+  /// an affine recurrence with a constant step, all other accesses to the same
+  /// memory in the loop are also affine and the instruction is executed
+  /// exactly once in each iteration of a loop with a computable trip count.
+  /// If a dynamic analyzer does not provide functions to register ranges,
+  /// weak definitions of these functions register each access separately.
+  /// \return False if accesses should be registered one by one.
+  bool regMemoryRange(llvm::Instruction &I, llvm::Value &Ptr, bool IsWrite);
+
   /// Reserves some metadata string for object which have not enough
   /// information.
   void reserveIncompleteDIStrings(llvm::Module &M);
@@ -208,9 +226,11 @@ private:
   /// - address of accessed memory,
   /// - metadata string for accessed memory,
   /// - address of array base (in case of array access) or nullptr.
+  ///
+  /// If `BasePtr` is not specified it is computed from `Ptr`.
   std::tuple<llvm::Value *, llvm::Value *, llvm::Value *, llvm::Value *>
     regMemoryAccessArgs(llvm::Value *Ptr, const llvm::DebugLoc &DbgLoc,
-      llvm::Instruction &InsertBefore);
+      llvm::Instruction &InsertBefore, llvm::Value *BasePtr = nullptr);
 
   /// \brief Registers a metadata string and a variable.
   ///
@@ -282,11 +302,18 @@ private:
 
   /// \brief Returns description of metadata with a specified index in the pool.
   ///
-  /// All inserted instructions which access memory will be stored in
-  /// the mIgnoreMemoryAccess set.
+  /// Description is loaded at the beginning of a function which contains
+  /// `InsertBefore`, so a single load is shared between all uses of the
+  /// same description in the function. Note, that the pool is completely
+  /// initialized before the execution of any instrumented function.
+  /// All inserted instructions are marked with "sapfor.da" metadata.
   llvm::LoadInst* createPointerToDI(
     DIStringRegister::IdTy Idx, llvm::Instruction &InsertBefore);
 
+  /// Returns pointer to the pool of metadata which is loaded once at
+  /// the beginning of a specified function.
+  llvm::LoadInst & getDIPoolPtr(llvm::Function &F);
+
   /// \brief Creates instructions to compute a specified SCEV if possible.
   ///
   /// \pref DominatorTree (mDT) and ScalarEvoultion (mSE) must not be null.
@@ -351,8 +378,17 @@ private:
   DIStringRegister mDIStrings;
   llvm::GlobalVariable *mDIPool = nullptr;
   llvm::Function *mInitDIAll = nullptr;
+  /// Pointers to the pool of metadata loaded at the beginning of functions.
+  llvm::DenseMap<llvm::Function *, llvm::LoadInst *> mDIPoolPtrs;
+  /// Descriptions of metadata loaded at the beginning of functions.
+  llvm::DenseMap<std::pair<llvm::Function *, DIStringRegister::IdTy>,
+    llvm::LoadInst *> mDIPtrs;
   /// Dominator tree of a currently processed function.
   llvm::DominatorTree *mDT = nullptr;
+  /// Loop tree of a currently processed function.
+  llvm::LoopInfo *mLI = nullptr;
+  /// Scalar evolution of a currently processed function.
+  llvm::ScalarEvolution *mSE = nullptr;
 };
 }
 
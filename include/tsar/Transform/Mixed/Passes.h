@@ -47,6 +47,18 @@ void initializeInstrumentationPassPass(PassRegistry &Registry);
 ModulePass * createInstrumentationPass(llvm::StringRef InstrEntry = "",
   llvm::ArrayRef<std::string> StartFrom = {});
 
+/// Initialize a pass which marks accesses to memory that should not be
+/// instrumented because their traits are determined by static analysis.
+void initializeInstrumentationPruningPassPass(PassRegistry &Registry);
+
+/// Create a pass which marks accesses to memory that should not be
+/// instrumented because their traits are determined by static analysis.
+///
+/// The entry point of a program is `InstrEntry` if it is specified or
+/// 'main' ('MAIN_' for Fortran programs) otherwise.
+FunctionPass * createInstrumentationPruningPass(
+  llvm::StringRef InstrEntry = "");
+
 /// Initialize a pass which retrieves some debug information for a loop if
 /// it is not presented in LLVM IR.
 void initializeDILoopRetrieverPassPass(PassRegistry &Registry);
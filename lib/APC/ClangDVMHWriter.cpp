@@ -426,13 +426,15 @@ bool APCClangDVMHWriter::runOnModule(llvm::Module &M) {
       TplItr->second.try_emplace(AR.alignWith);
     }
   };
+  OnTheFlyPassCache Providers;
   for (auto &Info : LocalVariables) {
     auto *F = M.getFunction(Info.first->getName());
     if (!F || F->getSubprogram() != Info.first)
       F = M.getFunction(Info.first->getLinkageName());
     assert(F && F->getSubprogram() == Info.first &&
       "LLVM IR function with attached metadata must not be null!");
-    auto &Provider = getAnalysis<APCClangDVMHWriterProvider>(*F);
+    auto &Provider =
+      Providers.getAnalysis<APCClangDVMHWriterProvider>(*this, *F);
     auto &Matcher = Provider.get<ClangDIMemoryMatcherPass>().getMatcher();
     auto *FD = cast<FunctionDecl>(mTfmCtx->getDeclForMangledName(F->getName()));
     assert(FD && "AST-level function declaration must not be null!");
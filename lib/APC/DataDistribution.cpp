@@ -206,6 +206,7 @@ bool APCDataDistributionPass::runOnModule(Module &M) {
   ArrayAccessSummary ArrayRWs;
   ArrayAccessPool AccessPool;
   LoopToArrayMap Accesses;
+  OnTheFlyPassCache Providers;
   for (auto &F : M) {
     auto *FI = APCCtx.findFunction(F);
     if (!FI)
@@ -215,7 +216,8 @@ bool APCDataDistributionPass::runOnModule(Module &M) {
     auto Itr = FileToFunc.emplace(std::piecewise_construct,
       std::forward_as_tuple(FI->fileName), std::forward_as_tuple()).first;
     Itr->second.push_back(FI);
-    auto &Provider = getAnalysis<APCDataDistributionProvider>(F);
+    auto &Provider =
+      Providers.getAnalysis<APCDataDistributionProvider>(*this, F);
     auto &DT = Provider.get<DominatorTreeWrapperPass>().getDomTree();
     auto &DI = Provider.get<DelinearizationPass>().getDelinearizeInfo();
     auto &AT = Provider.get<EstimateMemoryPass>().getAliasTree();
@@ -0,0 +1,96 @@
+//===--- ASTIndex.cpp ----- Index of Function AST ---------------*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2020 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements a pass which builds index of AST entities for
+// a function.
+//
+//===----------------------------------------------------------------------===//
+
+#include "tsar/Analysis/Clang/ASTIndex.h"
+#include "tsar/Frontend/Clang/TransformationContext.h"
+#include <clang/AST/RecursiveASTVisitor.h>
+#include <llvm/ADT/Statistic.h>
+
+using namespace clang;
+using namespace llvm;
+using namespace tsar;
+
+#undef DEBUG_TYPE
+#define DEBUG_TYPE "clang-ast-index"
+
+STATISTIC(NumIndexedStmt, "Number of indexed statements");
+
+namespace {
+class ASTIndexVisitor : public RecursiveASTVisitor<ASTIndexVisitor> {
+public:
+  ASTIndexVisitor(ClangASTIndex::StmtList &Stmts,
+      ClangASTIndex::CallList &Calls) : mStmts(Stmts), mCalls(Calls) {}
+
+  bool VisitStmt(Stmt *S) {
+    mStmts.push_back(S);
+    return true;
+  }
+
+  bool VisitCallExpr(CallExpr *E) {
+    mCalls.push_back(E);
+    return true;
+  }
+
+private:
+  ClangASTIndex::StmtList &mStmts;
+  ClangASTIndex::CallList &mCalls;
+};
+}
+
+void ClangASTIndex::build(Decl &D) {
+  clear();
+  ASTIndexVisitor(mStmts, mCalls).TraverseDecl(&D);
+  NumIndexedStmt += mStmts.size();
+}
+
+char ClangASTIndexPass::ID = 0;
+
+INITIALIZE_PASS_BEGIN(ClangASTIndexPass, "clang-ast-index",
+  "Function AST Index (Clang)", true, true)
+  INITIALIZE_PASS_DEPENDENCY(TransformationEnginePass)
+INITIALIZE_PASS_END(ClangASTIndexPass, "clang-ast-index",
+  "Function AST Index (Clang)", true, true)
+
+FunctionPass * llvm::createClangASTIndexPass() {
+  return new ClangASTIndexPass;
+}
+
+bool ClangASTIndexPass::runOnFunction(Function &F) {
+  releaseMemory();
+  auto &TfmInfo = getAnalysis<TransformationEnginePass>();
+  if (!TfmInfo)
+    return false;
+  auto TfmCtx = TfmInfo->getContext(*F.getParent());
+  if (!TfmCtx || !TfmCtx->hasInstance())
+    return false;
+  if (auto *FuncDecl = TfmCtx->getDeclForMangledName(F.getName()))
+    mIndex.build(*FuncDecl);
+  return false;
+}
+
+void ClangASTIndexPass::getAnalysisUsage(AnalysisUsage &AU) const {
+  AU.addRequired<TransformationEnginePass>();
+  AU.setPreservesAll();
+}
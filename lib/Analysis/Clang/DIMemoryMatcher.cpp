@@ -24,6 +24,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "tsar/Analysis/Clang/DIMemoryMatcher.h"
+#include "tsar/Analysis/Clang/FileIDTable.h"
 #include "tsar/Analysis/Clang/Matcher.h"
 #include "tsar/Analysis/Clang/MemoryMatcher.h"
 #include "tsar/Analysis/Memory/Utils.h"
@@ -56,6 +57,7 @@ INITIALIZE_PASS_BEGIN(ClangDIMemoryMatcherPass, "di-memory-matcher",
   INITIALIZE_PASS_DEPENDENCY(TransformationEnginePass)
   INITIALIZE_PASS_DEPENDENCY(MemoryMatcherImmutableWrapper)
   INITIALIZE_PASS_DEPENDENCY(DominatorTreeWrapperPass)
+  INITIALIZE_PASS_DEPENDENCY(ClangFileIDTablePass)
 INITIALIZE_PASS_END(ClangDIMemoryMatcherPass, "di-memory-matcher",
   "High and Metadata Memory Matcher (Clang)", true, true)
 
@@ -67,64 +69,23 @@ void ClangDIMemoryMatcherPass::getAnalysisUsage(AnalysisUsage &AU) const {
   AU.addRequired<TransformationEnginePass>();
   AU.addRequired<DominatorTreeWrapperPass>();
   AU.addRequired<MemoryMatcherImmutableWrapper>();
+  AU.addRequired<ClangFileIDTablePass>();
   AU.setPreservesAll();
 }
 
 namespace {
-struct DILocalScopeMapInfo {
-  static std::pair<unsigned, unsigned> getLineColumn(
-      const DILocalScope *Scope) {
-    if (auto *S = dyn_cast<DISubprogram>(Scope))
-      return { S->getScopeLine(), 0u };
-    if (auto *S = dyn_cast<DILexicalBlock>(Scope)) {
-      return { S->getLine(), S->getColumn() };
-    }
-    return { 0u, 0u };
-  }
-  static inline DILocalScope * getEmptyKey() {
-    return DenseMapInfo<DILocalScope *>::getEmptyKey();
-  }
-  static inline DILocalScope * getTombstoneKey() {
-    return DenseMapInfo<DILocalScope *>::getTombstoneKey();
-  }
-  static unsigned getHashValue(const DILocalScope *Scope) {
-    auto LineColumn = getLineColumn(Scope);
-    assert(LineColumn.first && "Line must be known!");
-    return DenseMapInfo<decltype(LineColumn)>::getHashValue(LineColumn);
-  }
-  static unsigned getHashValue(const clang::PresumedLoc &PLoc) {
-    auto Line = PLoc.getLine();
-    auto Column = PLoc.getColumn();
-    auto Pair = std::make_pair(Line, Column);
-    return DenseMapInfo<decltype(Pair)>::getHashValue(Pair);
-  }
-  static bool isEqual(const DILocalScope *LHS, const DILocalScope *RHS) {
-    if (LHS == RHS)
-      return true;
-    auto TK = getTombstoneKey();
-    auto EK = getEmptyKey();
-    if (RHS == TK || LHS == TK || RHS == EK || LHS == EK)
-      return false;
-    auto LineColumnLHS = getLineColumn(LHS);
-    auto LineColumnRHS = getLineColumn(RHS);
-    SmallString<128> LHSPath, RHSPath;
-    return LineColumnLHS == LineColumnRHS &&
-           getAbsolutePath(*LHS, LHSPath) == getAbsolutePath(*RHS, RHSPath);
+/// Returns line and column of a specified scope, zero means an unknown value.
+std::pair<unsigned, unsigned> getLineColumn(const DILocalScope *Scope) {
+  if (auto *S = dyn_cast<DISubprogram>(Scope))
+    return { S->getScopeLine(), 0u };
+  if (auto *S = dyn_cast<DILexicalBlock>(Scope)) {
+    return { S->getLine(), S->getColumn() };
   }
-  static bool isEqual(const clang::PresumedLoc &LHS, const DILocalScope *RHS) {
-    if (isEqual(RHS, getTombstoneKey()) || isEqual(RHS, getEmptyKey()))
-      return false;
-    auto LineColumn = getLineColumn(RHS);
-    SmallString<128> LHSPath, RHSPath;
-    return (!LineColumn.first || LHS.getLine() == LineColumn.first) &&
-           (!LineColumn.second || LHS.getColumn() == LineColumn.second) &&
-           getNativePath(LHS.getFilename(), LHSPath) ==
-               getAbsolutePath(*RHS, RHSPath);
-  }
-};
+  return { 0u, 0u };
+}
 
 using MatchDIVisitorBase = MatchASTBase<DIVariable *, VarDecl *,
-  DILocalScope *, DILocalScopeMapInfo,
+  FileLocation, DenseMapInfo<FileLocation>,
   unsigned, DenseMapInfo<unsigned>,
   ClangDIMemoryMatcherPass::DIMemoryMatcher,
   ClangDIMemoryMatcherPass::MemoryASTSet>;
@@ -133,9 +94,9 @@ class MatchDIVisitor :
     public MatchDIVisitorBase,
     public RecursiveASTVisitor<MatchDIVisitor> {
 public:
-  MatchDIVisitor(SourceManager &SrcMgr, Matcher &MM,
+  MatchDIVisitor(SourceManager &SrcMgr, FileIDTable &Files, Matcher &MM,
       UnmatchedASTSet &Unmatched, LocToIRMap &LocMap, LocToASTMap &MacroMap) :
-    MatchASTBase(SrcMgr, MM, Unmatched, LocMap, MacroMap) {}
+    MatchASTBase(SrcMgr, Files, MM, Unmatched, LocMap, MacroMap) {}
 
   bool VisitVarDecl(VarDecl *D) {
     mVisitedVars.push_back(D->getCanonicalDecl());
@@ -185,7 +146,7 @@ public:
         Pair.first->second.insert(Pair.first->second.end(),
           mVisitedVars.begin() + StashSize, mVisitedVars.end());
       } else {
-        auto I = findItrForLocation(ScopeLoc);
+        auto I = findScope(ScopeLoc);
         if (I != mLocToIR->end()) {
           auto SearchFromItr = mVisitedVars.begin() + StashSize;
           for (unsigned Idx = 0, IdxE = I->second.size(); Idx < IdxE; ++Idx) {
@@ -216,6 +177,25 @@ public:
     return Res;
   }
 private:
+  /// Finds metadata-level variables declared in a scope at a specified
+  /// location. Scopes with unknown line or column are stored with zero
+  /// values, so they are checked if there is no exact match.
+  LocToIRMap::iterator findScope(SourceLocation Loc) {
+    auto PLoc = mSrcMgr->getPresumedLoc(Loc, false);
+    if (PLoc.isInvalid())
+      return mLocToIR->end();
+    auto Key = mFiles->getLocation(PLoc);
+    auto I = mLocToIR->find(Key);
+    if (I != mLocToIR->end())
+      return I;
+    Key.Column = 0;
+    I = mLocToIR->find(Key);
+    if (I != mLocToIR->end())
+      return I;
+    Key.Line = 0;
+    return mLocToIR->find(Key);
+  }
+
   std::vector<VarDecl *> mVisitedVars;
   SmallVector<SourceLocation, 8> mScopes;
   FunctionDecl *mFuncDecl = nullptr;
@@ -236,10 +216,15 @@ bool ClangDIMemoryMatcherPass::runOnFunction(Function &F) {
   if (!FuncDecl)
     return false;
   auto &SrcMgr = TfmCtx->getRewriter().getSourceMgr();
+  auto &Files = getAnalysis<ClangFileIDTablePass>().getTable(*M, SrcMgr);
   MatchDIVisitor::LocToIRMap LocToDIVar;
   MatchDIVisitor::LocToASTMap LocToMacro;
-  MatchDIVisitor MatchDIVar(SrcMgr,
+  MatchDIVisitor MatchDIVar(SrcMgr, Files,
     mMatcher, mUnmatchedAST, LocToDIVar, LocToMacro);
+  // Location of a function declaration is used to match top-level local
+  // variables, so a subprogram is stored with a column of the declaration.
+  auto FuncPLoc = SrcMgr.getPresumedLoc(
+    SrcMgr.getExpansionLoc(FuncDecl->getLocation()), false);
   SmallPtrSet<DIVariable *, 32> VisitedDIVars;
   for (auto &I : instructions(F)) {
     auto *DbgValue = dyn_cast<DbgValueInst>(&I);
@@ -249,21 +234,21 @@ bool ClangDIMemoryMatcherPass::runOnFunction(Function &F) {
     if (DIVar && VisitedDIVars.insert(DIVar).second) {
       ++NumNonMatchDIMemory;
       if (auto *S = dyn_cast_or_null<DILocalScope>(DIVar->getScope())) {
-        auto Pair =
-            isa<DISubprogram>(S)
-                ? LocToDIVar.insert_as(
-                      std::make_pair(S, TinyPtrVector<DIVariable *>(DIVar)),
-                      SrcMgr.getPresumedLoc(
-                          SrcMgr.getExpansionLoc(FuncDecl->getLocation())))
-                : LocToDIVar.insert(
-                      std::make_pair(S, TinyPtrVector<DIVariable *>(DIVar)));
+        auto LineColumn = getLineColumn(S);
+        FileLocation Key{ Files.getID(*S), LineColumn.first,
+                          LineColumn.second };
+        if (isa<DISubprogram>(S) && FuncPLoc.isValid()) {
+          if (!Key.Line)
+            Key.Line = FuncPLoc.getLine();
+          Key.Column = FuncPLoc.getColumn();
+        }
+        auto Pair = LocToDIVar.insert(
+          std::make_pair(Key, TinyPtrVector<DIVariable *>(DIVar)));
         if (!Pair.second)
           Pair.first->second.push_back(DIVar);
         LLVM_DEBUG(dbgs() << "[DI MEMORY MATCHER]: remember metadata for '"
-                          << DIVar->getName() << "' at ";
-                   auto LineColumn = DILocalScopeMapInfo::getLineColumn(S);
-                   dbgs() << LineColumn.first << ":" << LineColumn.second
-                          << "\n");
+                          << DIVar->getName() << "' at " << Key.Line << ":"
+                          << Key.Column << "\n");
       }
     }
   }
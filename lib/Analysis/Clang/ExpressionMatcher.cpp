@@ -25,6 +25,8 @@
 //===----------------------------------------------------------------------===//
 
 #include "tsar/Analysis/Clang/ExpressionMatcher.h"
+#include "tsar/Analysis/Clang/ASTIndex.h"
+#include "tsar/Analysis/Clang/FileIDTable.h"
 #include "tsar/Analysis/Clang/Matcher.h"
 #include "tsar/Frontend/Clang/TransformationContext.h"
 #include <clang/AST/RecursiveASTVisitor.h>
@@ -44,13 +46,11 @@ STATISTIC(NumNonMatchIRExpr, "Number of non-matched IR expressions");
 STATISTIC(NumNonMatchASTExpr, "Number of non-matched AST expressions");
 
 namespace {
-class MatchExprVisitor :
-  public MatchASTBase<Value *, Stmt *>,
-  public RecursiveASTVisitor<MatchExprVisitor> {
+class MatchExprVisitor : public MatchASTBase<Value *, Stmt *> {
 public:
-  MatchExprVisitor(SourceManager &SrcMgr, Matcher &MM,
+  MatchExprVisitor(SourceManager &SrcMgr, FileIDTable &Files, Matcher &MM,
     UnmatchedASTSet &Unmatched, LocToIRMap &LocMap, LocToASTMap &MacroMap) :
-      MatchASTBase(SrcMgr, MM, Unmatched, LocMap, MacroMap) {}
+      MatchASTBase(SrcMgr, Files, MM, Unmatched, LocMap, MacroMap) {}
 
   /// Evaluates declarations expanded from a macro and stores such
   /// declaration into location to macro map.
@@ -97,9 +97,11 @@ bool ClangExprMatcherPass::runOnFunction(Function &F) {
   if (!TfmCtx || !TfmCtx->hasInstance())
     return false;
   auto &SrcMgr = TfmCtx->getRewriter().getSourceMgr();
+  auto &Files = getAnalysis<ClangFileIDTablePass>().getTable(
+    *F.getParent(), SrcMgr);
   MatchExprVisitor::LocToIRMap LocToExpr;
   MatchExprVisitor::LocToASTMap LocToMacro;
-  MatchExprVisitor MatchExpr(SrcMgr,
+  MatchExprVisitor MatchExpr(SrcMgr, Files,
     mMatcher, mUnmatchedAST, LocToExpr, LocToMacro);
   for (auto &I: instructions(F)) {
     if (!isa<CallBase>(I))
@@ -108,7 +110,7 @@ bool ClangExprMatcherPass::runOnFunction(Function &F) {
     auto Loc = I.getDebugLoc();
     if (Loc) {
       auto Pair = LocToExpr.insert(
-        std::make_pair(Loc, TinyPtrVector<Value *>(&I)));
+        std::make_pair(Files.getLocation(*Loc), TinyPtrVector<Value *>(&I)));
       if (!Pair.second)
         Pair.first->second.push_back(&I);
     }
@@ -120,13 +122,17 @@ bool ClangExprMatcherPass::runOnFunction(Function &F) {
   auto FuncDecl = TfmCtx->getDeclForMangledName(F.getName());
   if (!FuncDecl)
     return false;
-  MatchExpr.TraverseDecl(FuncDecl);
+  // Calls are indexed in the same order as RecursiveASTVisitor visits them.
+  for (auto *E : getAnalysis<ClangASTIndexPass>().getIndex().getCalls())
+    MatchExpr.VisitCallExpr(E);
   MatchExpr.matchInMacro(NumMatchExpr, NumNonMatchASTExpr, NumNonMatchIRExpr);
   return false;
 }
 
 void ClangExprMatcherPass::getAnalysisUsage(AnalysisUsage &AU) const {
   AU.addRequired<TransformationEnginePass>();
+  AU.addRequired<ClangASTIndexPass>();
+  AU.addRequired<ClangFileIDTablePass>();
   AU.setPreservesAll();
 }
 
@@ -135,6 +141,8 @@ char ClangExprMatcherPass::ID = 0;
 INITIALIZE_PASS_BEGIN(ClangExprMatcherPass, "clang-expr-matcher",
   "High and Low Expression Matcher", false , true)
   INITIALIZE_PASS_DEPENDENCY(TransformationEnginePass)
+  INITIALIZE_PASS_DEPENDENCY(ClangASTIndexPass)
+  INITIALIZE_PASS_DEPENDENCY(ClangFileIDTablePass)
 INITIALIZE_PASS_END(ClangExprMatcherPass, "clang-expr-matcher",
   "High and Low Level Expression Matcher", false, true)
 
@@ -0,0 +1,32 @@
+//===--- FileIDTable.cpp -- Table of Source Files ---------------*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2020 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements a pass which owns a table of source files shared
+// between high and low level matchers.
+//
+//===----------------------------------------------------------------------===//
+
+#include "tsar/Analysis/Clang/FileIDTable.h"
+
+using namespace llvm;
+
+char ClangFileIDTablePass::ID = 0;
+INITIALIZE_PASS(ClangFileIDTablePass, "clang-file-id-table",
+  "Source File Table (Clang)", true, true)
@@ -23,6 +23,8 @@
 //===----------------------------------------------------------------------===//
 
 #include "tsar/Analysis/Clang/LoopMatcher.h"
+#include "tsar/Analysis/Clang/ASTIndex.h"
+#include "tsar/Analysis/Clang/FileIDTable.h"
 #include "tsar/Analysis/Clang/Matcher.h"
 #include "tsar/Frontend/Clang/TransformationContext.h"
 #include "tsar/Support/IRUtils.h"
@@ -58,14 +60,14 @@ INITIALIZE_PASS_BEGIN(LoopMatcherPass, "loop-matcher",
   "High and Low Loop Matcher", true, false)
 INITIALIZE_PASS_DEPENDENCY(LoopInfoWrapperPass)
 INITIALIZE_PASS_DEPENDENCY(TransformationEnginePass)
+INITIALIZE_PASS_DEPENDENCY(ClangASTIndexPass)
+INITIALIZE_PASS_DEPENDENCY(ClangFileIDTablePass)
 INITIALIZE_PASS_END(LoopMatcherPass, "loop-matcher",
   "High and Low Level Loop Matcher", true, false)
 
 namespace {
 /// This matches explicit for, while and do-while loops.
-class MatchExplicitVisitor :
-  public MatchASTBase<Loop *, Stmt *>,
-  public RecursiveASTVisitor<MatchExplicitVisitor> {
+class MatchExplicitVisitor : public MatchASTBase<Loop *, Stmt *> {
 public:
 
   /// Constructor.
@@ -82,10 +84,10 @@ public:
   /// in this map. These loops will not inserted in LM map and must be evaluated
   /// further. The key in this map is a raw encoding for expansion location.
   /// To decode it use SourceLocation::getFromRawEncoding() method.
-  MatchExplicitVisitor(SourceManager &SrcMgr,
+  MatchExplicitVisitor(SourceManager &SrcMgr, FileIDTable &Files,
       Matcher &LM, UnmatchedASTSet &Unmatched,
       LocToIRMap &LocMap, LocToIRMap &ImplicitMap, LocToASTMap &MacroMap) :
-    MatchASTBase(SrcMgr, LM, Unmatched, LocMap, MacroMap),
+    MatchASTBase(SrcMgr, Files, LM, Unmatched, LocMap, MacroMap),
     mLocToImplicit(&ImplicitMap) {}
 
   /// \brief Evaluates statements expanded from a macro.
@@ -141,8 +143,11 @@ public:
             PresumedLoc PLoc = mSrcMgr->getPresumedLoc(S->getBeginLoc(), false);
             auto Tmp = std::move(LpItr->second);
             mLocToIR->erase(LpItr);
-            if (HeaderLoc && DILocationMapInfo::isEqual(PLoc, HeaderLoc))
-              mLocToIR->insert(std::make_pair(HeaderLoc, std::move(Tmp)));
+            if (HeaderLoc && PLoc.isValid()) {
+              auto Key = mFiles->getLocation(*HeaderLoc);
+              if (Key == mFiles->getLocation(PLoc))
+                mLocToIR->insert(std::make_pair(Key, std::move(Tmp)));
+            }
           }
           return true;
         }
@@ -174,9 +179,8 @@ public:
         auto HeaderLoc = HeadBB ?
           HeadBB->getTerminator()->getDebugLoc().get() : nullptr;
         if (HeaderLoc) {
-          auto Pair =
-            mLocToImplicit->insert(
-              std::make_pair(HeaderLoc, TinyPtrVector<Loop *>(L)));
+          auto Pair = mLocToImplicit->insert(std::make_pair(
+            mFiles->getLocation(*HeaderLoc), TinyPtrVector<Loop *>(L)));
           if (!Pair.second)
             Pair.first->second.push_back(L);
         }
@@ -189,13 +193,13 @@ private:
 };
 
 /// This matches implicit loops.
-class MatchImplicitVisitor :
-  public MatchASTBase<Loop *, Stmt *>,
-  public RecursiveASTVisitor<MatchImplicitVisitor> {
+class MatchImplicitVisitor : public MatchASTBase<Loop *, Stmt *> {
 public:
-  MatchImplicitVisitor(SourceManager &SrcMgr, Matcher &LM,
-    UnmatchedASTSet &Unmatched, LocToIRMap &LocMap, LocToASTMap &MacroMap) :
-    MatchASTBase(SrcMgr, LM, Unmatched, LocMap, MacroMap), mLastLabel(nullptr) {}
+  MatchImplicitVisitor(SourceManager &SrcMgr, FileIDTable &Files,
+    Matcher &LM, UnmatchedASTSet &Unmatched, LocToIRMap &LocMap,
+    LocToASTMap &MacroMap) :
+    MatchASTBase(SrcMgr, Files, LM, Unmatched, LocMap, MacroMap),
+    mLastLabel(nullptr) {}
 
   bool VisitStmt(Stmt *S) {
     // We try to find a label which is a start of the loop header.
@@ -277,14 +281,16 @@ bool LoopMatcherPass::runOnFunction(Function &F) {
   if (!mFuncDecl)
     return false;
   auto &LpInfo = getAnalysis<LoopInfoWrapperPass>().getLoopInfo();
+  auto &SrcMgr = TfmCtx->getRewriter().getSourceMgr();
+  auto &Files = getAnalysis<ClangFileIDTablePass>().getTable(*M, SrcMgr);
   MatchExplicitVisitor::LocToIRMap LocToLoop;
-  for_each_loop(LpInfo, [&LocToLoop](Loop *L) {
+  for_each_loop(LpInfo, [&LocToLoop, &Files](Loop *L) {
     auto Loc = L->getStartLoc();
     // If an appropriate loop will be found the counter will be decreased.
     ++NumNonMatchIRLoop;
     if (Loc) {
       auto Pair = LocToLoop.insert(
-        std::make_pair(Loc, TinyPtrVector<Loop *>(L)));
+        std::make_pair(Files.getLocation(*Loc), TinyPtrVector<Loop *>(L)));
       // In some cases different loops have the same locations. For example,
       // if these loops have been produced by one loop from a file that had been
       // included multiple times. The other case is a loop defined in macro.
@@ -297,17 +303,21 @@ bool LoopMatcherPass::runOnFunction(Function &F) {
   // children).
   for (auto &Pair : LocToLoop)
     std::reverse(Pair.second.begin(), Pair.second.end());
-  auto &SrcMgr = TfmCtx->getRewriter().getSourceMgr();
   MatchExplicitVisitor::LocToIRMap LocToImplicit;
   MatchExplicitVisitor::LocToASTMap LocToMacro;
-  MatchExplicitVisitor MatchExplicit(SrcMgr, mMatcher, mUnmatchedAST,
+  MatchExplicitVisitor MatchExplicit(SrcMgr, Files, mMatcher, mUnmatchedAST,
     LocToLoop, LocToImplicit, LocToMacro);
-  MatchExplicit.TraverseDecl(mFuncDecl);
-  MatchImplicitVisitor MatchImplicit(SrcMgr, mMatcher, mUnmatchedAST,
+  // Statements are indexed in the same order as RecursiveASTVisitor visits
+  // them, so both visitors observe AST as if it is traversed.
+  auto &Stmts = getAnalysis<ClangASTIndexPass>().getIndex().getStmts();
+  for (auto *S : Stmts)
+    MatchExplicit.VisitStmt(S);
+  MatchImplicitVisitor MatchImplicit(SrcMgr, Files, mMatcher, mUnmatchedAST,
     LocToImplicit, LocToMacro);
   for (auto &Pair: LocToImplicit)
     std::reverse(Pair.second.begin(), Pair.second.end());
-  MatchImplicit.TraverseDecl(mFuncDecl);
+  for (auto *S : Stmts)
+    MatchImplicit.VisitStmt(S);
   for (auto &Pair : LocToMacro)
     std::reverse(Pair.second.begin(), Pair.second.end());
   MatchExplicit.matchInMacro(
@@ -318,6 +328,8 @@ bool LoopMatcherPass::runOnFunction(Function &F) {
 void LoopMatcherPass::getAnalysisUsage(AnalysisUsage &AU) const {
   AU.addRequired<LoopInfoWrapperPass>();
   AU.addRequired<TransformationEnginePass>();
+  AU.addRequired<ClangASTIndexPass>();
+  AU.addRequired<ClangFileIDTablePass>();
   AU.setPreservesAll();
 }
 
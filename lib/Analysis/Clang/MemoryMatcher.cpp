@@ -23,6 +23,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "tsar/Analysis/Clang/MemoryMatcher.h"
+#include "tsar/Analysis/Clang/FileIDTable.h"
 #include "tsar/Analysis/Clang/Matcher.h"
 #include "tsar/Analysis/Clang/Passes.h"
 #include "tsar/Frontend/Clang/TransformationContext.h"
@@ -113,6 +114,7 @@ char MemoryMatcherPass::ID = 0;
 INITIALIZE_PASS_BEGIN(MemoryMatcherPass, "memory-matcher",
   "High and Low Memory Matcher", false , true)
   INITIALIZE_PASS_DEPENDENCY(TransformationEnginePass)
+  INITIALIZE_PASS_DEPENDENCY(ClangFileIDTablePass)
   INITIALIZE_PASS_DEPENDENCY(MemoryMatcherImmutableStorage)
   INITIALIZE_PASS_DEPENDENCY(MemoryMatcherImmutableWrapper)
 INITIALIZE_PASS_END(MemoryMatcherPass, "memory-matcher",
@@ -128,9 +130,9 @@ class MatchAllocaVisitor :
   public MatchASTBase<Value *, VarDecl *>,
   public RecursiveASTVisitor<MatchAllocaVisitor> {
 public:
-  MatchAllocaVisitor(SourceManager &SrcMgr, Matcher &MM,
+  MatchAllocaVisitor(SourceManager &SrcMgr, FileIDTable &Files, Matcher &MM,
     UnmatchedASTSet &Unmatched, LocToIRMap &LocMap, LocToASTMap &MacroMap) :
-      MatchASTBase(SrcMgr, MM, Unmatched, LocMap, MacroMap) {}
+      MatchASTBase(SrcMgr, Files, MM, Unmatched, LocMap, MacroMap) {}
 
   /// Evaluates declarations expanded from a macro and stores such
   /// declaration into location to macro map.
@@ -183,8 +185,8 @@ public:
         auto Var = DIIList.front()->getVariable();
         auto Loc = DIIList.front()->getDebugLoc();
         if (Var && Loc) {
-          auto Pair = mLocToIR->insert(
-            std::make_pair(Loc, TinyPtrVector<Value *>(&I)));
+          auto Pair = mLocToIR->insert(std::make_pair(
+            mFiles->getLocation(*Loc), TinyPtrVector<Value *>(&I)));
           if (!Pair.second)
             Pair.first->second.push_back(&I);
           ValueToName.try_emplace(&I, Var->getName());
@@ -212,12 +214,13 @@ bool MemoryMatcherPass::runOnModule(llvm::Module &M) {
   if (!TfmCtx || !TfmCtx->hasInstance())
     return false;
   auto &SrcMgr = TfmCtx->getRewriter().getSourceMgr();
+  auto &Files = getAnalysis<ClangFileIDTablePass>().getTable(M, SrcMgr);
   for (Function &F : M) {
     if (F.empty())
       continue;
     MatchAllocaVisitor::LocToIRMap LocToAlloca;
     MatchAllocaVisitor::LocToASTMap LocToMacro;
-    MatchAllocaVisitor MatchAlloca(SrcMgr,
+    MatchAllocaVisitor MatchAlloca(SrcMgr, Files,
       MatchInfo.Matcher, MatchInfo.UnmatchedAST, LocToAlloca, LocToMacro);
     MatchAlloca.buildAllocaMap(F);
     // It is necessary to build LocToAlloca map also if FuncDecl is null,
@@ -256,6 +259,7 @@ bool MemoryMatcherPass::runOnModule(llvm::Module &M) {
 
 void MemoryMatcherPass::getAnalysisUsage(AnalysisUsage &AU) const {
   AU.addRequired<TransformationEnginePass>();
+  AU.addRequired<ClangFileIDTablePass>();
   AU.addRequired<MemoryMatcherImmutableStorage>();
   AU.addRequired<MemoryMatcherImmutableWrapper>();
   AU.setPreservesAll();
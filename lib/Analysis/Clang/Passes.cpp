@@ -31,6 +31,8 @@ void llvm::initializeClangAnalysis(PassRegistry &Registry) {
   initializeClangGlobalInfoPassPass(Registry);
   initializeClangDIMemoryMatcherPassPass(Registry);
   initializeClangDIGlobalMemoryMatcherPassPass(Registry);
+  initializeClangASTIndexPassPass(Registry);
+  initializeClangFileIDTablePassPass(Registry);
   initializeClangExprMatcherPassPass(Registry);
   initializeLoopMatcherPassPass(Registry);
   initializeClangPerfectLoopPassPass(Registry);
@@ -0,0 +1,89 @@
+//===- AliasQueryCache.cpp - Memoized Alias Queries -------------*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2020 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements a front-end for alias analysis which memoizes results
+// of alias and mod/ref queries.
+//
+//===----------------------------------------------------------------------===//
+
+#include "tsar/Analysis/Memory/AliasQueryCache.h"
+#include <llvm/ADT/Statistic.h>
+#include <llvm/IR/InstrTypes.h>
+
+using namespace llvm;
+using namespace tsar;
+
+#undef DEBUG_TYPE
+#define DEBUG_TYPE "alias-query-cache"
+
+STATISTIC(NumAliasQueries, "Number of alias queries");
+STATISTIC(NumAliasHits, "Number of alias queries answered from cache");
+STATISTIC(NumGlobalAliasHits,
+  "Number of alias queries answered from module-level cache");
+STATISTIC(NumModRefQueries, "Number of mod/ref queries");
+STATISTIC(NumModRefHits, "Number of mod/ref queries answered from cache");
+
+AliasResult AliasQueryCache::alias(const MemoryLocation &LHS,
+    const MemoryLocation &RHS) {
+  ++NumAliasQueries;
+  if (mGlobalCache && GlobalAliasCache::isGlobal(LHS, RHS)) {
+    if (auto AR = mGlobalCache->find(mGlobalScope, LHS, RHS)) {
+      ++NumGlobalAliasHits;
+      return *AR;
+    }
+    auto AR = mAA->alias(LHS, RHS);
+    mGlobalCache->insert(mGlobalScope, LHS, RHS, AR);
+    return AR;
+  }
+  auto Itr = mAliasCache.find(std::make_pair(LHS, RHS));
+  if (Itr != mAliasCache.end()) {
+    ++NumAliasHits;
+    return Itr->second;
+  }
+  auto AR = mAA->alias(LHS, RHS);
+  mAliasCache.try_emplace(std::make_pair(LHS, RHS), AR);
+  return AR;
+}
+
+ModRefInfo AliasQueryCache::getModRefInfo(const Instruction *I,
+    const MemoryLocation &Loc) {
+  ++NumModRefQueries;
+  auto Itr = mModRefCache.find(std::make_pair(I, Loc));
+  if (Itr != mModRefCache.end()) {
+    ++NumModRefHits;
+    return Itr->second;
+  }
+  auto MRI = mAA->getModRefInfo(I, Loc);
+  mModRefCache.try_emplace(std::make_pair(I, Loc), MRI);
+  return MRI;
+}
+
+ModRefInfo AliasQueryCache::getModRefInfo(const CallBase *Call1,
+    const CallBase *Call2) {
+  ++NumModRefQueries;
+  auto Itr = mCallModRefCache.find(std::make_pair(Call1, Call2));
+  if (Itr != mCallModRefCache.end()) {
+    ++NumModRefHits;
+    return Itr->second;
+  }
+  auto MRI = mAA->getModRefInfo(Call1, Call2);
+  mCallModRefCache.try_emplace(std::make_pair(Call1, Call2), MRI);
+  return MRI;
+}
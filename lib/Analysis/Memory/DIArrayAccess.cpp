@@ -537,6 +537,7 @@ bool DIArrayAccessCollector::runOnModule(Module &M) {
       });
   DIArrayAccessCollectorProvider::initialize<DIMemoryEnvironmentWrapper>(
       [&DIMEnv](DIMemoryEnvironmentWrapper &Wrapper) { Wrapper.set(*DIMEnv); });
+  OnTheFlyPassCache Providers;
   for (auto &F : M) {
     if (F.empty())
       continue;
@@ -544,7 +545,8 @@ bool DIArrayAccessCollector::runOnModule(Module &M) {
     if (!DISub)
       continue;
     auto &TLI = getAnalysis<TargetLibraryInfoWrapperPass>().getTLI(F);
-    auto &Provider = getAnalysis<DIArrayAccessCollectorProvider>(F);
+    auto &Provider =
+        Providers.getAnalysis<DIArrayAccessCollectorProvider>(*this, F);
     auto &DT = Provider.get<DominatorTreeWrapperPass>().getDomTree();
     auto &DI = Provider.get<DelinearizationPass>().getDelinearizeInfo();
     auto &AT = Provider.get<EstimateMemoryPass>().getAliasTree();
@@ -46,6 +46,7 @@
 #include "tsar/Unparse/SourceUnparser.h"
 #include "tsar/Unparse/Utils.h"
 #include <bcl/tagged.h>
+#include <llvm/ADT/BitVector.h>
 #include <llvm/ADT/PostOrderIterator.h>
 #include <llvm/ADT/Statistic.h>
 #include <llvm/Analysis/ScalarEvolution.h>
@@ -65,6 +66,7 @@ using namespace tsar;
 #define DEBUG_TYPE "da-di"
 
 MEMORY_TRAIT_STATISTIC(NumTraits)
+STATISTIC(NumSkippedNodes, "Number of alias nodes skipped in loops");
 
 char DIDependencyAnalysisPass::ID = 0;
 INITIALIZE_PASS_IN_GROUP_BEGIN(DIDependencyAnalysisPass, "da-di",
@@ -1739,14 +1741,15 @@ void DIDependencyAnalysisPass::propagateReduction(PHINode *Phi,
 }
 
 void DIDependencyAnalysisPass::analyzeNode(DIAliasMemoryNode &DIN,
-    Optional<unsigned> DWLang,
+    AliasNode *AN, Optional<unsigned> DWLang,
     const SpanningTreeRelation<AliasTree *> &AliasSTR,
     const SpanningTreeRelation<const tsar::DIAliasTree *> &DIAliasSTR,
     ArrayRef<const DIMemory *> LockedTraits, const GlobalOptions &GlobalOpts,
     DependenceSet &DepSet, DIDependenceSet &DIDepSet,
     DIMemoryTraitRegionPool &Pool) {
   assert(!DIN.empty() && "Alias node must contain memory locations!");
-  auto *AN = findBoundAliasNode(*mAT, AliasSTR, DIN);
+  assert(AN == findBoundAliasNode(*mAT, AliasSTR, DIN) &&
+    "Alias node must be bound to a metadata-level node!");
   auto ATraitItr = AN ? DepSet.find_as(AN) : DepSet.end();
   DIDependenceSet::iterator DIATraitItr = DIDepSet.end();
   SmallPtrSet<const Value *, 16> MustNoAccessValues;
@@ -1996,6 +1999,29 @@ bool DIDependencyAnalysisPass::runOnFunction(Function &F) {
   std::deque<DFLoop *> LQ;
   for (auto *DFN : DFF->getRegions())
     addLoopIntoQueue(DFN, LQ);
+  // Nodes of a metadata-level alias tree in post order and IR-level alias
+  // nodes which are bound to them. These nodes are the same for all loops,
+  // so calculate them once.
+  std::vector<DIAliasMemoryNode *> DINodes;
+  std::vector<AliasNode *> BoundNodes;
+  DenseMap<const DIAliasNode *, unsigned> DINodeToIdx;
+  DenseMap<const AliasNode *, SmallVector<unsigned, 1>> BoundToDINodes;
+  DenseMap<DIVariable *, DIMemory *> VarToMemory;
+  for (auto *DIN : post_order(&DIAT)) {
+    if (isa<DIAliasTopNode>(DIN))
+      continue;
+    auto &DIMN = cast<DIAliasMemoryNode>(*DIN);
+    auto *AN = findBoundAliasNode(*mAT, AliasSTR, DIMN);
+    DINodeToIdx.try_emplace(DIN, DINodes.size());
+    if (AN)
+      BoundToDINodes[AN].push_back(DINodes.size());
+    DINodes.push_back(&DIMN);
+    BoundNodes.push_back(AN);
+    for (auto &DIM : DIMN)
+      if (auto *DIEM = dyn_cast<DIEstimateMemory>(&DIM))
+        if (DIEM->getExpression()->getNumElements() == 0)
+          VarToMemory.try_emplace(DIEM->getVariable(), DIEM);
+  }
   for (auto *DFL : LQ) {
     auto L = DFL->getLoop();
     /// TODO (kaniandr@gmail.com): use other identifier because LLVM identifier
@@ -2022,17 +2048,31 @@ bool DIDependencyAnalysisPass::runOnFunction(Function &F) {
     auto &DepSet = PI.find(DFL)->get<DependenceSet>();
     auto &DIDepSet = mDeps.try_emplace(DILoop, DepSet.size()).first->second;
     analyzePromoted(L, DWLang, DIAliasSTR, LockedTraits, *Pool);
-    DenseMap<DIVariable *, DIMemory *> VarToMemory;
-    for (auto *DIN : post_order(&DIAT)) {
-      if (isa<DIAliasTopNode>(DIN))
-        continue;
-      analyzeNode(cast<DIAliasMemoryNode>(*DIN), DWLang, AliasSTR, DIAliasSTR,
-        LockedTraits, GlobalOpts, DepSet, DIDepSet, *Pool);
-      for (auto &DIM : cast<DIAliasMemoryNode>(*DIN))
-        if (auto *DIEM = dyn_cast<DIEstimateMemory>(&DIM))
-          if (DIEM->getExpression()->getNumElements() == 0)
-            VarToMemory.try_emplace(DIEM->getVariable(), DIEM);
+    // Analysis of a node has no effect if the node is not accessed in the
+    // loop, there are no known traits for its memory and there are no traits
+    // for its descendants. So, visit nodes which are bound to accessed IR-level
+    // nodes or contain memory from the pool, and ancestors of these nodes.
+    BitVector IsRelevant(DINodes.size());
+    auto markRelevant = [&DINodeToIdx, &IsRelevant](const DIAliasNode *N) {
+      for (; N; N = N->getParent()) {
+        auto I = DINodeToIdx.find(N);
+        if (I == DINodeToIdx.end() || IsRelevant.test(I->second))
+          break;
+        IsRelevant.set(I->second);
+      }
+    };
+    for (auto &ATrait : DepSet) {
+      auto I = BoundToDINodes.find(ATrait.getNode());
+      if (I != BoundToDINodes.end())
+        for (auto Idx : I->second)
+          markRelevant(DINodes[Idx]);
     }
+    for (auto &T : *Pool)
+      markRelevant(T.getMemory()->getAliasNode());
+    NumSkippedNodes += DINodes.size() - IsRelevant.count();
+    for (auto Idx : IsRelevant.set_bits())
+      analyzeNode(*DINodes[Idx], BoundNodes[Idx], DWLang, AliasSTR, DIAliasSTR,
+        LockedTraits, GlobalOpts, DepSet, DIDepSet, *Pool);
     LLVM_DEBUG(dbgs() << "[DA DI]: set traits for a top level node\n");
     auto TopDIN = DIAT.getTopLevelNode();
     auto TopTraitItr = DIDepSet.insert(DIAliasTrait(TopDIN)).first;
@@ -2056,17 +2096,28 @@ bool DIDependencyAnalysisPass::runOnFunction(Function &F) {
     }
     std::vector<const DIAliasNode *> Coverage;
     explicitAccessCoverage(DIDepSet, DIAT, Coverage,
-      GlobalOpts.IgnoreRedundantMemory);
+      GlobalOpts.IgnoreRedundantMemory,
+      [&DINodeToIdx, &IsRelevant](const DIAliasNode &N) {
+        auto I = DINodeToIdx.find(&N);
+        return I != DINodeToIdx.end() && IsRelevant.test(I->second);
+      });
     // All descendant nodes for nodes in `Coverage` access some part of
     // explicitly accessed memory. The conservativeness of analysis implies
     // that memory accesses from this nodes arise loop carried dependencies.
-    for (auto *N : Coverage)
-      for (auto &Child : make_range(N->child_begin(), N->child_end()))
-        for (auto *Descendant : make_range(df_begin(&Child), df_end(&Child))) {
-          auto I = DIDepSet.find_as(Descendant);
-          if (I != DIDepSet.end() && !I->is<trait::NoAccess>())
-            I->set<trait::Flow, trait::Anti, trait::Output>();
-        }
+    // Only nodes with traits should be updated, so check ancestors of these
+    // nodes instead of traversal of all descendants of covering nodes.
+    SmallPtrSet<const DIAliasNode *, 8> CoverageSet(Coverage.begin(),
+      Coverage.end());
+    if (!CoverageSet.empty())
+      for (auto &DIATrait : DIDepSet) {
+        if (DIATrait.is<trait::NoAccess>())
+          continue;
+        for (auto *N = DIATrait.getNode()->getParent(); N; N = N->getParent())
+          if (CoverageSet.count(N)) {
+            DIATrait.set<trait::Flow, trait::Anti, trait::Output>();
+            break;
+          }
+      }
   }
   return false;
 }
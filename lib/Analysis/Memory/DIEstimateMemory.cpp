@@ -125,20 +125,32 @@ std::unique_ptr<DIUnknownMemory> DIUnknownMemory::get(llvm::LLVMContext &Ctx,
     new DIUnknownMemory(Env, UM.getAsMDNode()));
 }
 
-static void serialize(DILocation &Loc, LLVMContext &Ctx,
-  SmallVectorImpl<Metadata *> &MDs) {
-  auto LineMD = ConstantAsMetadata::get(
-    ConstantInt::get(Type::getInt32Ty(Ctx), Loc.getLine()));
-  MDs.push_back(LineMD);
-  auto ColumnMD = ConstantAsMetadata::get(
-    ConstantInt::get(Type::getInt32Ty(Ctx), Loc.getColumn()));
-  MDs.push_back(ColumnMD);
+/// Serializes a specified location.
+///
+/// If `IfExists` is set, new metadata are not created in the context. This is
+/// used to search for existing memory, so metadata which are never freed do
+/// not appear after each search. Note, that integer constants are still
+/// created with ConstantInt::get() because there is no way to look up
+/// a constant without creating it. Such constants are uniqued, so at most one
+/// constant is created for each line and column.
+/// \return False if `IfExists` is set and some metadata do not exist, so there
+/// is no memory which is attached to a specified location.
+static bool serialize(DILocation &Loc, LLVMContext &Ctx,
+    SmallVectorImpl<Metadata *> &MDs, bool IfExists = false) {
+  for (unsigned Value : { Loc.getLine(), Loc.getColumn() }) {
+    auto *C = ConstantInt::get(Type::getInt32Ty(Ctx), Value);
+    auto *MD = IfExists ? ConstantAsMetadata::getIfExists(C) :
+      ConstantAsMetadata::get(C);
+    if (!MD)
+      return false;
+    MDs.push_back(MD);
+  }
   if (auto *Scope = Loc.getRawScope())
     MDs.push_back(Scope);
   if (auto *InlineAt = Loc.getInlinedAt())
-    serialize(*InlineAt, Ctx, MDs);
-  else
-    MDs.push_back(nullptr);
+    return serialize(*InlineAt, Ctx, MDs, IfExists);
+  MDs.push_back(nullptr);
+  return true;
 }
 
 std::unique_ptr<DIUnknownMemory> DIUnknownMemory::get(llvm::LLVMContext &Ctx,
@@ -175,8 +187,8 @@ llvm::MDNode * DIUnknownMemory::getRawIfExists(llvm::LLVMContext &Ctx,
     return nullptr;
   SmallVector<Metadata *, 2> MDs{ BasicMD };
   for (auto DbgLoc : DbgLocs)
-    if (DbgLoc)
-      serialize(*DbgLoc, Ctx, MDs);
+    if (DbgLoc && !serialize(*DbgLoc, Ctx, MDs, true))
+      return nullptr;
   return llvm::MDNode::getIfExists(Ctx, MDs);
 }
 
@@ -280,8 +292,8 @@ llvm::MDNode * DIEstimateMemory::getRawIfExists(llvm::LLVMContext &Ctx,
     return nullptr;
   SmallVector<Metadata *, 2> MDs{ BasicMD };
   for (auto DbgLoc : DbgLocs)
-    if (DbgLoc)
-      serialize(*DbgLoc, Ctx, MDs);
+    if (DbgLoc && !serialize(*DbgLoc, Ctx, MDs, true))
+      return nullptr;
   return llvm::MDNode::getIfExists(Ctx, MDs);
 }
 
@@ -366,6 +378,10 @@ void DIMemory::setFlags(uint64_t F) {
   auto OpIdx = getFlagsOp();
   auto CMD = cast<ConstantAsMetadata>(MD->getOperand(OpIdx));
   auto CInt = cast<ConstantInt>(CMD->getValue());
+  // Do not create a new constant and do not re-unique the node if flags are
+  // not changed. Metadata are never freed from the context.
+  if ((CInt->getZExtValue() | F) == CInt->getZExtValue())
+    return;
   auto &Ctx = MD->getContext();
   auto *FlagMD = llvm::ConstantAsMetadata::get(llvm::ConstantInt::get(
    Type::getInt64Ty(Ctx), CInt->getZExtValue() | F));
@@ -394,32 +410,11 @@ const llvm::MDNode * DIUnknownMemory::getMetadata() const {
 
 void DIMemoryHandleBase::addToUseList() {
   assert(mMemory && "Null pointer does not have handles!");
-  auto &Env = mMemory->getEnv();
-  if (mMemory->hasMemoryHandle()) {
-    DIMemoryHandleBase *&Entry = Env[mMemory];
-    assert(mMemory && "Memory does not have any handles?");
-    addToExistingUseList(&Entry);
-    return;
-  }
-  // Ok, it doesn't have any handles yet, so we must insert it into the
-  // DenseMap. However, doing this insertion could cause the DenseMap to
-  // reallocate itself, which would invalidate all of the PrevP pointers that
-  // point into the old table. Handle this by checking for reallocation and
-  // updating the stale pointers only if needed.
-  auto &Handles = Env.getMemoryHandles();
-  const void *OldBucketPtr = Handles.getPointerIntoBucketsArray();
-  DIMemoryHandleBase *&Entry = Handles[mMemory];
-  assert(!Entry && "Memory really did already have handles?");
-  addToExistingUseList(&Entry);
-  mMemory->setHasMemoryHandle(true);
-  if (Handles.isPointerIntoBucketsArray(OldBucketPtr) || Handles.size() == 1)
-    return;
-  // Okay, reallocation did happen. Fix the Prev Pointers.
-  for (auto I = Handles.begin(), E = Handles.end(); I != E; ++I) {
-    assert(I->second && I->first == I->second->mMemory &&
-      "List invariant broken!");
-    I->second->setPrevPtr(&I->second);
-  }
+  // The head of the list is stored in the memory, so there is no need to
+  // look up a map and to update stale pointers after its reallocation.
+  if (!mMemory->hasMemoryHandle())
+    ++mMemory->getEnv().mNumHandledMemory;
+  addToExistingUseList(&mMemory->mHandles);
 }
 
 void DIMemoryHandleBase::removeFromUseList() {
@@ -434,19 +429,18 @@ void DIMemoryHandleBase::removeFromUseList() {
     return;
   }
   // If the mNext pointer was null, then it is possible that this was the last
-  // MemoryHandle watching memory. If so, delete its entry from
-  // the MemoryHandles map.
-  auto &Handles = mMemory->getEnv().getMemoryHandles();
-  if (Handles.isPointerIntoBucketsArray(PrevPtr)) {
-    Handles.erase(mMemory);
-    mMemory->setHasMemoryHandle(false);
+  // MemoryHandle watching memory. If so, the list in the memory is empty now.
+  if (PrevPtr == &mMemory->mHandles) {
+    assert(mMemory->getEnv().mNumHandledMemory > 0 &&
+      "Number of memory locations with handles is broken!");
+    --mMemory->getEnv().mNumHandledMemory;
   }
 }
 
 void DIMemoryHandleBase::memoryIsDeleted(DIMemory *M) {
   assert(M->hasMemoryHandle() &&
     "Should only be called if DIMemoryHandles present!");
-  DIMemoryHandleBase *Entry = M->getEnv()[M];
+  DIMemoryHandleBase *Entry = M->mHandles;
   assert(Entry && "Memory bit set but no entries exist");
   // We use a local DIMemoryHandleBase as an iterator so that
   // DIMemoryHandles can add and remove themselves from the list without
@@ -474,7 +468,7 @@ void DIMemoryHandleBase::memoryIsDeleted(DIMemory *M) {
     dbgs() << "While deleting: ";
     TSAR_LLVM_DUMP(M->getAsMDNode()->dump());
     TSAR_LLVM_DUMP(M->getBaseAsMDNode()->dump());
-    if (M->getEnv()[M]->getKind() == Assert)
+    if (M->mHandles->getKind() == Assert)
       llvm_unreachable("An asserting memory handle still pointed to this memory!");
 #endif
     llvm_unreachable("All references to M were not removed?");
@@ -485,7 +479,7 @@ void DIMemoryHandleBase::memoryIsRAUWd(DIMemory *Old, DIMemory *New) {
   assert(Old->hasMemoryHandle() &&
     "Should only be called if MemoryHandles present!");
   assert(Old != New && "Changing value into itself!");
-  DIMemoryHandleBase *Entry = Old->getEnv()[Old];
+  DIMemoryHandleBase *Entry = Old->mHandles;
   assert(Entry && "Memory bit set but no entries exist");
   // We use a local DIMemoryHandleBase as an iterator so that
   // DIMemoryHandles can add and remove themselves from the list without
@@ -512,7 +506,7 @@ void DIMemoryHandleBase::memoryIsRAUWd(DIMemory *Old, DIMemory *New) {
   // If any new weak value handles were added while processing the
   // list, then complain about it now.
   if (Old->hasMemoryHandle())
-    for (Entry = Old->getEnv()[Old]; Entry; Entry = Entry->mNext)
+    for (Entry = Old->mHandles; Entry; Entry = Entry->mNext)
       switch (Entry->getKind()) {
       case Weak:
         dbgs() << "After RAUW from ";
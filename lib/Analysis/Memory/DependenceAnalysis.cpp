@@ -55,10 +55,13 @@
 #include "tsar/Analysis/Memory/DefinedMemory.h"
 #include "tsar/Analysis/Memory/Delinearization.h"
 #include "tsar/Analysis/Memory/DependenceAnalysis.h"
+#include "tsar/Analysis/Memory/DependenceShapeCache.h"
 #include "tsar/Analysis/Memory/EstimateMemory.h"
+#include "tsar/Analysis/Memory/Passes.h"
 #include "tsar/Analysis/Memory/Utils.h"
 #include "tsar/Support/SCEVUtils.h"
 #include "tsar/Support/GlobalOptions.h"
+#include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/Statistic.h"
 #include "llvm/Analysis/AliasAnalysis.h"
@@ -69,6 +72,7 @@
 #include "llvm/Analysis/ValueTracking.h"
 #include "llvm/Config/llvm-config.h"
 #include "llvm/IR/InstIterator.h"
+#include "llvm/IR/Intrinsics.h"
 #include "llvm/IR/Module.h"
 #include "llvm/IR/Operator.h"
 #include "llvm/InitializePasses.h"
@@ -117,11 +121,23 @@ STATISTIC(GCDindependence, "GCD independence");
 STATISTIC(BanerjeeApplications, "Banerjee applications");
 STATISTIC(BanerjeeIndependence, "Banerjee independence");
 STATISTIC(BanerjeeSuccesses, "Banerjee successes");
+STATISTIC(ShapeCacheHits, "Dependence tests found in shape cache");
+STATISTIC(ShapeCacheMisses, "Dependence tests missed in shape cache");
 
 static cl::opt<bool>
     Delinearize("delinearize-da", cl::init(true), cl::Hidden, cl::ZeroOrMore,
                 cl::desc("Try to delinearize array references."));
 
+static cl::opt<bool>
+    UseShapeCache("da-shape-cache", cl::init(true), cl::Hidden, cl::ZeroOrMore,
+                  cl::desc("Share results of dependence tests with the same "
+                           "shape between runs of the analysis."));
+
+static cl::opt<unsigned> ShapeCacheLimit("da-shape-cache-limit",
+    cl::init(1u << 16), cl::Hidden, cl::ZeroOrMore,
+    cl::desc("Maximum number of dependence tests in the shape cache "
+             "(the cache is cleared when the limit is reached)."));
+
 //===----------------------------------------------------------------------===//
 // basics
 
@@ -146,11 +162,58 @@ INITIALIZE_PASS_DEPENDENCY(TargetLibraryInfoWrapperPass)
 INITIALIZE_PASS_DEPENDENCY(EstimateMemoryPass)
 INITIALIZE_PASS_DEPENDENCY(DefinedMemoryPass)
 INITIALIZE_PASS_DEPENDENCY(DFRegionInfoPass)
+INITIALIZE_PASS_DEPENDENCY(DependenceShapeCacheWrapper)
 INITIALIZE_PASS_END(DependenceAnalysisWrapperPass, "da", "Dependence Analysis",
                     true, true)
 
 char DependenceAnalysisWrapperPass::ID = 0;
 
+namespace {
+/// Storage of dependence tests results which is shared between different
+/// stages of analysis.
+class DependenceShapeCacheStorage : public ImmutablePass {
+public:
+  static char ID;
+
+  DependenceShapeCacheStorage() : ImmutablePass(ID) {
+    initializeDependenceShapeCacheStoragePass(
+        *PassRegistry::getPassRegistry());
+  }
+
+  void initializePass() override {
+    getAnalysis<DependenceShapeCacheWrapper>().set(mCache);
+  }
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.addRequired<DependenceShapeCacheWrapper>();
+  }
+
+  /// Return shared results of dependence tests.
+  DependenceShapeCache & getCache() noexcept { return mCache; }
+
+  /// Return shared results of dependence tests.
+  const DependenceShapeCache & getCache() const noexcept { return mCache; }
+
+private:
+  DependenceShapeCache mCache;
+};
+}
+
+char DependenceShapeCacheStorage::ID = 0;
+INITIALIZE_PASS_BEGIN(DependenceShapeCacheStorage, "da-shape-cache-is",
+  "Dependence Analysis Shape Cache (Immutable Storage)", true, true)
+INITIALIZE_PASS_DEPENDENCY(DependenceShapeCacheWrapper)
+INITIALIZE_PASS_END(DependenceShapeCacheStorage, "da-shape-cache-is",
+  "Dependence Analysis Shape Cache (Immutable Storage)", true, true)
+
+template<> char DependenceShapeCacheWrapper::ID = 0;
+INITIALIZE_PASS(DependenceShapeCacheWrapper, "da-shape-cache-iw",
+  "Dependence Analysis Shape Cache (Immutable Wrapper)", true, true)
+
+ImmutablePass *llvm::createDependenceShapeCacheStorage() {
+  return new DependenceShapeCacheStorage;
+}
+
 FunctionPass *llvm::tsar_impl::createDependenceAnalysisWrapperPass() {
   return new DependenceAnalysisWrapperPass();
 }
@@ -168,6 +231,9 @@ bool DependenceAnalysisWrapperPass::runOnFunction(Function &F) {
   SpanningTreeRelation<const AliasTree *> STR(&AT);
   info.reset(new DependenceInfo(
     &F, &AA, &SE, &LI, &TLI, &DI, &GO, &AT, &STR, &DFI, &DMP));
+  auto &ShapeCache = getAnalysis<DependenceShapeCacheWrapper>();
+  if (UseShapeCache && ShapeCache)
+    info->setShapeCache(&ShapeCache.get());
   return false;
 }
 
@@ -186,6 +252,7 @@ void DependenceAnalysisWrapperPass::getAnalysisUsage(AnalysisUsage &AU) const {
   AU.addRequired<EstimateMemoryPass>();
   AU.addRequired<DefinedMemoryPass>();
   AU.addRequired<DFRegionInfoPass>();
+  AU.addRequired<DependenceShapeCacheWrapper>();
 }
 
 
@@ -3616,6 +3683,311 @@ DependenceInfo::depends(Instruction *Src, Instruction *Dst,
     break; // The underlying objects alias; test accesses for dependence.
   }
 
+  SmallString<128> Shape;
+  if (!ShapeCache || !getShape(Src, Dst, PossiblyLoopIndependent, Shape))
+    return dependsImpl(Src, Dst, PossiblyLoopIndependent, ConfusedLevels);
+  if (auto *Cached = ShapeCache->find(Shape)) {
+    ++ShapeCacheHits;
+    LLVM_DEBUG(dbgs() << "    shape cache hit\n");
+    if (ConfusedLevels)
+      *ConfusedLevels = Cached->ConfusedLevels;
+    if (Cached->K == DependenceShapeCache::Result::Independent)
+      return nullptr;
+    if (Cached->K == DependenceShapeCache::Result::Confused)
+      return std::make_unique<Dependence>(Src, Dst);
+    auto Result = std::make_unique<FullDependence>(
+      Src, Dst, Cached->LoopIndependent, Cached->Levels);
+    Result->ConfusedLevels = Cached->DependenceConfusedLevels;
+    Result->Consistent = Cached->Consistent;
+    for (unsigned I = 0, EI = Cached->Levels; I < EI; ++I) {
+      auto &From = Cached->DV[I];
+      auto &To = Result->DV[I];
+      To.Direction = From.Direction;
+      To.Scalar = From.Scalar;
+      To.PeelFirst = From.PeelFirst;
+      To.PeelLast = From.PeelLast;
+      To.Splitable = From.Splitable;
+      To.Distance = From.Distance ? SE->getConstant(*From.Distance) : nullptr;
+    }
+    return Result;
+  }
+  ++ShapeCacheMisses;
+  unsigned short Confused = 0;
+  auto Dep = dependsImpl(Src, Dst, PossiblyLoopIndependent, &Confused);
+  if (ConfusedLevels)
+    *ConfusedLevels = Confused;
+  DependenceShapeCache::Result ToCache;
+  ToCache.ConfusedLevels = Confused;
+  if (!Dep) {
+    ToCache.K = DependenceShapeCache::Result::Independent;
+  } else if (Dep->isConfused()) {
+    ToCache.K = DependenceShapeCache::Result::Confused;
+  } else {
+    auto &Full = static_cast<const FullDependence &>(*Dep);
+    ToCache.K = DependenceShapeCache::Result::Full;
+    ToCache.Levels = Full.Levels;
+    ToCache.DependenceConfusedLevels = Full.ConfusedLevels;
+    ToCache.LoopIndependent = Full.LoopIndependent;
+    ToCache.Consistent = Full.Consistent;
+    for (unsigned I = 0, EI = Full.Levels; I < EI; ++I) {
+      auto &From = Full.DV[I];
+      Optional<APInt> Distance;
+      if (From.Distance) {
+        // Only constant distances can be restored without references to IR.
+        auto *C = dyn_cast<SCEVConstant>(From.Distance);
+        if (!C)
+          return Dep;
+        Distance = C->getAPInt();
+      }
+      ToCache.DV.push_back({From.Direction, From.Scalar, From.PeelFirst,
+                            From.PeelLast, From.Splitable,
+                            std::move(Distance)});
+    }
+  }
+  // The cache is shared between all functions in a module and between all
+  // analysis stages, so it is dropped when it grows too large.
+  if (ShapeCache->size() >= ShapeCacheLimit)
+    ShapeCache->clear();
+  ShapeCache->insert(Shape, std::move(ToCache));
+  return Dep;
+}
+
+/// Append a structural representation of a specified expression to a shape.
+///
+/// Return `false` if the expression refers to IR values which can not be
+/// described independently of the IR. The only values which are allowed are
+/// the base of accesses and integer arguments of a function. The base is
+/// described in a shape separately (see DependenceInfo::getShape()).
+static bool appendShape(const SCEV *S, const Value *Base,
+                        const DenseMap<const Loop *, unsigned> &LoopIds,
+                        const DataLayout &DL, raw_svector_ostream &OS) {
+  OS << '(' << static_cast<unsigned>(S->getSCEVType()) << ' ';
+  if (auto *C = dyn_cast<SCEVConstant>(S)) {
+    OS << C->getAPInt().getBitWidth() << ' ' << C->getAPInt();
+  } else if (auto *U = dyn_cast<SCEVUnknown>(S)) {
+    auto *V = U->getValue();
+    if (V == Base) {
+      OS << 'b' << static_cast<uint64_t>(DL.getTypeSizeInBits(V->getType()));
+    } else if (auto *A = dyn_cast<Argument>(V)) {
+      if (!A->getType()->isIntegerTy())
+        return false;
+      OS << 'a' << A->getParent()->getName() << ' ' << A->getArgNo() << ' '
+         << A->getType()->getIntegerBitWidth();
+    } else {
+      return false;
+    }
+  } else if (auto *Cast = dyn_cast<SCEVCastExpr>(S)) {
+    OS << static_cast<uint64_t>(DL.getTypeSizeInBits(Cast->getType())) << ' ';
+    if (!appendShape(Cast->getOperand(), Base, LoopIds, DL, OS))
+      return false;
+  } else if (auto *Div = dyn_cast<SCEVUDivExpr>(S)) {
+    if (!appendShape(Div->getLHS(), Base, LoopIds, DL, OS) ||
+        !appendShape(Div->getRHS(), Base, LoopIds, DL, OS))
+      return false;
+  } else if (auto *NAry = dyn_cast<SCEVNAryExpr>(S)) {
+    if (auto *AddRec = dyn_cast<SCEVAddRecExpr>(S)) {
+      auto I = LoopIds.find(AddRec->getLoop());
+      if (I == LoopIds.end())
+        return false;
+      OS << 'L' << I->second << ' ';
+    }
+    OS << static_cast<unsigned>(NAry->getNoWrapFlags()) << ' ';
+    for (auto *Op : NAry->operands())
+      if (!appendShape(Op, Base, LoopIds, DL, OS))
+        return false;
+  } else {
+    return false;
+  }
+  OS << ')';
+  return true;
+}
+
+/// Append a structural representation of a branch condition to a shape.
+///
+/// Return `false` if the condition can not be described, the following
+/// conditions are supported: constants, integer comparisons of expressions
+/// which can be described with appendShape() and their conjunctions and
+/// disjunctions.
+static bool appendCondShape(const Value *Cond, const Value *Base,
+                            const DenseMap<const Loop *, unsigned> &LoopIds,
+                            const DataLayout &DL, ScalarEvolution &SE,
+                            raw_svector_ostream &OS) {
+  if (auto *C = dyn_cast<ConstantInt>(Cond)) {
+    OS << 'k' << C->getZExtValue();
+    return true;
+  }
+  if (auto *Cmp = dyn_cast<ICmpInst>(Cond)) {
+    if (!SE.isSCEVable(Cmp->getOperand(0)->getType()))
+      return false;
+    OS << 'c' << static_cast<unsigned>(Cmp->getPredicate()) << ' ';
+    return appendShape(SE.getSCEV(Cmp->getOperand(0)), Base, LoopIds, DL, OS) &&
+           appendShape(SE.getSCEV(Cmp->getOperand(1)), Base, LoopIds, DL, OS);
+  }
+  if (auto *BO = dyn_cast<BinaryOperator>(Cond))
+    if (BO->getType()->isIntegerTy(1) &&
+        (BO->getOpcode() == Instruction::And ||
+         BO->getOpcode() == Instruction::Or)) {
+      OS << (BO->getOpcode() == Instruction::And ? 'A' : 'O');
+      return appendCondShape(BO->getOperand(0), Base, LoopIds, DL, SE, OS) &&
+             appendCondShape(BO->getOperand(1), Base, LoopIds, DL, SE, OS);
+    }
+  return false;
+}
+
+bool DependenceInfo::getShape(Instruction *Src, Instruction *Dst,
+                              bool PossiblyLoopIndependent,
+                              SmallVectorImpl<char> &Shape) {
+  auto &DL = F->getParent()->getDataLayout();
+  Value *SrcPtr = getLoadStorePointerOperand(Src);
+  Value *DstPtr = getLoadStorePointerOperand(Dst);
+  auto *Base = GetUnderlyingObject(SrcPtr, DL);
+  if (Base != GetUnderlyingObject(DstPtr, DL))
+    return false;
+  auto getAccessSize = [&DL](Instruction *I) -> uint64_t {
+    auto *Ty = isa<StoreInst>(I) ?
+      cast<StoreInst>(I)->getValueOperand()->getType() : I->getType();
+    return DL.getTypeStoreSize(Ty);
+  };
+  raw_svector_ostream OS(Shape);
+  OS << (isa<StoreInst>(Src) ? 's' : 'l') << (isa<StoreInst>(Dst) ? 's' : 'l')
+     << (Src == Dst) << PossiblyLoopIndependent << ' '
+     << getAccessSize(Src) << ' ' << getAccessSize(Dst) << ' ';
+  if (GO)
+    OS << GO->IsSafeTypeCast << GO->InBoundsSubscripts << ' ';
+  // Delinearization relies on source element types of GEPs and some checks
+  // rely on 'inbounds' flag, so accesses which have the same SCEVs may have
+  // different results of the test, for example 'p[10*i+j]' and 'a[i][j]'.
+  for (auto *Ptr : {SrcPtr, DstPtr}) {
+    if (auto *GEP = dyn_cast<GEPOperator>(Ptr)) {
+      OS << 'G' << GEP->isInBounds() << ' ';
+      GEP->getSourceElementType()->print(OS, false, true);
+      OS << ' ';
+    } else {
+      OS << "N ";
+    }
+  }
+  // Loops from both nests are identified by their depths and nests they
+  // belong to. Results of the test depend on loop bounds only, so a shape
+  // describes backedge-taken counts of all loops.
+  DenseMap<const Loop *, unsigned> LoopIds;
+  SmallVector<const Loop *, 8> Loops;
+  auto *SrcLoop = LI->getLoopFor(Src->getParent());
+  auto *DstLoop = LI->getLoopFor(Dst->getParent());
+  for (auto *L = SrcLoop; L; L = L->getParentLoop())
+    Loops.push_back(L);
+  for (auto *L = DstLoop; L; L = L->getParentLoop())
+    if (!is_contained(Loops, L))
+      Loops.push_back(L);
+  for (auto *L : Loops)
+    LoopIds.try_emplace(L, LoopIds.size());
+  // Results of the test depend on whether the base is invariant in the loop
+  // nest, so bases computed inside the nest are not cached. Otherwise, the
+  // shape identifies the base.
+  if (auto *I = dyn_cast<Instruction>(Base)) {
+    if (any_of(Loops, [I](const Loop *L) { return L->contains(I); }))
+      return false;
+    OS << 'i' << I->getFunction()->getName() << ' ' << I->getOpcodeName();
+  } else if (auto *A = dyn_cast<Argument>(Base)) {
+    OS << 'a' << A->getParent()->getName() << ' ' << A->getArgNo();
+  } else if (auto *GV = dyn_cast<GlobalValue>(Base)) {
+    OS << 'g' << GV->getName();
+  } else {
+    return false;
+  }
+  OS << ' ';
+  OS << (SrcLoop ? SrcLoop->getLoopDepth() : 0) << ' '
+     << (DstLoop ? DstLoop->getLoopDepth() : 0) << ' ';
+  for (auto *L : Loops) {
+    OS << '[' << L->getLoopDepth() << ' '
+       << (SrcLoop && L->contains(SrcLoop))
+       << (DstLoop && L->contains(DstLoop)) << ' ';
+    if (!SE->hasLoopInvariantBackedgeTakenCount(L))
+      OS << '?';
+    else if (!appendShape(SE->getBackedgeTakenCount(L), Base, LoopIds, DL, OS))
+      return false;
+    OS << ']';
+  }
+  // ScalarEvolution proves predicates with conditions which guard entry to
+  // loops and their backedges, for example 'if (M > 0)' before a loop, so
+  // these conditions are described in a shape. Conditions of all branches
+  // inside a loop and conditions on the chain of predecessors which
+  // ScalarEvolution climbs from the loop preheader are described. Tests are
+  // not cached if some of these conditions can not be described or if
+  // a function contains assumptions or guards which are also used to prove
+  // predicates.
+  for (auto Id : {Intrinsic::assume, Intrinsic::experimental_guard})
+    if (auto *Decl = F->getParent()->getFunction(Intrinsic::getName(Id)))
+      if (any_of(Decl->users(), [this](const User *U) {
+            auto *I = dyn_cast<Instruction>(U);
+            return !I || I->getFunction() == F;
+          }))
+        return false;
+  for (auto *L : Loops) {
+    OS << 'C';
+    for (auto *BB : L->blocks())
+      if (auto *BI = dyn_cast<BranchInst>(BB->getTerminator()))
+        if (BI->isConditional() &&
+            !appendCondShape(BI->getCondition(), Base, LoopIds, DL, *SE, OS))
+          return false;
+    OS << 'E';
+    SmallPtrSet<const BasicBlock *, 8> Visited;
+    const BasicBlock *Succ = L->getHeader();
+    const BasicBlock *Pred = L->getLoopPredecessor();
+    while (Pred && Visited.insert(Pred).second) {
+      // A condition may refer to induction variables of loops which precede
+      // the current one, so these loops are also identified.
+      for (auto *Outer = LI->getLoopFor(Pred); Outer;
+           Outer = Outer->getParentLoop())
+        LoopIds.try_emplace(Outer, LoopIds.size());
+      if (auto *BI = dyn_cast<BranchInst>(Pred->getTerminator()))
+        if (BI->isConditional() && BI->getSuccessor(0) != BI->getSuccessor(1)) {
+          OS << (BI->getSuccessor(0) == Succ);
+          if (!appendCondShape(BI->getCondition(), Base, LoopIds, DL, *SE, OS))
+            return false;
+        }
+      if (auto *SinglePred = Pred->getSinglePredecessor()) {
+        Succ = Pred;
+        Pred = SinglePred;
+      } else if (auto *Outer = LI->getLoopFor(Pred)) {
+        Succ = Outer->getHeader();
+        Pred = Outer->getLoopPredecessor();
+      } else {
+        break;
+      }
+    }
+  }
+  // Metadata-based delinearization is used if both accesses refer to the same
+  // delinearized array, so the shape contains results of delinearization.
+  if (DI) {
+    auto SrcInfo = DI->findRange(SrcPtr);
+    auto DstInfo = DI->findRange(DstPtr);
+    if (SrcInfo.first && SrcInfo.first == DstInfo.first &&
+        SrcInfo.first->isDelinearized() &&
+        SrcInfo.second->isValid() && DstInfo.second->isValid()) {
+      OS << 'D';
+      for (unsigned I = 1, EI = SrcInfo.first->getNumberOfDims(); I < EI; ++I)
+        if (!appendShape(SrcInfo.first->getDimSize(I), Base, LoopIds, DL, OS))
+          return false;
+      for (auto *Range : {SrcInfo.second, DstInfo.second}) {
+        OS << '|';
+        for (auto *S : Range->Subscripts)
+          if (!appendShape(S, Base, LoopIds, DL, OS))
+            return false;
+      }
+    }
+  }
+  OS << '|';
+  return appendShape(SE->getSCEV(SrcPtr), Base, LoopIds, DL, OS) &&
+         appendShape(SE->getSCEV(DstPtr), Base, LoopIds, DL, OS);
+}
+
+std::unique_ptr<Dependence>
+DependenceInfo::dependsImpl(Instruction *Src, Instruction *Dst,
+                            bool PossiblyLoopIndependent,
+                            unsigned short *ConfusedLevels) {
+  Value *SrcPtr = getLoadStorePointerOperand(Src);
+  Value *DstPtr = getLoadStorePointerOperand(Dst);
+
   // establish loop nesting levels
   establishNestingLevels(Src, Dst);
   LLVM_DEBUG(dbgs() << "    common nesting levels = " << CommonLevels << "\n");
@@ -23,6 +23,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "tsar/Analysis/Memory/EstimateMemory.h"
+#include "tsar/Analysis/Memory/AliasQueryCache.h"
 #include "tsar/Analysis/Memory/MemoryAccessUtils.h"
 #include "tsar/Analysis/Memory/MemorySetInfo.h"
 #include "tsar/Unparse/Utils.h"
@@ -50,6 +51,7 @@ STATISTIC(NumUnknownNode, "Number of unknown nodes created");
 STATISTIC(NumMergedNode, "Number of alias nodes merged in");
 STATISTIC(NumEstimateMemory, "Number of estimate memory created");
 STATISTIC(NumUnknownMemory, "Number of unknown memory created");
+STATISTIC(NumSkippedLocations, "Number of repeated memory locations skipped");
 
 static inline void clarifyUnknownSize(const DataLayout &DL,
     MemoryLocation &Loc, const DominatorTree *DT = nullptr) {
@@ -236,7 +238,9 @@ bool isSameBase(const DataLayout &DL,
   return false;
 }
 
-AliasDescriptor aliasRelation(AAResults &AA, const DataLayout &DL,
+namespace {
+template<class AliasAnalysisT>
+AliasDescriptor aliasRelationImp(AliasAnalysisT &AA, const DataLayout &DL,
     const MemoryLocation &LHS, const MemoryLocation &RHS) {
   AliasDescriptor Dptr;
   auto AR = AA.alias(
@@ -303,16 +307,17 @@ AliasDescriptor aliasRelation(AAResults &AA, const DataLayout &DL,
   return Dptr;
 }
 
-AliasDescriptor aliasRelation(AAResults &AA, const DataLayout &DL,
+template<class AliasAnalysisT>
+AliasDescriptor aliasRelationImp(AliasAnalysisT &AA, const DataLayout &DL,
     const EstimateMemory &LHS, const EstimateMemory &RHS) {
-  auto MergedAD = aliasRelation(AA, DL,
+  auto MergedAD = aliasRelationImp(AA, DL,
     MemoryLocation(LHS.front(), LHS.getSize(), LHS.getAAInfo()),
     MemoryLocation(RHS.front(), RHS.getSize(), RHS.getAAInfo()));
   if (MergedAD.is<trait::MayAlias>())
     return MergedAD;
   for (auto PtrLHS: LHS)
     for (auto PtrRHS : RHS) {
-      auto AD = aliasRelation(AA, DL,
+      auto AD = aliasRelationImp(AA, DL,
         MemoryLocation(PtrLHS, LHS.getSize(), LHS.getAAInfo()),
         MemoryLocation(PtrRHS, RHS.getSize(), RHS.getAAInfo()));
       MergedAD = mergeAliasRelation(MergedAD, AD);
@@ -321,6 +326,27 @@ AliasDescriptor aliasRelation(AAResults &AA, const DataLayout &DL,
     }
   return MergedAD;
 }
+}
+
+AliasDescriptor aliasRelation(AAResults &AA, const DataLayout &DL,
+    const MemoryLocation &LHS, const MemoryLocation &RHS) {
+  return aliasRelationImp(AA, DL, LHS, RHS);
+}
+
+AliasDescriptor aliasRelation(AAResults &AA, const DataLayout &DL,
+    const EstimateMemory &LHS, const EstimateMemory &RHS) {
+  return aliasRelationImp(AA, DL, LHS, RHS);
+}
+
+AliasDescriptor aliasRelation(AliasQueryCache &AA, const DataLayout &DL,
+    const MemoryLocation &LHS, const MemoryLocation &RHS) {
+  return aliasRelationImp(AA, DL, LHS, RHS);
+}
+
+AliasDescriptor aliasRelation(AliasQueryCache &AA, const DataLayout &DL,
+    const EstimateMemory &LHS, const EstimateMemory &RHS) {
+  return aliasRelationImp(AA, DL, LHS, RHS);
+}
 
 const EstimateMemory * ancestor(
     const EstimateMemory *LHS, const EstimateMemory *RHS) noexcept {
@@ -494,12 +520,19 @@ void AliasTree::add(const MemoryLocation &Loc) {
   assert(!isa<UndefValue>(Loc.Ptr) && "Pointer to memory location must be valid!");
   LLVM_DEBUG(dbgs() << "[ALIAS TREE]: add memory location ";
              printLocationSource(dbgs(), Loc, mDT); dbgs() << "\n");
-  mSearchCache.clear();
   using CT = bcl::ChainTraits<EstimateMemory, Hierarchy>;
   MemoryLocation Base(Loc);
   EstimateMemory *PrevChainEnd = nullptr;
   stripToBase(*mDL, Base);
   clarifyUnknownSize(*mDL, Base, mDT);
+  // Insertion of the same base twice does not change the tree, however
+  // a lot of alias queries are necessary to check this.
+  if (!mInsertedBases.insert(Base).second) {
+    ++NumSkippedLocations;
+    LLVM_DEBUG(dbgs() << "[ALIAS TREE]: skip already inserted location\n");
+    return;
+  }
+  mSearchCache.clear();
   do {
     LLVM_DEBUG(evaluateMemoryLevelLog(Base, getDomTree()));
     stripToBase(*mDL, Base);
@@ -608,7 +641,7 @@ void tsar::AliasTree::addUnknown(llvm::Instruction *I) {
   auto Children = make_range(
     getTopLevelNode()->child_begin(), getTopLevelNode()->child_end());
   for (auto &Child : Children) {
-    auto AR = Child.slowMayAliasUnknown(I, *mAA);
+    auto AR = Child.slowMayAliasUnknown(I, mAQC);
     if (AR.first)
       if (AR.second == I)
         return;
@@ -645,7 +678,7 @@ void AliasTree::removeNode(AliasNode *N) {
 
 std::pair<bool, Instruction *>
 AliasEstimateNode::slowMayAliasUnknownImp(
-    const Instruction *I, AAResults &AA) const {
+    const Instruction *I, AliasQueryCache &AA) const {
   assert(I && "Instruction must not be null!");
   for (auto &EM : *this) {
     for (auto *Ptr : EM)
@@ -658,7 +691,7 @@ AliasEstimateNode::slowMayAliasUnknownImp(
 
 std::pair<bool, Instruction *>
 AliasUnknownNode::slowMayAliasUnknownImp(
-    const Instruction *I, AAResults &AA) const {
+    const Instruction *I, AliasQueryCache &AA) const {
   assert(I && "Instruction must not be null!");
   if (mUnknownInsts.count(const_cast<Instruction *>(I)))
     return std::make_pair(true, const_cast<Instruction *>(I));
@@ -673,7 +706,8 @@ AliasUnknownNode::slowMayAliasUnknownImp(
 }
 
 std::pair<bool, EstimateMemory *>
-AliasEstimateNode::slowMayAliasImp(const EstimateMemory &EM, AAResults &AA) {
+AliasEstimateNode::slowMayAliasImp(
+    const EstimateMemory &EM, AliasQueryCache &AA) {
   for (auto &ThisEM : *this)
     for (auto *LHSPtr : ThisEM)
       for (auto *RHSPtr : EM) {
@@ -688,7 +722,8 @@ AliasEstimateNode::slowMayAliasImp(const EstimateMemory &EM, AAResults &AA) {
 }
 
 std::pair<bool, EstimateMemory *>
-AliasUnknownNode::slowMayAliasImp(const EstimateMemory &EM, AAResults &AA) {
+AliasUnknownNode::slowMayAliasImp(
+    const EstimateMemory &EM, AliasQueryCache &AA) {
   for (auto *UI : *this) {
     for (auto *Ptr : EM)
       if (AA.getModRefInfo(UI, MemoryLocation(Ptr, EM.getSize(), EM.getAAInfo()))
@@ -716,7 +751,7 @@ AliasEstimateNode * AliasTree::addEmptyNode(
       return cast<AliasEstimateNode>(Current);
     Aliases.clear();
     for (auto &Ch : make_range(Current->child_begin(), Current->child_end())) {
-      auto Result = Ch.slowMayAlias(NewEM, *mAA);
+      auto Result = Ch.slowMayAlias(NewEM, mAQC);
       if (Result.first) {
         if (Result.second)
           Aliases.push_back(Result.second);
@@ -727,7 +762,7 @@ AliasEstimateNode * AliasTree::addEmptyNode(
         // that its children nodes do not alias with this memory. The issue is
         // that unknown node may not cover its children nodes.
         for (auto &N : make_range(Ch.child_begin(), Ch.child_end())) {
-          auto Result = N.slowMayAlias(NewEM, *mAA);
+          auto Result = N.slowMayAlias(NewEM, mAQC);
           if (Result.first) {
             Aliases.push_back(&Ch);
             break;
@@ -747,7 +782,7 @@ AliasEstimateNode * AliasTree::addEmptyNode(
       auto Node = EM->getAliasNode(*this);
       assert(Node && "Alias node for memory location must not be null!");
       auto AD = aliasRelation(
-        *mAA, *mDL, NewEM, AliasEstimateNode::iterator(EM), Node->end());
+        mAQC, *mDL, NewEM, AliasEstimateNode::iterator(EM), Node->end());
       if (AD.is<trait::CoverAlias>()) {
         auto *NewNode = make_node<AliasEstimateNode, llvm::Statistic, 2>(
           *Current, {&NumAliasNode, &NumEstimateNode});
@@ -765,7 +800,7 @@ AliasEstimateNode * AliasTree::addEmptyNode(
         auto EM = I->get<EstimateMemory *>();
         auto Node = EM->getAliasNode(*this);
         assert(Node && "Alias node for memory location must not be null!");
-        auto AD = aliasRelation(*mAA, *mDL, NewEM, Node->begin(), Node->end());
+        auto AD = aliasRelation(mAQC, *mDL, NewEM, Node->begin(), Node->end());
         if (AD.is<trait::CoverAlias>() ||
             (AD.is<trait::CoincideAlias>() && !AD.is<trait::ContainedAlias>()))
           continue;
@@ -814,7 +849,7 @@ AliasResult AliasTree::isSamePointer(
   auto LocAATags = sanitizeAAInfo(Loc.AATags);
   bool IsAmbiguous = false;
   for (auto *Ptr : EM) {
-    switch (mAA->alias(
+    switch (mAQC.alias(
         MemoryLocation(Ptr, 1, EM.getAAInfo()),
         MemoryLocation(Loc.Ptr, 1, LocAATags))) {
       case MustAlias: return MustAlias;
@@ -1023,13 +1058,97 @@ INITIALIZE_PASS_BEGIN(EstimateMemoryPass, "estimate-mem",
 INITIALIZE_PASS_DEPENDENCY(DominatorTreeWrapperPass)
 INITIALIZE_PASS_DEPENDENCY(AAResultsWrapperPass)
 INITIALIZE_PASS_DEPENDENCY(TargetLibraryInfoWrapperPass)
+INITIALIZE_PASS_DEPENDENCY(GlobalAliasCacheWrapper)
 INITIALIZE_PASS_END(EstimateMemoryPass, "estimate-mem",
   "Memory Estimator", false, true)
 
+namespace {
+/// Storage of alias relations between global objects which is shared
+/// between alias trees for different functions.
+class GlobalAliasCacheStorage : public ImmutablePass {
+public:
+  static char ID;
+
+  GlobalAliasCacheStorage() : ImmutablePass(ID) {
+    initializeGlobalAliasCacheStoragePass(*PassRegistry::getPassRegistry());
+  }
+
+  void initializePass() override {
+    getAnalysis<GlobalAliasCacheWrapper>().set(mCache);
+  }
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.addRequired<GlobalAliasCacheWrapper>();
+  }
+
+  /// Return shared alias relations.
+  GlobalAliasCache & getCache() noexcept { return mCache; }
+
+  /// Return shared alias relations.
+  const GlobalAliasCache & getCache() const noexcept { return mCache; }
+
+private:
+  GlobalAliasCache mCache;
+};
+
+/// Invalidates shared alias relations between global objects.
+///
+/// Results of module-level alias analysis (for example, GlobalsAA) are
+/// recomputed after transformations, so relations should be recomputed also.
+class GlobalAliasCacheInvalidator : public ModulePass,
+    private bcl::Uncopyable {
+public:
+  static char ID;
+
+  GlobalAliasCacheInvalidator() : ModulePass(ID) {
+    initializeGlobalAliasCacheInvalidatorPass(
+      *PassRegistry::getPassRegistry());
+  }
+
+  bool runOnModule(Module &) override {
+    if (auto &Wrapper = getAnalysis<GlobalAliasCacheWrapper>())
+      Wrapper->invalidate();
+    return false;
+  }
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.addRequired<GlobalAliasCacheWrapper>();
+    AU.setPreservesAll();
+  }
+};
+}
+
+char GlobalAliasCacheStorage::ID = 0;
+INITIALIZE_PASS_BEGIN(GlobalAliasCacheStorage, "global-alias-cache-is",
+  "Global Alias Cache (Immutable Storage)", true, true)
+INITIALIZE_PASS_DEPENDENCY(GlobalAliasCacheWrapper)
+INITIALIZE_PASS_END(GlobalAliasCacheStorage, "global-alias-cache-is",
+  "Global Alias Cache (Immutable Storage)", true, true)
+
+template<> char GlobalAliasCacheWrapper::ID = 0;
+INITIALIZE_PASS(GlobalAliasCacheWrapper, "global-alias-cache-iw",
+  "Global Alias Cache (Immutable Wrapper)", true, true)
+
+char GlobalAliasCacheInvalidator::ID = 0;
+INITIALIZE_PASS_BEGIN(GlobalAliasCacheInvalidator, "global-alias-cache-inv",
+  "Global Alias Cache Invalidator", true, true)
+INITIALIZE_PASS_DEPENDENCY(GlobalAliasCacheWrapper)
+INITIALIZE_PASS_END(GlobalAliasCacheInvalidator, "global-alias-cache-inv",
+  "Global Alias Cache Invalidator", true, true)
+
+ImmutablePass *llvm::createGlobalAliasCacheStorage() {
+  return new GlobalAliasCacheStorage;
+}
+
+ModulePass *llvm::createGlobalAliasCacheInvalidator() {
+  return new GlobalAliasCacheInvalidator;
+}
+
 void EstimateMemoryPass::getAnalysisUsage(AnalysisUsage & AU) const {
   AU.addRequired<DominatorTreeWrapperPass>();
   AU.addRequiredTransitive<AAResultsWrapperPass>();
   AU.addRequired<TargetLibraryInfoWrapperPass>();
+  AU.addRequired<GlobalAliasCacheWrapper>();
   AU.setPreservesAll();
 }
 
@@ -1045,6 +1164,17 @@ bool EstimateMemoryPass::runOnFunction(Function &F) {
   auto M = F.getParent();
   auto &DL = M->getDataLayout();
   mAliasTree = new AliasTree(AA, DL, DT);
+  // Alias analysis is the same for all functions which are processed by
+  // the current pass, so relations between global objects are shared between
+  // these functions only.
+  if (auto &GlobalCache = getAnalysis<GlobalAliasCacheWrapper>()) {
+    if (mGlobalAliasCache != &GlobalCache.get()) {
+      mGlobalAliasCache = &GlobalCache.get();
+      mGlobalAliasScope = mGlobalAliasCache->createScope();
+    }
+    mAliasTree->getAliasQueryCache().setGlobalCache(mGlobalAliasCache,
+                                                    mGlobalAliasScope);
+  }
   DenseSet<const Value *> AccessedMemory, AccessedUnknown;
   auto addLocation = [&AccessedMemory, this](MemoryLocation &&Loc) {
     AccessedMemory.insert(Loc.Ptr);
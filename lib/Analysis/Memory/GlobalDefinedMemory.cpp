@@ -25,14 +25,17 @@
 #include "tsar/Analysis/Memory/DefinedMemory.h"
 #include "tsar/Analysis/Memory/EstimateMemory.h"
 #include "tsar/Analysis/Memory/Passes.h"
+#include "tsar/Support/IRUtils.h"
 #include "tsar/Support/PassProvider.h"
 #include <bcl/utility.h>
 #include <llvm/ADT/SCCIterator.h>
+#include <llvm/ADT/Statistic.h>
 #include <llvm/Analysis/CallGraph.h>
 #include <llvm/Analysis/CallGraphSCCPass.h>
 #include <llvm/InitializePasses.h>
 #include <llvm/IR/Function.h>
 #include <llvm/Pass.h>
+#include <llvm/Support/CommandLine.h>
 #include <llvm/Support/raw_ostream.h>
 #include <llvm/IR/Dominators.h>
 
@@ -42,6 +45,15 @@
 using namespace llvm;
 using namespace tsar;
 
+STATISTIC(NumAnalyzedFunctions, "Number of analyzed functions");
+STATISTIC(NumReusedFunctions, "Number of functions with reused results");
+
+static cl::opt<bool> IncrementalAnalysis("global-def-mem-incremental",
+  cl::init(false), cl::Hidden,
+  cl::desc("Reuse results for functions which have not been changed since "
+           "the previous run of interprocedural defined memory analysis "
+           "(experimental)"));
+
 namespace {
 class GlobalDefinedMemory : public ModulePass, private bcl::Uncopyable {
 public:
@@ -82,8 +94,15 @@ public:
     return mInterprocDUInfo;
   }
 
+  /// Return fingerprints of functions at the moment of the analysis.
+  DenseMap<const Function *, FunctionFingerprint> &
+  getFingerprints() noexcept {
+    return mFingerprints;
+  }
+
 private:
   tsar::InterprocDefUseInfo mInterprocDUInfo;
+  DenseMap<const Function *, FunctionFingerprint> mFingerprints;
 };
 
 using GlobalDefinedMemoryProvider = FunctionPassProvider<
@@ -142,8 +161,41 @@ bool GlobalDefinedMemory::runOnModule(Module &SCC) {
   auto &Wrapper = getAnalysis<GlobalDefinedMemoryWrapper>();
   if (!Wrapper)
     return false;
+  // Results of the previous run can be reused if they are available in the
+  // storage only. Otherwise, the wrapper may be set to results which are
+  // obtained in some other way and we can not check whether they are valid.
+  auto *Storage = IncrementalAnalysis ?
+    getAnalysisIfAvailable<GlobalDefinedMemoryStorage>() : nullptr;
+  if (Storage && &Storage->getInterprocDefUseInfo() != &Wrapper.get())
+    Storage = nullptr;
+  InterprocDefUseInfo PrevInfo;
+  DenseMap<const Function *, FunctionFingerprint> PrevFingerprints;
+  if (Storage) {
+    PrevInfo = std::move(*Wrapper);
+    PrevFingerprints = std::move(Storage->getFingerprints());
+  }
   Wrapper->clear();
+  if (Storage)
+    Storage->getFingerprints().clear();
+  // Results for a function are reused if the function has not been changed
+  // and results for all its callees have been reused. Functions are visited
+  // in post order, so callees are processed before their callers.
+  SmallPtrSet<const Function *, 32> Reused;
+  auto isReusable = [&PrevFingerprints, &Reused](
+                        const CallGraphNode &CGN,
+                        const FunctionFingerprint &Fingerprint) {
+    auto I = PrevFingerprints.find(CGN.getFunction());
+    if (I == PrevFingerprints.end() || I->second != Fingerprint)
+      return false;
+    for (auto &CallRecord : CGN) {
+      auto *Callee = CallRecord.second->getFunction();
+      if (Callee && !Callee->empty() && !Reused.count(Callee))
+        return false;
+    }
+    return true;
+  };
   auto &CG = getAnalysis<CallGraphWrapperPass>().getCallGraph();
+  OnTheFlyPassCache Providers;
   for (scc_iterator<CallGraph *> SCC = scc_begin(&CG); !SCC.isAtEnd(); ++SCC) {
     /// TODO (kaniandr@gmail.com): implement analysis in case of recursion.
     if (SCC->size() > 1)
@@ -157,10 +209,28 @@ bool GlobalDefinedMemory::runOnModule(Module &SCC) {
     // and these functions should be pre-analyzed.
     if (!F || F->empty() || !hasFnAttr(*F, AttrKind::DirectUserCallee))
       continue;
+    if (Storage) {
+      FunctionFingerprint Fingerprint(*F);
+      bool IsReusable = isReusable(*CGN, Fingerprint);
+      Storage->getFingerprints().try_emplace(F, std::move(Fingerprint));
+      if (IsReusable) {
+        auto PrevItr = PrevInfo.find(F);
+        if (PrevItr != PrevInfo.end()) {
+          LLVM_DEBUG(dbgs() << "[GLOBAL DEFINED MEMORY]: reuse results for "
+                            << F->getName() << "\n";);
+          Wrapper->try_emplace(F, std::move(PrevItr->get<DefUseSet>()));
+          Reused.insert(F);
+          ++NumReusedFunctions;
+          continue;
+        }
+      }
+    }
     LLVM_DEBUG(dbgs() << "[GLOBAL DEFINED MEMORY]: analyze " << F->getName()
                       << "\n";);
+    ++NumAnalyzedFunctions;
     auto &TLI = getAnalysis<TargetLibraryInfoWrapperPass>().getTLI(*F);
-    auto &Provider = getAnalysis<GlobalDefinedMemoryProvider>(*F);
+    auto &Provider =
+      Providers.getAnalysis<GlobalDefinedMemoryProvider>(*this, *F);
     auto &RegInfo = Provider.get<DFRegionInfoPass>().getRegionInfo();
     auto &AT = Provider.get<EstimateMemoryPass>().getAliasTree();
     const auto &DT = Provider.get<DominatorTreeWrapperPass>().getDomTree();
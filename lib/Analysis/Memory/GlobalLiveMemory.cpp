@@ -110,7 +110,7 @@ using GlobalLiveMemoryProvider = FunctionPassProvider<
   DominatorTreeWrapperPass>;
 
 void initMayLivesWithIPO(Function &F, LiveMemoryForCalls &LiveSetForCalls,
-    DefUseSet &DefUse, DataFlowTraits<LiveDFFwk *>::ValueType &MayLives) {
+    DefUseSet &DefUse, MemorySet<MemoryLocationRange> &MayLives) {
   auto FInfoItr = LiveSetForCalls.find(&F);
   // Check that a current function is entry point or that it is never called.
   // In this case list of live locations after exist from this function is empty.
@@ -283,7 +283,7 @@ bool GlobalLiveMemory::runOnModule(Module &M) {
     auto &DefInfo = Provider.get<DefinedMemoryPass>().getDefInfo();
     DominatorTree *DT = nullptr;
     LLVM_DEBUG(DT = &Provider.get<DominatorTreeWrapperPass>().getDomTree());
-    DataFlowTraits<LiveDFFwk *>::ValueType MayLives;
+    MemorySet<MemoryLocationRange> MayLives;
     auto DefItr = DefInfo.find(TopRegion);
     assert(DefItr != DefInfo.end() && DefItr->get<DefUseSet>() &&
       "Def-use set must not be null!");
@@ -306,7 +306,9 @@ bool GlobalLiveMemory::runOnModule(Module &M) {
     auto &LS = LiveItr->get<LiveSet>();
     LS->setOut(MayLives);
     LiveDFFwk LiveFwk(IntraLiveInfo, DefInfo, DT);
+    LiveFwk.initializeDense(TopRegion);
     solveDataFlowDownward(&LiveFwk, TopRegion);
+    LiveFwk.finalizeDense();
     auto &TLI = getAnalysis<TargetLibraryInfoWrapperPass>().getTLI(*F);
     for (auto &CallRecord : *CGN) {
       Function *Callee = CallRecord.second->getFunction();
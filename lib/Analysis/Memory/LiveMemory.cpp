@@ -30,7 +30,9 @@
 #ifdef LLVM_DEBUG
 # include <llvm/IR/Dominators.h>
 #endif
+#include <llvm/Support/CommandLine.h>
 #include <llvm/Support/Debug.h>
+#include <llvm/Support/Threading.h>
 
 using namespace llvm;
 using namespace tsar;
@@ -38,6 +40,10 @@ using namespace tsar;
 #undef DEBUG_TYPE
 #define DEBUG_TYPE "live-mem"
 
+static cl::opt<unsigned> LiveMemThreads("live-mem-threads", cl::init(1),
+  cl::desc("Number of threads to solve live memory problems for "
+           "independent loops (0 - use all available hardware threads)"));
+
 char LiveMemoryPass::ID = 0;
 INITIALIZE_PASS_BEGIN(LiveMemoryPass, "live-mem",
   "Live Memory Analysis", false, true)
@@ -80,7 +86,7 @@ INITIALIZE_PASS_END(LiveMemoryPass, "live-mem",
     // If inter-procedural analysis is not performed conservative assumption for
     // live variable analysis should be made. All locations except 'alloca' are
     // considered as alive before exit from this function.
-    DataFlowTraits<LiveDFFwk *>::ValueType MayLives;
+    MemorySet<MemoryLocationRange> MayLives;
     for (auto &Loc : DefUse->getDefs()) {
       assert(Loc.Ptr && "Pointer to location must not be null!");
       if (!isa<AllocaInst>(GetUnderlyingObject(Loc.Ptr, DL, 0)))
@@ -94,7 +100,16 @@ INITIALIZE_PASS_END(LiveMemoryPass, "live-mem",
     LS->setOut(std::move(MayLives));
   }
   LiveDFFwk LiveFwk(mLiveInfo, DefInfo, DT);
-  solveDataFlowDownward(&LiveFwk, DFF);
+  LiveFwk.initializeDense(DFF);
+  if (LiveMemThreads == 1) {
+    solveDataFlowDownward(&LiveFwk, DFF);
+  } else {
+    if (!mPool)
+      mPool =
+        std::make_unique<ThreadPool>(hardware_concurrency(LiveMemThreads));
+    solveDataFlowDownward(&LiveFwk, DFF, *mPool);
+  }
+  LiveFwk.finalizeDense();
   return false;
 }
 
@@ -109,12 +124,75 @@ FunctionPass * llvm::createLiveMemoryPass() {
   return new LiveMemoryPass();
 }
 
+void LiveDFFwk::initializeDense(DFRegion *R) {
+  assert(R && "Region must not be null!");
+  assert(mDenseInfo.empty() && "Dense values have been already initialized!");
+  auto LiveItr = getLiveInfo().find(R);
+  assert(LiveItr != getLiveInfo().end() && LiveItr->get<LiveSet>() &&
+    "Data-flow value must be specified!");
+  auto &LS = LiveItr->get<LiveSet>();
+  SmallVector<DFNode *, 64> Nodes;
+  Nodes.push_back(R);
+  SmallVector<DFRegion *, 8> Worklist;
+  Worklist.push_back(R);
+  do {
+    auto *Curr = Worklist.pop_back_val();
+    Nodes.append(Curr->getNodes().begin(), Curr->getNodes().end());
+    Worklist.append(Curr->region_begin(), Curr->region_end());
+  } while (!Worklist.empty());
+  // Only locations which may occur in data-flow values should be numbered.
+  // These are locations from def-use sets and locations which are alive
+  // after the outermost region.
+  mUniverse.insert(LS->getIn().begin(), LS->getIn().end());
+  mUniverse.insert(LS->getOut().begin(), LS->getOut().end());
+  for (auto *N : Nodes) {
+    auto DefItr = getDefInfo().find(N);
+    if (DefItr == getDefInfo().end() || !DefItr->get<DefUseSet>())
+      continue;
+    auto &DU = DefItr->get<DefUseSet>();
+    mUniverse.insert(DU->getUses().begin(), DU->getUses().end());
+    mUniverse.insert(DU->getDefs().begin(), DU->getDefs().end());
+  }
+  mUniverse.finalize();
+  for (auto *N : Nodes) {
+    auto Pair = mDenseInfo.try_emplace(N);
+    if (!Pair.second)
+      continue;
+    Pair.first->second = std::make_unique<DenseLiveSet>(mUniverse);
+    auto &DLS = *Pair.first->second;
+    auto DefItr = getDefInfo().find(N);
+    if (DefItr == getDefInfo().end() || !DefItr->get<DefUseSet>())
+      continue;
+    auto &DU = DefItr->get<DefUseSet>();
+    for (auto &Loc : DU->getUses())
+      DLS.Uses.insert(Loc);
+    for (auto &Loc : DU->getDefs())
+      if (auto Id = mUniverse.getId(Loc.Ptr))
+        DLS.Defs.set(*Id);
+  }
+  auto &DLS = getDenseValue(R);
+  for (auto &Loc : LS->getIn())
+    DLS.In.insert(Loc);
+  for (auto &Loc : LS->getOut())
+    DLS.Out.insert(Loc);
+}
+
+void LiveDFFwk::finalizeDense() {
+  for (auto &Pair : mDenseInfo) {
+    auto &LS = getLiveInfo().try_emplace(Pair.first).first->get<LiveSet>();
+    if (!LS)
+      LS = std::make_unique<LiveSet>();
+    LS->setIn(Pair.second->In.materialize());
+    LS->setOut(Pair.second->Out.materialize());
+  }
+  mDenseInfo.clear();
+}
+
 void DataFlowTraits<LiveDFFwk *>::initialize(
   DFNode *N, LiveDFFwk *DFF, GraphType) {
   assert(N && "Node must not be null!");
   assert(DFF && "Data-flow framework must not be null!");
-  DFF->getLiveInfo().insert(
-    std::make_pair(N, std::make_unique<LiveSet>()));
+  // Values for all nodes have been allocated in LiveDFFwk::initializeDense().
 }
 
 bool DataFlowTraits<LiveDFFwk*>::transferFunction(
@@ -122,14 +200,11 @@ bool DataFlowTraits<LiveDFFwk*>::transferFunction(
   // Note, that transfer function is never evaluated for the exit node.
   assert(N && "Node must not be null!");
   assert(DFF && "Data-flow framework must not be null!");
-  auto I = DFF->getLiveInfo().find(N);
-  assert(I != DFF->getLiveInfo().end() && I->get<LiveSet>() &&
-    "Data-flow value must be specified!");
-  auto &LS = I->get<LiveSet>();
-  LS->setOut(std::move(V)); // Do not use V below to avoid undefined behavior.
+  auto &LS = DFF->getDenseValue(N);
+  LS.Out = std::move(V); // Do not use V below to avoid undefined behavior.
   if (isa<DFEntry>(N)) {
-    if (LS->getIn() != LS->getOut()) {
-      LS->setIn(LS->getOut());
+    if (LS.In != LS.Out) {
+      LS.In = LS.Out;
       return true;
     }
     return false;
@@ -138,8 +213,13 @@ bool DataFlowTraits<LiveDFFwk*>::transferFunction(
   assert(DefItr != DFF->getDefInfo().end() && DefItr->get<DefUseSet>() &&
     "Def-use set must not be null!");
   auto &DU = DefItr->get<DefUseSet>();
-  ValueType newIn(DU->getUses());
-  for (auto &Loc : LS->getOut()) {
+  ValueType newIn(LS.Uses);
+  // Numbered locations can not partially overlap, so a location is defined in
+  // the node if and only if the corresponding bit is set.
+  BitVector AliveOut(LS.Out.getDenseLocations());
+  AliveOut.reset(LS.Defs);
+  newIn.insert(AliveOut);
+  for (auto &Loc : LS.Out.getSparseLocations()) {
     if (!DU->hasDef(Loc))
       newIn.insert(Loc);
   }
@@ -154,15 +234,15 @@ bool DataFlowTraits<LiveDFFwk*>::transferFunction(
     dbgs() << " unknown node.\n";
   }
   dbgs() << "IN:\n";
-  for (auto &Loc : newIn)
+  for (auto &Loc : newIn.materialize())
     (printLocationSource(dbgs(), Loc.Ptr, DFF->getDomTree()), dbgs() << "\n");
   dbgs() << "OUT:\n";
-  for (auto &Loc : LS->getOut())
+  for (auto &Loc : LS.Out.materialize())
     (printLocationSource(dbgs(), Loc.Ptr, DFF->getDomTree()), dbgs() << "\n");
   dbgs() << "[END LIVE]\n";
   );
-  if (LS->getIn() != newIn) {
-    LS->setIn(std::move(newIn));
+  if (LS.In != newIn) {
+    LS.In = std::move(newIn);
     return true;
   }
   return false;
@@ -42,6 +42,7 @@
 #include "tsar/Support/IRUtils.h"
 #include "tsar/Support/Utils.h"
 #include "tsar/Unparse/Utils.h"
+#include <llvm/ADT/BitVector.h>
 #include <llvm/ADT/DenseMap.h>
 #include <llvm/ADT/PostOrderIterator.h>
 #include <llvm/ADT/DepthFirstIterator.h>
@@ -57,6 +58,7 @@
 #include "llvm/IR/InstIterator.h"
 #include <llvm/IR/LLVMContext.h>
 #include <llvm/IR/Operator.h>
+#include <llvm/Support/CommandLine.h>
 #include <llvm/Support/raw_ostream.h>
 #include <llvm/Support/Debug.h>
 #include <bcl/utility.h>
@@ -70,6 +72,13 @@ using bcl::operator "" _b;
 #define DEBUG_TYPE "private"
 
 MEMORY_TRAIT_STATISTIC(NumTraits)
+STATISTIC(NumUnrelatedPairs,
+  "Number of pairs of accesses skipped due to unrelated alias nodes");
+
+static cl::opt<bool> PartitionDependencies("private-partition-deps",
+  cl::init(true), cl::Hidden,
+  cl::desc("Test for dependence only accesses which are related in the "
+           "alias tree"));
 
 char PrivateRecognitionPass::ID = 0;
 INITIALIZE_PASS_IN_GROUP_BEGIN(PrivateRecognitionPass, "private",
@@ -98,6 +107,40 @@ struct DependenceCache {
   using CacheT = DenseMap<SrcDstPair, DependenceConfusedPair>;
   CacheT Impl;
 };
+
+/// \brief Alias nodes which are accessed by memory instructions of a loop.
+///
+/// A relation is stored for each pair of accessed nodes only, so the amount
+/// of memory depends on the number of accessed nodes instead of the number
+/// of instructions in a loop.
+struct RelatedAccesses {
+  /// Indices of nodes accessed by an instruction. Instructions which
+  /// access memory which is not presented in the alias tree are not stored.
+  DenseMap<const Instruction *, SmallVector<unsigned, 2>> InstNodes;
+
+  /// For each accessed node, this contains indices of related nodes.
+  std::vector<BitVector> NodeRelated;
+
+  /// This is false if relations have not been collected.
+  bool IsCollected = false;
+
+  /// Returns true if specified memory accesses may refer the same memory.
+  bool isRelated(const Instruction *Src, const Instruction *Dst) const {
+    if (!IsCollected)
+      return true;
+    auto SrcItr = InstNodes.find(Src);
+    auto DstItr = InstNodes.find(Dst);
+    // Accesses to memory which is not presented in the alias tree are
+    // conservatively related to all other accesses.
+    if (SrcItr == InstNodes.end() || DstItr == InstNodes.end())
+      return true;
+    for (auto SrcId : SrcItr->second)
+      for (auto DstId : DstItr->second)
+        if (NodeRelated[SrcId].test(DstId))
+          return true;
+    return false;
+  }
+};
 }
 }
 
@@ -129,6 +172,29 @@ bool PrivateRecognitionPass::runOnFunction(Function &F) {
   return false;
 }
 
+/// Collects alias nodes which contain memory accessed by a specified
+/// instruction, returns false if some accesses have not been found in
+/// the alias tree.
+static bool collectAliasNodes(Instruction &I, const AliasTree &AT,
+    TargetLibraryInfo &TLI, SmallVectorImpl<const AliasNode *> &Nodes) {
+  bool IsComplete = true;
+  if (auto *N = AT.findUnknown(I))
+    Nodes.push_back(N);
+  for_each_memory(I, TLI,
+    [&AT, &Nodes, &IsComplete](Instruction &, MemoryLocation &&Loc,
+        unsigned, AccessInfo, AccessInfo) {
+      if (auto *EM = AT.find(Loc))
+        Nodes.push_back(EM->getAliasNode(AT));
+      else
+        IsComplete = false;
+    },
+    [&AT, &IsComplete](Instruction &Unknown, AccessInfo, AccessInfo) {
+      if (!AT.findUnknown(Unknown))
+        IsComplete = false;
+    });
+  return IsComplete && !Nodes.empty();
+}
+
 namespace {
 struct DistanceInfo {
   enum Apply : uint8_t {
@@ -530,7 +596,7 @@ void PrivateRecognitionPass::resolveCandidats(
       NodeTraits.insert(
         std::make_pair(&N, std::make_tuple(TraitList(), UnknownList())));
     DependenceMap Deps;
-    collectDependencies(L->getLoop(), Deps, Cache);
+    collectDependencies(L->getLoop(), AliasSTR, Deps, Cache);
     resolveAccesses(L->getLoop(), R->getLatchNode(), R->getExitNode(),
       *DefItr->get<DefUseSet>(), *LiveItr->get<LiveSet>(), Deps, AliasSTR,
       ExplicitAccesses, ExplicitUnknowns, NodeTraits);
@@ -614,13 +680,67 @@ void PrivateRecognitionPass::insertDependence(const Dependence &Dep,
                    Deps);
 }
 
-void PrivateRecognitionPass::collectDependencies(Loop *L, DependenceMap &Deps,
+void PrivateRecognitionPass::collectRelatedAccesses(
+    ArrayRef<Instruction *> Insts, const AliasTreeRelation &AliasSTR,
+    RelatedAccesses &Related) {
+  Related.IsCollected = true;
+  DenseMap<const AliasNode *, unsigned> NodeIds;
+  SmallVector<const AliasNode *, 32> Nodes;
+  SmallVector<const AliasNode *, 4> InstNodes;
+  for (auto *I : Insts) {
+    if (!I->mayReadOrWriteMemory())
+      continue;
+    if (auto II = dyn_cast<IntrinsicInst>(I))
+      if (isMemoryMarkerIntrinsic(II->getIntrinsicID()))
+        continue;
+    InstNodes.clear();
+    if (!collectAliasNodes(*I, *mAliasTree, *mTLI, InstNodes))
+      continue;
+    auto &Ids = Related.InstNodes[I];
+    for (auto *N : InstNodes) {
+      auto Info = NodeIds.try_emplace(N, Nodes.size());
+      if (Info.second)
+        Nodes.push_back(N);
+      if (!is_contained(Ids, Info.first->second))
+        Ids.push_back(Info.first->second);
+    }
+  }
+  // The number of relation queries depends on the number of accessed alias
+  // nodes instead of the number of accesses.
+  SmallVector<AliasTreeRelation::NodeId, 32> STRIds;
+  for (auto *N : Nodes)
+    STRIds.push_back(AliasSTR.getId(N));
+  Related.NodeRelated.assign(Nodes.size(), BitVector(Nodes.size()));
+  for (unsigned I = 0, EI = Nodes.size(); I < EI; ++I) {
+    Related.NodeRelated[I].set(I);
+    for (unsigned J = I + 1; J < EI; ++J)
+      if (AliasSTR.compare(STRIds[I], STRIds[J]) != TR_UNREACHABLE) {
+        Related.NodeRelated[I].set(J);
+        Related.NodeRelated[J].set(I);
+      }
+  }
+}
+
+void PrivateRecognitionPass::collectDependencies(Loop *L,
+    const AliasTreeRelation &AliasSTR, DependenceMap &Deps,
     DependenceCache &Cache) {
-  auto &AA = mAliasTree->getAliasAnalysis();
+  auto &AA = mAliasTree->getAliasQueryCache();
   std::vector<Instruction *> LoopInsts;
   for (auto *BB : L->getBlocks())
     for (auto &I : *BB)
       LoopInsts.push_back(&I);
+  // Accesses to memory from unrelated alias nodes can not alias, so there is
+  // no dependence between them and they should not be tested.
+  RelatedAccesses Related;
+  if (PartitionDependencies)
+    collectRelatedAccesses(LoopInsts, AliasSTR, Related);
+  auto isUnrelated = [&Related](std::vector<Instruction *>::iterator SrcItr,
+      std::vector<Instruction *>::iterator DstItr) {
+    if (Related.isRelated(*SrcItr, *DstItr))
+      return false;
+    ++NumUnrelatedPairs;
+    return true;
+  };
   for (auto SrcItr = LoopInsts.begin(), EndItr = LoopInsts.end();
        SrcItr != EndItr; ++SrcItr) {
     if (!(**SrcItr).mayReadOrWriteMemory())
@@ -636,6 +756,8 @@ void PrivateRecognitionPass::collectDependencies(Loop *L, DependenceMap &Deps,
         if (auto II = dyn_cast<IntrinsicInst>(*DstItr))
           if (isMemoryMarkerIntrinsic(II->getIntrinsicID()))
             continue;
+        if (isUnrelated(SrcItr, DstItr))
+          continue;
         trait::Dependence::Flag Flag = trait::Dependence::May |
           trait::Dependence::UnknownDistance |
           (!isa<CallBase>(*SrcItr) && !isa<CallBase>(*DstItr)
@@ -677,6 +799,8 @@ void PrivateRecognitionPass::collectDependencies(Loop *L, DependenceMap &Deps,
           if (auto II = dyn_cast<IntrinsicInst>(*DstItr))
             if (isMemoryMarkerIntrinsic(II->getIntrinsicID()))
               continue;
+          if (isUnrelated(SrcItr, DstItr))
+            continue;
           if (AA.getModRefInfo(*DstItr, Src) == ModRefInfo::NoModRef)
             continue;
           trait::Dependence::Flag Flag = trait::Dependence::May |
@@ -691,6 +815,8 @@ void PrivateRecognitionPass::collectDependencies(Loop *L, DependenceMap &Deps,
           updateDependence(mAliasTree->find(Src), Dptr, Flag, DistanceInfo{},
                            Deps, isa<CallBase>(*DstItr) ? *DstItr : nullptr);
         } else {
+          if (isUnrelated(SrcItr, DstItr))
+            continue;
           if (!(*SrcItr)->mayWriteToMemory() &&
               !(*DstItr)->mayWriteToMemory()) {
             LLVM_DEBUG(dbgs() << "[PRIVATE]: ignore input dependence\n");
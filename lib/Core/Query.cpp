@@ -137,6 +137,7 @@ void addAfterSROAAnalysis(const GlobalOptions &GO, const DataLayout &DL,
   Passes.add(createLoopSimplifyPass());
   Passes.add(createSCEVAAWrapperPass());
   Passes.add(createGlobalsAAWrapperPass());
+  Passes.add(createGlobalAliasCacheInvalidator());
   Passes.add(createRPOFunctionAttrsAnalysis());
   Passes.add(createPOFunctionAttrsAnalysis());
   Passes.add(createMemoryMatcherPass());
@@ -169,6 +170,7 @@ void addAfterLoopRotateAnalysis(legacy::PassManager &Passes) {
   Passes.add(createInstructionCombiningPass());
   Passes.add(createLoopSimplifyPass());
   Passes.add(createLCSSAPass());
+  Passes.add(createGlobalAliasCacheInvalidator());
   Passes.add(createMemoryMatcherPass());
   Passes.add(createCallExtractorPass());
   Passes.add(createGlobalDefinedMemoryPass());
@@ -281,6 +283,8 @@ void DefaultQueryManager::run(llvm::Module *M, TransformationInfo *TfmInfo) {
   Passes.add(createMemoryMatcherPass());
   Passes.add(createGlobalDefinedMemoryStorage());
   Passes.add(createGlobalLiveMemoryStorage());
+  Passes.add(createDependenceShapeCacheStorage());
+  Passes.add(createGlobalAliasCacheStorage());
   // It is necessary to destroy DIMemoryTraitPool before DIMemoryEnvironment to
   // avoid dangling handles. So, we add pool before environment in the manager.
   Passes.add(createDIMemoryTraitPoolStorage());
@@ -342,11 +346,29 @@ void InstrLLVMQueryManager::run(llvm::Module *M,
     TEP->set(*TfmInfo);
     Passes.add(TEP);
   }
-  Passes.add(createUnreachableBlockEliminationPass());
-  Passes.add(createNoMetadataDSEPass());
-  Passes.add(createDINodeRetrieverPass());
-  Passes.add(createMemoryMatcherPass());
-  Passes.add(createDILoopRetrieverPass());
+  if (mPruneOptions) {
+    // Analyze original IR to find accesses which do not need instrumentation.
+    // Initial transformations replace the default preparation of IR, so
+    // unused functions and globals are removed and are not instrumented.
+    Passes.add(createGlobalOptionsImmutableWrapper(mPruneOptions));
+    addImmutableAliasAnalysis(Passes);
+    addInitialTransformations(Passes);
+    Passes.add(createMemoryMatcherPass());
+    Passes.add(createGlobalDefinedMemoryStorage());
+    Passes.add(createGlobalLiveMemoryStorage());
+    Passes.add(createDependenceShapeCacheStorage());
+    Passes.add(createGlobalAliasCacheStorage());
+    Passes.add(createDIMemoryTraitPoolStorage());
+    Passes.add(createDIMemoryEnvironmentStorage());
+    addBeforeTfmAnalysis(Passes);
+    Passes.add(createInstrumentationPruningPass(mInstrEntry));
+  } else {
+    Passes.add(createUnreachableBlockEliminationPass());
+    Passes.add(createNoMetadataDSEPass());
+    Passes.add(createDINodeRetrieverPass());
+    Passes.add(createMemoryMatcherPass());
+    Passes.add(createDILoopRetrieverPass());
+  }
   Passes.add(createInstrumentationPass(mInstrEntry, mInstrStart));
   Passes.add(createPrintModulePass(*mOS, "", mCodeGenOpts->EmitLLVMUseLists));
   Passes.run(*M);
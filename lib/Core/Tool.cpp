@@ -35,15 +35,28 @@
 #ifdef APC_FOUND
 # include "tsar/APC/Utils.h"
 #endif
+#include <clang/Basic/DiagnosticOptions.h>
+#include <clang/Driver/Options.h>
+#include <clang/Frontend/CompilerInvocation.h>
 #include <clang/Frontend/FrontendActions.h>
+#include <clang/Frontend/TextDiagnosticPrinter.h>
+#include <clang/Serialization/PCHContainerOperations.h>
 #include <clang/Tooling/CommonOptionsParser.h>
 #include <clang/Tooling/Tooling.h>
+#include <llvm/ADT/StringExtras.h>
 #include <llvm/IR/LegacyPassNameParser.h>
+#include <llvm/Option/ArgList.h>
 #include <llvm/Support/Debug.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
 #include <llvm/Support/Path.h>
+#include <llvm/Support/Program.h>
 #include <llvm/Support/TargetSelect.h>
 #include <llvm/Support/CommandLine.h>
 #include <llvm/Support/Host.h>
+#include <llvm/Support/ThreadPool.h>
+#include <llvm/Support/VirtualFileSystem.h>
+#include <mutex>
 #ifdef lp_solve_FOUND
 # include <lp_solve/lp_solve_config.h>
 #endif
@@ -119,10 +132,12 @@ struct Options : private bcl::Uncopyable {
   llvm::cl::opt<bool> InstrLLVM;
   llvm::cl::opt<std::string> InstrEntry;
   llvm::cl::list<std::string> InstrStart;
+  llvm::cl::opt<bool> InstrPrune;
   llvm::cl::opt<bool> EmitAST;
   llvm::cl::opt<bool> MergeAST;
   llvm::cl::alias MergeASTA;
   llvm::cl::opt<std::string> Output;
+  llvm::cl::opt<unsigned> Jobs;
   llvm::cl::opt<std::string> Language;
   llvm::cl::opt<bool> Verbose;
   llvm::cl::opt<bool> CaretDiagnostics;
@@ -201,6 +216,9 @@ Options::Options() :
   InstrStart("instr-start", cl::cat(CompileCategory), cl::value_desc("functions"),
     cl::ZeroOrMore, cl::ValueRequired, cl::CommaSeparated,
     cl::desc("Add start point for instrumentation")),
+  InstrPrune("instr-prune", cl::cat(CompileCategory),
+    cl::desc("Do not instrument accesses to memory with traits which are "
+             "determined by static analysis")),
   EmitAST("emit-ast", cl::cat(CompileCategory),
     cl::desc("Emit Clang AST files for source inputs")),
   MergeAST("merge-ast", cl::cat(CompileCategory),
@@ -208,6 +226,8 @@ Options::Options() :
   MergeASTA("m", cl::aliasopt(MergeAST), cl::desc("Alias for -merge-ast")),
   Output("o", cl::cat(CompileCategory), cl::value_desc("file"),
     cl::desc("Write output to <file>"), cl::Prefix),
+  Jobs("j", cl::cat(CompileCategory), cl::value_desc("N"), cl::init(1),
+    cl::desc("Process up to N translation units in parallel"), cl::Prefix),
   Language("x", cl::cat(CompileCategory), cl::value_desc("language"),
     cl::desc("Treat subsequent input files as having type <language>"),
     cl::Prefix),
@@ -385,6 +405,11 @@ Tool::Tool(int Argc, const char **Argv) {
   // parsed, due to initialize list of available passes.
   initializeTSAR(*PassRegistry::getPassRegistry());
   auto Args = addInternalArgs(Argc, Argv);
+  // Store arguments which are actually parsed, so positions of options
+  // (see cl::list::getPosition()) can be used as indices in this list.
+  mArgs.assign(Args.begin(), Args.end());
+  mArgs.front() = sys::fs::getMainExecutable(
+      Argv[0], (void *)(intptr_t)&Options::printVersion);
   cl::ParseCommandLineOptions(Args.size(), Args.data(), Descr);
   storeCLOptions();
   InitializeAllTargetInfos();
@@ -409,8 +434,9 @@ inline static EmitLLVMQueryManager * getEmitLLVMQM() {
 }
 
 inline static InstrLLVMQueryManager * getInstrLLVMQM(
-    StringRef InstrEntry, ArrayRef<std::string> InstrStart) {
-  static InstrLLVMQueryManager QM(InstrEntry, InstrStart);
+    StringRef InstrEntry, ArrayRef<std::string> InstrStart,
+    const GlobalOptions *PruneOptions) {
+  static InstrLLVMQueryManager QM(InstrEntry, InstrStart, PruneOptions);
   return &QM;
 }
 
@@ -614,7 +640,9 @@ void Tool::storeCLOptions() {
   mInstrLLVM = addIfSet(Options::get().InstrLLVM);
   mInstrEntry = Options::get().InstrEntry;
   mInstrStart = Options::get().InstrStart;
-  if (!mInstrLLVM && (!mInstrEntry.empty() || !mInstrStart.empty()))
+  mInstrPrune = Options::get().InstrPrune;
+  if (!mInstrLLVM &&
+      (!mInstrEntry.empty() || !mInstrStart.empty() || mInstrPrune))
     errs() << "WARNING: Instrumentation options are ignored when "
               "-instr-llvm is not set.\n";
   mCheck = addLLIfSet(addIfSet(Options::get().Check));
@@ -626,6 +654,11 @@ void Tool::storeCLOptions() {
     exit(1);
   }
   mOutputFilename = Options::get().Output;
+  mJobs = Options::get().Jobs;
+  if (mJobs == 0) {
+    Options::get().Jobs.error("error - number of jobs must be positive");
+    exit(1);
+  }
   storePrintOptions(IncompatibleOpts);
   mLanguage = Options::get().Language;
   /// TODO (kaniandr@gmail.com): allow to use -output-suffix option for
@@ -668,7 +701,211 @@ void Tool::storeCLOptions() {
   }
 }
 
+int Tool::runParallel() {
+  // Each worker processes a single source with the same options, so remove
+  // sources and the -j option from the original command line.
+  auto isJobsOpt = [](StringRef Arg) {
+    if (!Arg.consume_front("-j"))
+      return false;
+    Arg.consume_front("=");
+    return !Arg.empty() && all_of(Arg, isDigit);
+  };
+  auto &SourceOpt = Options::get().Sources;
+  SmallVector<unsigned, 16> SourcePos;
+  for (unsigned I = 0, EI = SourceOpt.size(); I < EI; ++I)
+    SourcePos.push_back(SourceOpt.getPosition(I));
+  std::vector<StringRef> BaseArgs;
+  BaseArgs.push_back(mArgs.front());
+  for (std::size_t I = 1, EI = mArgs.size(); I < EI; ++I) {
+    StringRef Arg = mArgs[I];
+    if (Arg == "-j") {
+      ++I;
+      continue;
+    }
+    if (isJobsOpt(Arg) || is_contained(SourcePos, I))
+      continue;
+    BaseArgs.push_back(Arg);
+  }
+  struct JobInfo {
+    SmallString<128> OutFile;
+    SmallString<128> ErrFile;
+    std::string ErrMsg;
+    int Result = 0;
+  };
+  std::vector<JobInfo> Jobs(mSources.size());
+  {
+    ThreadPool Pool(hardware_concurrency(mJobs));
+    for (std::size_t I = 0, EI = mSources.size(); I < EI; ++I)
+      Pool.async([this, &BaseArgs, &Jobs, I]() {
+        auto &Job = Jobs[I];
+        for (auto *File : {&Job.OutFile, &Job.ErrFile})
+          if (auto EC = sys::fs::createTemporaryFile("tsar", "log", *File)) {
+            Job.ErrMsg = EC.message();
+            Job.Result = -1;
+            return;
+          }
+        SmallVector<StringRef, 32> Args(BaseArgs.begin(), BaseArgs.end());
+        Args.push_back(mSources[I]);
+        Optional<StringRef> Redirects[] = {
+          None, StringRef(Job.OutFile), StringRef(Job.ErrFile)};
+        Job.Result = sys::ExecuteAndWait(mArgs.front(), Args, None, Redirects,
+                                         0, 0, &Job.ErrMsg);
+      });
+    Pool.wait();
+  }
+  // Print results in the order of sources in the command line, so the output
+  // does not depend on the order in which workers finish.
+  int Result = 0;
+  for (std::size_t I = 0, EI = mSources.size(); I < EI; ++I) {
+    auto &Job = Jobs[I];
+    if (!Job.OutFile.empty()) {
+      if (auto Buffer = MemoryBuffer::getFile(Job.OutFile))
+        outs() << (*Buffer)->getBuffer();
+      sys::fs::remove(Job.OutFile);
+    }
+    if (!Job.ErrFile.empty()) {
+      if (auto Buffer = MemoryBuffer::getFile(Job.ErrFile))
+        errs() << (*Buffer)->getBuffer();
+      sys::fs::remove(Job.ErrFile);
+    }
+    if (Job.Result != 0) {
+      if (!Job.ErrMsg.empty())
+        errs() << "error: unable to process '" << mSources[I]
+               << "': " << Job.ErrMsg << "\n";
+      Result = 1;
+    }
+  }
+  return Result;
+}
+
+/// Adjusts a command line to emit Clang AST to a specified file.
+static CommandLineArguments adjustToEmitAST(const CommandLineArguments &CL,
+                                            StringRef OutputFile) {
+  CommandLineArguments Adjusted;
+  for (std::size_t I = 0; I < CL.size(); ++I) {
+    StringRef Arg = CL[I];
+    // If `-fsyntax-only` is set all output files will be ignored.
+    if (Arg.startswith("-fsyntax-only"))
+      Adjusted.emplace_back("-emit-ast");
+    else
+      Adjusted.push_back(Arg.str());
+  }
+  Adjusted.emplace_back("-o");
+  Adjusted.push_back(std::string(OutputFile));
+  return Adjusted;
+}
+
+/// Returns diagnostic options which are specified in a compilation command
+/// for a specified source (the same options are used by ClangTool to print
+/// diagnostics if a diagnostic consumer is not set).
+static IntrusiveRefCntPtr<DiagnosticOptions> getDiagnosticOptions(
+    const CompilationDatabase &Compilations, StringRef Src) {
+  IntrusiveRefCntPtr<DiagnosticOptions> DiagOpts(new DiagnosticOptions);
+  auto Commands = Compilations.getCompileCommands(Src);
+  if (Commands.empty() || Commands.front().CommandLine.empty())
+    return DiagOpts;
+  std::vector<const char *> Argv;
+  for (auto &Arg : Commands.front().CommandLine)
+    Argv.push_back(Arg.c_str());
+  unsigned MissingArgIndex, MissingArgCount;
+  auto ParsedArgs = driver::getDriverOptTable().ParseArgs(
+    makeArrayRef(Argv).slice(1), MissingArgIndex, MissingArgCount);
+  ParseDiagnosticArgs(*DiagOpts, ParsedArgs);
+  return DiagOpts;
+}
+
+/// Returns a name of an AST file which is emitted for a specified source.
+///
+/// The AST file is placed next to the source which is specified in
+/// a compilation command, a relative path is resolved against a directory
+/// of the command.
+static std::string getASTFile(const CompilationDatabase &Compilations,
+                              StringRef Src) {
+  SmallString<128> AbsSrc(Src);
+  sys::fs::make_absolute(AbsSrc);
+  auto Commands = Compilations.getCompileCommands(AbsSrc);
+  SmallString<128> PCHFile;
+  if (Commands.empty()) {
+    PCHFile = AbsSrc;
+  } else {
+    PCHFile = Commands.front().Filename;
+    sys::fs::make_absolute(Commands.front().Directory, PCHFile);
+  }
+  sys::path::replace_extension(PCHFile, ".ast");
+  return std::string(PCHFile);
+}
+
+void Tool::emitASTToMerge(ArrayRef<std::string> Sources,
+                          std::vector<std::string> &ASTFiles) {
+  std::size_t FirstAST = ASTFiles.size();
+  for (auto &Src : Sources)
+    ASTFiles.push_back(getASTFile(*mCompilations, Src));
+  std::mutex DiagMutex;
+  auto emit = [this, Sources, &ASTFiles, FirstAST, &DiagMutex](std::size_t I) {
+    StringRef ASTFile = ASTFiles[FirstAST + I];
+    // ClangTool changes working directory of a file system to a directory of
+    // a compilation command. A working directory of the real file system is
+    // a working directory of the process, so each tool uses its own file
+    // system to avoid races between concurrently processed sources.
+    ClangTool EmitPCHTool(*mCompilations, Sources[I],
+      std::make_shared<PCHContainerOperations>(),
+      IntrusiveRefCntPtr<vfs::FileSystem>(
+        vfs::createPhysicalFileSystem().release()));
+    EmitPCHTool.setRestoreWorkingDir(false);
+    EmitPCHTool.appendArgumentsAdjuster(
+      [ASTFile](const CommandLineArguments &CL, StringRef) {
+        return adjustToEmitAST(CL, ASTFile);
+      });
+    // Diagnostics for a file are buffered and printed at once, so messages
+    // for different files are not interleaved.
+    std::string Diagnostics;
+    raw_string_ostream DiagOS(Diagnostics);
+    auto DiagOpts = getDiagnosticOptions(*mCompilations, Sources[I]);
+    // Escape sequences are written to the buffer if colors are enabled, so
+    // they are printed when the buffer is flushed to the terminal.
+    DiagOS.enable_colors(DiagOpts->ShowColors);
+    TextDiagnosticPrinter DiagPrinter(DiagOS, DiagOpts.get());
+    EmitPCHTool.setDiagnosticConsumer(&DiagPrinter);
+    EmitPCHTool.run(
+        newActionFactory<GeneratePCHAction, GenPCHPragmaAction>().get());
+    DiagOS.flush();
+    if (Diagnostics.empty())
+      return;
+    std::lock_guard<std::mutex> Lock(DiagMutex);
+    errs() << Diagnostics;
+  };
+  // Each source is processed with its own ClangTool and file system, so there
+  // is no shared state between different files. The order of AST files does
+  // not depend on the order in which sources are processed.
+  if (mJobs > 1 && Sources.size() > 1) {
+    ThreadPool Pool(hardware_concurrency(mJobs));
+    for (std::size_t I = 0, EI = Sources.size(); I < EI; ++I)
+      Pool.async(emit, I);
+    Pool.wait();
+  } else {
+    for (std::size_t I = 0, EI = Sources.size(); I < EI; ++I)
+      emit(I);
+  }
+}
+
 int Tool::run(QueryManager *QM) {
+  if (mJobs > 1) {
+    // Results of a user-defined query manager must be available in the
+    // current process, and a single output file can not be produced by
+    // independent workers. If sources are merged, AST files are emitted in
+    // parallel (see emitASTToMerge()).
+    if (!QM && !mMergeAST && mOutputFilename.empty() && mSources.size() > 1)
+      return runParallel();
+    if (!mOutputFilename.empty())
+      errs() << "WARNING: The -j option is ignored when "
+                "the -o option is used.\n";
+    else if (mMergeAST)
+      errs() << "WARNING: The -j option is used to emit AST files only when "
+                "the -merge-ast option is used.\n";
+    else if (QM && mSources.size() > 1)
+      errs() << "WARNING: The -j option is ignored when "
+                "a custom query manager is used.\n";
+  }
   std::vector<std::string> NoASTSources;
   std::vector<std::string> SourcesToMerge;
   std::vector<std::string> LLSources;
@@ -688,32 +925,16 @@ int Tool::run(QueryManager *QM) {
   }
   // Evaluation of Clang AST files by this tool leads an error,
   // so these sources should be excluded.
-  ClangTool EmitPCHTool(*mCompilations, NoASTSources);
-  auto ArgumentsAdjuster = [&SourcesToMerge, this](
-    const CommandLineArguments &CL, StringRef Filename) {
-    CommandLineArguments Adjusted;
-    for (std::size_t I = 0; I < CL.size(); ++I) {
-      StringRef Arg = CL[I];
-      // If `-fsyntax-only` is set all output files will be ignored.
-      if (Arg.startswith("-fsyntax-only"))
-        Adjusted.emplace_back("-emit-ast");
-      else
-        Adjusted.push_back(Arg.str());
-    }
-    Adjusted.emplace_back("-o");
-    if (mOutputFilename.empty()) {
-      SmallString<128> PCHFile = Filename;
-      sys::path::replace_extension(PCHFile, ".ast");
-      Adjusted.push_back(std::string(PCHFile));
-      SourcesToMerge.push_back(std::string(PCHFile));
-    } else {
-      Adjusted.push_back(mOutputFilename);
-      SourcesToMerge.push_back(mOutputFilename);
-    }
-    return Adjusted;
-  };
-  EmitPCHTool.appendArgumentsAdjuster(ArgumentsAdjuster);
   if (mEmitAST) {
+    ClangTool EmitPCHTool(*mCompilations, NoASTSources);
+    EmitPCHTool.appendArgumentsAdjuster(
+      [this](const CommandLineArguments &CL, StringRef Filename) {
+        if (!mOutputFilename.empty())
+          return adjustToEmitAST(CL, mOutputFilename);
+        SmallString<128> PCHFile = Filename;
+        sys::path::replace_extension(PCHFile, ".ast");
+        return adjustToEmitAST(CL, PCHFile);
+      });
     if (!mOutputFilename.empty() && NoASTSources.size() > 1) {
       errs() << "WARNING: The -o (output filename) option is ignored when "
                 "generating multiple output files.\n";
@@ -732,15 +953,14 @@ int Tool::run(QueryManager *QM) {
   // analysis. AST files will be stored in SourcesToMerge collection.
   // If an input file already contains Clang AST it will be pushed into
   // the SourcesToMerge collection only.
-  if (mMergeAST) {
-    EmitPCHTool.run(
-        newActionFactory<GeneratePCHAction, GenPCHPragmaAction>().get());
-  }
+  if (mMergeAST)
+    emitASTToMerge(NoASTSources, SourcesToMerge);
   if (!QM) {
     if (mEmitLLVM)
       QM = getEmitLLVMQM();
     else if (mInstrLLVM)
-      QM = getInstrLLVMQM(mInstrEntry, mInstrStart);
+      QM = getInstrLLVMQM(mInstrEntry, mInstrStart,
+        mInstrPrune ? &mGlobalOpts : nullptr);
     else if (mTfmPass)
       QM = getTransformationQM(mTfmPass, mGlobalOpts);
     else if (mCheck)
@@ -26,6 +26,8 @@
 #include "tsar/Support/IRUtils.h"
 #include "tsar/Support/MetadataUtils.h"
 #include "tsar/Support/PassAAProvider.h"
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/IR/Instructions.h>
 #include <regex>
 
 using namespace llvm;
@@ -90,6 +92,74 @@ llvm::Argument * getArgument(llvm::Function &F, std::size_t ArgNo) {
   for (std::size_t I = 0; ArgItr != ArgItrE && I <= ArgNo; ++I, ++ArgItr);
   return ArgItr != ArgItrE ? &*ArgItr : nullptr;
 }
+
+FunctionFingerprint::FunctionFingerprint(const llvm::Function &F) {
+  DenseMap<const Value *, unsigned> LocalIds;
+  for (auto &Arg : F.args())
+    LocalIds.try_emplace(&Arg, LocalIds.size());
+  for (auto &BB : F) {
+    LocalIds.try_emplace(&BB, LocalIds.size());
+    for (auto &I : BB)
+      LocalIds.try_emplace(&I, LocalIds.size());
+  }
+  auto addPtr = [this](const void *Ptr) {
+    mData.push_back(reinterpret_cast<std::uintptr_t>(Ptr));
+  };
+  auto addValue = [this, &LocalIds, &addPtr](const Value *V) {
+    auto Itr = LocalIds.find(V);
+    if (Itr != LocalIds.end()) {
+      mData.push_back(0);
+      mData.push_back(Itr->second);
+    } else {
+      mData.push_back(1);
+      addPtr(V);
+    }
+  };
+  addPtr(&F);
+  addPtr(F.getFunctionType());
+  addPtr(F.getAttributes().getRawPointer());
+  mData.push_back(F.size());
+  for (auto &BB : F) {
+    addPtr(&BB);
+    mData.push_back(BB.size());
+    for (auto &I : BB) {
+      addPtr(&I);
+      mData.push_back(I.getOpcode());
+      addPtr(I.getType());
+      mData.push_back(I.getRawSubclassOptionalData());
+      // Properties of instructions which are not stored in operands.
+      if (auto *Cmp = dyn_cast<CmpInst>(&I)) {
+        mData.push_back(Cmp->getPredicate());
+      } else if (auto *LI = dyn_cast<LoadInst>(&I)) {
+        mData.push_back(LI->isVolatile());
+        mData.push_back(LI->getAlign().value());
+        mData.push_back(static_cast<unsigned>(LI->getOrdering()));
+      } else if (auto *SI = dyn_cast<StoreInst>(&I)) {
+        mData.push_back(SI->isVolatile());
+        mData.push_back(SI->getAlign().value());
+        mData.push_back(static_cast<unsigned>(SI->getOrdering()));
+      } else if (auto *AI = dyn_cast<AllocaInst>(&I)) {
+        addPtr(AI->getAllocatedType());
+        mData.push_back(AI->getAlign().value());
+      } else if (auto *GEP = dyn_cast<GetElementPtrInst>(&I)) {
+        addPtr(GEP->getSourceElementType());
+      } else if (auto *Call = dyn_cast<CallBase>(&I)) {
+        addPtr(Call->getFunctionType());
+        addPtr(Call->getAttributes().getRawPointer());
+      } else if (auto *Phi = dyn_cast<PHINode>(&I)) {
+        for (auto *BB : Phi->blocks())
+          addValue(BB);
+      } else if (auto *EVI = dyn_cast<ExtractValueInst>(&I)) {
+        mData.insert(mData.end(), EVI->idx_begin(), EVI->idx_end());
+      } else if (auto *IVI = dyn_cast<InsertValueInst>(&I)) {
+        mData.insert(mData.end(), IVI->idx_begin(), IVI->idx_end());
+      }
+      mData.push_back(I.getNumOperands());
+      for (auto &Op : I.operands())
+        addValue(Op.get());
+    }
+  }
+}
 }
 
 template <> char GlobalsAAResultImmutableWrapper::ID = 0;
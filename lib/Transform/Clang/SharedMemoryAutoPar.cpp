@@ -398,7 +398,7 @@ bool ClangSMParallelization::runOnModule(Module &M) {
 
 FunctionAnalysis
 ClangSMParallelization::analyzeFunction(llvm::Function &F) {
-  auto &Provider = getAnalysis<ClangSMParallelProvider>(F);
+  auto &Provider = mProviders.getAnalysis<ClangSMParallelProvider>(*this, F);
   FunctionAnalysis Results;
   Results.for_each([&Provider](auto &T) {
     T = &Provider.get<std::remove_pointer_t<std::decay_t<decltype(T)>>>();
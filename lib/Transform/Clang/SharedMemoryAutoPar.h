@@ -113,6 +113,7 @@ public:
     mMemoryMatcher = nullptr;
     mGlobalsAA = nullptr;
     mSocketInfo = nullptr;
+    mProviders.invalidate();
   }
 
 protected:
@@ -170,6 +171,7 @@ private:
   DenseSet<std::size_t> mExternalCalls;
   // Set of functions and their IDs which are called from parallel loops.
   DenseMap<Function *, std::size_t> mParallelCallees;
+  tsar::OnTheFlyPassCache mProviders;
 };
 
 /// This specifies additional passes which must be run on client.
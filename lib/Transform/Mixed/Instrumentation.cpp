@@ -38,17 +38,22 @@
 #include "tsar/Transform/IR/Utils.h"
 #include "tsar/Unparse/SourceUnparserUtils.h"
 #include <llvm/ADT/Statistic.h>
+#include <llvm/Analysis/AliasAnalysis.h>
 #include <llvm/Analysis/CallGraph.h>
 #include <llvm/Analysis/LoopInfo.h>
 #include <llvm/Analysis/MemoryLocation.h>
 #include <llvm/Analysis/ScalarEvolution.h>
+#include <llvm/Analysis/ScalarEvolutionExpressions.h>
+#include <llvm/Analysis/ValueTracking.h>
 #include <llvm/InitializePasses.h>
 #include <llvm/IR/DiagnosticInfo.h>
 #include <llvm/IR/Dominators.h>
 #include <llvm/IR/Function.h>
 #include <llvm/IR/InstIterator.h>
+#include <llvm/IR/IntrinsicInst.h>
 #include <llvm/IR/Module.h>
 #include <llvm/IR/DebugInfoMetadata.h>
+#include <llvm/Support/CommandLine.h>
 #include <llvm/Support/Debug.h>
 #include <llvm/Support/raw_ostream.h>
 #include <llvm/Transforms/Utils/Local.h>
@@ -85,6 +90,13 @@ STATISTIC(NumLoadArray, "Number of registered loads from arrays");
 STATISTIC(NumStore, "Number of registered stores to the memory");
 STATISTIC(NumStoreScalar, "Number of registered stores to scalars");
 STATISTIC(NumStoreArray, "Number of registered stores to arrays");
+STATISTIC(NumLoadRange, "Number of loads registered once per loop");
+STATISTIC(NumStoreRange, "Number of stores registered once per loop");
+STATISTIC(NumDIReuse, "Number of reused loads of metadata descriptions");
+
+static cl::opt<bool> AggregateRanges("instr-llvm-ranges", cl::init(false),
+  cl::desc("Register affine accesses to memory in a loop with a single call "
+           "per loop entry"));
 
 INITIALIZE_PROVIDER_BEGIN(InstrumentationPassProvider, "instr-llvm-provider",
   "Instrumentation Provider")
@@ -229,6 +241,8 @@ void Instrumentation::visitModule(Module &M, InstrumentationPass &IP) {
   mInstrPass = &IP;
   mDIStrings.clear(DIStringRegister::numberOfItemTypes());
   mTypes.clear();
+  mDIPoolPtrs.clear();
+  mDIPtrs.clear();
   auto &Ctx = M.getContext();
   mDIPool = getOrCreateDIPool(M);
   auto IdTy = getInstrIdType(Ctx);
@@ -246,9 +260,11 @@ void Instrumentation::visitModule(Module &M, InstrumentationPass &IP) {
   addNameDAMetadata(*mDIPool, "sapfor.da", "sapfor.di.pool",
     { ConstantAsMetadata::get(PoolSize) });
   NumVariable += NumScalar + NumArray;
-  NumLoad += NumLoadScalar + NumLoadArray;
-  NumStore += NumStore + NumStoreArray;
+  NumLoad += NumLoadScalar + NumLoadArray + NumLoadRange;
+  NumStore += NumStoreScalar + NumStoreArray + NumStoreRange;
   NumMemoryAccesses += NumLoad + NumStore;
+  mDIPoolPtrs.clear();
+  mDIPtrs.clear();
 }
 
 void Instrumentation::reserveIncompleteDIStrings(llvm::Module &M) {
@@ -591,6 +607,8 @@ void Instrumentation::visit(Function &F) {
   visitFunction(F);
   visit(F.begin(), F.end());
   mDT = nullptr;
+  mLI = nullptr;
+  mSE = nullptr;
 }
 
 void Instrumentation::regFunction(Value &F, Type *ReturnTy, unsigned Rank,
@@ -648,6 +666,8 @@ void Instrumentation::visitFunction(llvm::Function &F) {
   auto &CanonicalLoop = Provider.get<CanonicalLoopPass>().getCanonicalLoopInfo();
   auto &SE = Provider.get<ScalarEvolutionWrapperPass>().getSE();
   mDT = &Provider.get<DominatorTreeWrapperPass>().getDomTree();
+  mLI = &LoopInfo;
+  mSE = &SE;
   regLoops(F, LoopInfo, SE, *mDT, RegionInfo, CanonicalLoop);
 }
 
@@ -776,9 +796,10 @@ void Instrumentation::visitCallBase(llvm::CallBase &Call) {
 
 std::tuple<Value *, Value *, Value *, Value *>
 Instrumentation::regMemoryAccessArgs(Value *Ptr, const DebugLoc &DbgLoc,
-    Instruction &InsertBefore) {
+    Instruction &InsertBefore, Value *BasePtr) {
   auto &Ctx = InsertBefore.getContext();
-  auto BasePtr = Ptr->stripInBoundsOffsets();
+  if (!BasePtr)
+    BasePtr = Ptr->stripInBoundsOffsets();
   DIStringRegister::IdTy OpIdx = 0;
   if (auto AI = dyn_cast<AllocaInst>(BasePtr)) {
     OpIdx = mDIStrings[AI];
@@ -832,8 +853,197 @@ void Instrumentation::visitInstruction(Instruction &I) {
   }
 }
 
+/// Return true if all accesses to memory in a specified loop which may refer
+/// to the same object as a specified pointer are simple loads and stores
+/// with addresses which form affine recurrences with a constant step.
+///
+/// Accesses which are registered once per loop entry are registered before
+/// the loop, so the order of registered accesses to the object in the loop
+/// must not be important.
+static bool isAffineAccessesOnly(Loop &L, const Value &Ptr,
+    ScalarEvolution &SE, const DataLayout &DL) {
+  auto *Base = GetUnderlyingObject(&Ptr, DL, 0);
+  for (auto *BB : L.blocks())
+    for (auto &I : *BB) {
+      if (!I.mayReadOrWriteMemory() || I.getMetadata("sapfor.da") ||
+          I.getMetadata("sapfor.da.ignore") || isa<DbgInfoIntrinsic>(I))
+        continue;
+      if (!isa<LoadInst>(I) && !isa<StoreInst>(I))
+        return false;
+      auto *AccessPtr = getLoadStorePointerOperand(&I);
+      auto *AccessBase = GetUnderlyingObject(AccessPtr, DL, 0);
+      if (AccessBase != Base && isIdentifiedObject(AccessBase) &&
+          isIdentifiedObject(Base))
+        continue;
+      if (auto *LI = dyn_cast<LoadInst>(&I)) {
+        if (!LI->isSimple())
+          return false;
+      } else if (!cast<StoreInst>(I).isSimple()) {
+        return false;
+      }
+      auto *AddRec = dyn_cast<SCEVAddRecExpr>(SE.getSCEV(AccessPtr));
+      if (!AddRec || AddRec->getLoop() != &L || !AddRec->isAffine() ||
+          !isa<SCEVConstant>(AddRec->getStepRecurrence(SE)))
+        return false;
+    }
+  return true;
+}
+
+/// Define a function which registers a range of accesses to an array.
+///
+/// Dynamic analyzers may not provide functions to register ranges. So,
+/// a weak definition is emitted which registers each element of a range
+/// separately with a specified function. The definition is replaced by
+/// a definition from a runtime library if it exists.
+static void defineArrRange(Module &M, IntrinsicId RangeId,
+    IntrinsicId ElementId) {
+  auto RangeFun = getDeclaration(&M, RangeId);
+  auto *F = dyn_cast<Function>(RangeFun.getCallee());
+  if (!F || !F->isDeclaration())
+    return;
+  auto &Ctx = M.getContext();
+  auto InstrMD = MDNode::get(Ctx, {});
+  F->setLinkage(GlobalValue::WeakAnyLinkage);
+  F->setMetadata("sapfor.da", InstrMD);
+  auto ArgItr = F->arg_begin();
+  auto *DILoc = &*ArgItr++;
+  auto *Addr = &*ArgItr++;
+  auto *DIVar = &*ArgItr++;
+  auto *ArrayBase = &*ArgItr++;
+  auto *Stride = &*ArgItr++;
+  auto *Count = &*ArgItr;
+  auto *SizeTy = Count->getType();
+  auto *EntryBB = BasicBlock::Create(Ctx, "entry", F);
+  auto *HeaderBB = BasicBlock::Create(Ctx, "header", F);
+  auto *BodyBB = BasicBlock::Create(Ctx, "body", F);
+  auto *ExitBB = BasicBlock::Create(Ctx, "exit", F);
+  BranchInst::Create(HeaderBB, EntryBB);
+  auto *Idx = PHINode::Create(SizeTy, 2, "idx", HeaderBB);
+  Idx->addIncoming(ConstantInt::get(SizeTy, 0), EntryBB);
+  auto *Cmp = new ICmpInst(*HeaderBB, CmpInst::ICMP_ULT, Idx, Count, "cmp");
+  BranchInst::Create(BodyBB, ExitBB, Cmp, HeaderBB);
+  auto *Offset = BinaryOperator::CreateMul(Idx, Stride, "offset", BodyBB);
+  assert(Addr->getType() == Type::getInt8PtrTy(Ctx) &&
+    "Address must be a pointer to bytes!");
+  auto *Elem = GetElementPtrInst::Create(Type::getInt8Ty(Ctx), Addr, {Offset},
+    "elem", BodyBB);
+  auto ElementFun = getDeclaration(&M, ElementId);
+  CallInst::Create(ElementFun, {DILoc, Elem, DIVar, ArrayBase}, "", BodyBB);
+  auto *Inc = BinaryOperator::CreateNUW(BinaryOperator::Add, Idx,
+    ConstantInt::get(SizeTy, 1), "inc", BodyBB);
+  Idx->addIncoming(Inc, BodyBB);
+  BranchInst::Create(HeaderBB, BodyBB);
+  ReturnInst::Create(Ctx, ExitBB);
+}
+
+bool Instrumentation::regMemoryRange(Instruction &I, Value &Ptr,
+    bool IsWrite) {
+  if (!AggregateRanges)
+    return false;
+  // Atomic and volatile accesses must be registered in the order they are
+  // performed.
+  if (auto *LI = dyn_cast<LoadInst>(&I)) {
+    if (!LI->isSimple())
+      return false;
+  } else if (auto *SI = dyn_cast<StoreInst>(&I)) {
+    if (!SI->isSimple())
+      return false;
+  } else {
+    return false;
+  }
+  assert(mDT && mLI && mSE && "Function must be already visited!");
+  auto *L = mLI->getLoopFor(I.getParent());
+  if (!L)
+    return false;
+  // Note, that a preheader may be created while loops are registered.
+  // In this case it is not available in the dominator tree and scalar
+  // evolution can not expand expressions in it.
+  auto *Preheader = L->getLoopPreheader();
+  auto *Latch = L->getLoopLatch();
+  auto *Exiting = L->getExitingBlock();
+  if (!Preheader || !Latch || !Exiting || !mDT->getNode(Preheader) ||
+      !mDT->dominates(I.getParent(), Latch))
+    return false;
+  // The instruction is executed once in each iteration which reaches
+  // the latch. If the loop exits from the header the last iteration does not
+  // reach the latch.
+  bool ExecutedOnExit = Exiting == Latch || I.getParent() == Exiting;
+  if (!ExecutedOnExit && Exiting != L->getHeader())
+    return false;
+  auto *AddRec = dyn_cast<SCEVAddRecExpr>(mSE->getSCEV(&Ptr));
+  if (!AddRec || AddRec->getLoop() != L || !AddRec->isAffine())
+    return false;
+  auto *Stride = dyn_cast<SCEVConstant>(AddRec->getStepRecurrence(*mSE));
+  if (!Stride)
+    return false;
+  auto *BackedgeCount = mSE->getBackedgeTakenCount(L);
+  if (isa<SCEVCouldNotCompute>(BackedgeCount))
+    return false;
+  if (!isAffineAccessesOnly(*L, Ptr, *mSE, I.getModule()->getDataLayout()))
+    return false;
+  auto &InsertBefore = *Preheader->getTerminator();
+  auto *BasePtr = Ptr.stripInBoundsOffsets();
+  if (auto *BaseInst = dyn_cast<Instruction>(BasePtr))
+    if (!mDT->dominates(BaseInst, &InsertBefore))
+      return false;
+  auto *M = I.getModule();
+  if (IsWrite)
+    defineArrRange(*M, IntrinsicId::write_arr_range,
+                   IntrinsicId::write_arr_end);
+  else
+    defineArrRange(*M, IntrinsicId::read_arr_range, IntrinsicId::read_arr);
+  auto Fun = getDeclaration(M,
+    IsWrite ? IntrinsicId::write_arr_range : IntrinsicId::read_arr_range);
+  auto *FuncTy = Fun.getFunctionType();
+  assert(FuncTy->getNumParams() > 5 && "Too few arguments!");
+  auto *SizeTy = dyn_cast<IntegerType>(FuncTy->getParamType(4));
+  assert(SizeTy && FuncTy->getParamType(5) == SizeTy &&
+    "Stride and count must have the same integer type!");
+  if (BackedgeCount->getType()->getIntegerBitWidth() > SizeTy->getBitWidth())
+    return false;
+  auto *Count = mSE->getNoopOrZeroExtend(BackedgeCount, SizeTy);
+  if (ExecutedOnExit)
+    Count = mSE->getAddExpr(Count, mSE->getOne(SizeTy));
+  if (!isSafeToExpandAt(AddRec->getStart(), &InsertBefore, *mSE) ||
+      !isSafeToExpandAt(Count, &InsertBefore, *mSE))
+    return false;
+  auto *CountValue = computeSCEV(Count, *SizeTy, false, *mSE, *mDT,
+    InsertBefore);
+  if (!CountValue)
+    return false;
+  LLVM_DEBUG(dbgs() << "[INSTR]: process range "; I.print(dbgs());
+    dbgs() << "\n");
+  SCEVExpander Exp(*mSE, M->getDataLayout(), "");
+  auto *Start = Exp.expandCodeFor(AddRec->getStart(), Ptr.getType(),
+    &InsertBefore);
+  if (auto *StartInst = dyn_cast<Instruction>(Start))
+    setMDForDeadInstructions(StartInst);
+  llvm::Value *DILoc, *Addr, *DIVar, *ArrayBase;
+  std::tie(DILoc, Addr, DIVar, ArrayBase) =
+    regMemoryAccessArgs(Start, I.getDebugLoc(), InsertBefore, BasePtr);
+  auto *MD = MDNode::get(M->getContext(), {});
+  if (!ArrayBase) {
+    ArrayBase = new BitCastInst(BasePtr, Type::getInt8PtrTy(M->getContext()),
+      BasePtr->getName() + ".arraybase", &InsertBefore);
+    cast<Instruction>(ArrayBase)->setMetadata("sapfor.da", MD);
+  }
+  auto *StrideValue = ConstantInt::get(SizeTy,
+    Stride->getAPInt().sextOrTrunc(SizeTy->getBitWidth()));
+  auto Call = CallInst::Create(FuncTy, Fun.getCallee(),
+    {DILoc, Addr, DIVar, ArrayBase, StrideValue, CountValue}, "",
+    &InsertBefore);
+  Call->setMetadata("sapfor.da", MD);
+  if (IsWrite)
+    ++NumStoreRange;
+  else
+    ++NumLoadRange;
+  return true;
+}
+
 void Instrumentation::regReadMemory(Instruction &I, Value &Ptr) {
-  if (I.getMetadata("sapfor.da"))
+  if (I.getMetadata("sapfor.da") || I.getMetadata("sapfor.da.ignore"))
+    return;
+  if (regMemoryRange(I, Ptr, false))
     return;
   LLVM_DEBUG(dbgs() << "[INSTR]: process "; I.print(dbgs()); dbgs() << "\n");
   auto *M = I.getModule();
@@ -856,7 +1066,9 @@ void Instrumentation::regReadMemory(Instruction &I, Value &Ptr) {
 }
 
 void Instrumentation::regWriteMemory(Instruction &I, Value &Ptr) {
-  if (I.getMetadata("sapfor.da"))
+  if (I.getMetadata("sapfor.da") || I.getMetadata("sapfor.da.ignore"))
+    return;
+  if (regMemoryRange(I, Ptr, true))
     return;
   LLVM_DEBUG(dbgs() << "[INSTR]: process "; I.print(dbgs()); dbgs() << "\n");
   BasicBlock::iterator InsertBefore(I);
@@ -982,9 +1194,8 @@ void Instrumentation::createInitDICall(const llvm::Twine &Str,
   auto *M = mInitDIAll->getParent();
   auto InitDIFunc = getDeclaration(M, IntrinsicId::init_di);
   auto IdxV = ConstantInt::get(Type::getInt64Ty(M->getContext()), Idx);
-  auto DIPoolPtr = new LoadInst(mDIPool->getValueType(), mDIPool, "dipool", T);
-  auto GEP =
-    GetElementPtrInst::Create(nullptr, DIPoolPtr, { IdxV }, "arrayidx", T);
+  auto GEP = GetElementPtrInst::Create(
+    nullptr, &getDIPoolPtr(*mInitDIAll), { IdxV }, "arrayidx", T);
   SmallString<256> SingleStr;
   auto DIString = createDIStringPtr(Str.toStringRef(SingleStr), *T);
   auto Offset = &*mInitDIAll->arg_begin();
@@ -1005,20 +1216,39 @@ GetElementPtrInst* Instrumentation::createDIStringPtr(
     Var, { Int0,Int0 }, "distring", &InsertBefore);
 }
 
+LoadInst & Instrumentation::getDIPoolPtr(Function &F) {
+  assert(mDIPool && "Pool of metadata strings must not be null!");
+  assert(!F.empty() && "Function must have a body!");
+  auto &DIPoolPtr = mDIPoolPtrs[&F];
+  if (!DIPoolPtr) {
+    // The pool is allocated in the entry point before the first instruction
+    // of the original entry block. So, the load is executed after allocation
+    // even if it is located in the entry point.
+    DIPoolPtr = new LoadInst(mDIPool->getValueType(), mDIPool, "dipool",
+      &*F.getEntryBlock().getFirstInsertionPt());
+    DIPoolPtr->setMetadata("sapfor.da", MDNode::get(F.getContext(), {}));
+  }
+  return *DIPoolPtr;
+}
+
 LoadInst* Instrumentation::createPointerToDI(
     DIStringRegister::IdTy Idx, Instruction& InsertBefore) {
+  auto &F = *InsertBefore.getFunction();
+  auto &DI = mDIPtrs[std::make_pair(&F, Idx)];
+  if (DI) {
+    ++NumDIReuse;
+    return DI;
+  }
   auto &Ctx = InsertBefore.getContext();
   auto *MD = MDNode::get(Ctx, {});
   auto IdxV = ConstantInt::get(Type::getInt64Ty(Ctx), Idx);
-  auto DIPoolPtr =
-    new LoadInst(mDIPool->getValueType(), mDIPool, "dipool", &InsertBefore);
-  DIPoolPtr->setMetadata("sapfor.da", MD);
-  auto GEP = GetElementPtrInst::Create(nullptr, DIPoolPtr, {IdxV}, "arrayidx");
+  auto &DIPoolPtr = getDIPoolPtr(F);
+  auto GEP = GetElementPtrInst::Create(nullptr, &DIPoolPtr, {IdxV}, "arrayidx");
   GEP->setMetadata("sapfor.da", MD);
-  GEP->insertAfter(DIPoolPtr);
+  GEP->insertAfter(&DIPoolPtr);
   GEP->setIsInBounds(true);
   auto &DL = InsertBefore.getModule()->getDataLayout();
-  auto DI = new LoadInst(GEP->getResultElementType(), GEP, "di", false,
+  DI = new LoadInst(GEP->getResultElementType(), GEP, "di", false,
                          DL.getABITypeAlign(GEP->getResultElementType()));
   DI->setMetadata("sapfor.da", MD);
   DI->insertAfter(GEP);
@@ -0,0 +1,210 @@
+//===- InstrumentationPruning.cpp - Instrumentation Pruning -----*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2020 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file implements a pass which marks accesses to memory that should not
+// be instrumented. Dynamic analysis is used to clarify 'may' dependencies
+// only, so it is not necessary to instrument an access if traits of accessed
+// memory in each loop which contains the access have been already precisely
+// determined by static analysis.
+//
+// Traits are computed for loops in the current function only, however
+// the same access may produce a 'may' dependence in a loop in a caller.
+// So, an access is omitted only if the accessed memory is not visible outside
+// the function or if the function can not be called from a loop.
+//
+//===----------------------------------------------------------------------===//
+
+#include "tsar/Analysis/Memory/DIClientServerInfo.h"
+#include "tsar/Analysis/Memory/DIDependencyAnalysis.h"
+#include "tsar/Analysis/Memory/DIEstimateMemory.h"
+#include "tsar/Analysis/Memory/EstimateMemory.h"
+#include "tsar/Transform/Mixed/Passes.h"
+#include <bcl/utility.h>
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/Statistic.h>
+#include <llvm/Analysis/CaptureTracking.h>
+#include <llvm/Analysis/LoopInfo.h>
+#include <llvm/Analysis/MemoryLocation.h>
+#include <llvm/Analysis/ValueTracking.h>
+#include <llvm/InitializePasses.h>
+#include <llvm/IR/DiagnosticInfo.h>
+#include <llvm/IR/Dominators.h>
+#include <llvm/IR/InstIterator.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/Module.h>
+
+using namespace llvm;
+using namespace tsar;
+
+#undef DEBUG_TYPE
+#define DEBUG_TYPE "instr-llvm-prune"
+
+STATISTIC(NumPrunedAccesses, "Number of accesses which are not instrumented");
+STATISTIC(NumKeptAccesses, "Number of instrumented accesses in loops");
+
+namespace {
+/// This marks accesses to memory with precisely known traits with
+/// 'sapfor.da.ignore' metadata, so they will not be instrumented.
+class InstrumentationPruningPass :
+  public FunctionPass, private bcl::Uncopyable {
+public:
+  static char ID;
+
+  explicit InstrumentationPruningPass(StringRef InstrEntry = "") :
+      FunctionPass(ID), mInstrEntry(InstrEntry) {
+    initializeInstrumentationPruningPassPass(*PassRegistry::getPassRegistry());
+  }
+
+  bool runOnFunction(Function &F) override;
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.addRequired<LoopInfoWrapperPass>();
+    AU.addRequired<DominatorTreeWrapperPass>();
+    AU.addRequired<EstimateMemoryPass>();
+    AU.addRequired<DIEstimateMemoryPass>();
+    AU.addRequired<DIDependencyAnalysisPass>();
+    AU.setPreservesAll();
+  }
+
+private:
+  /// Returns true if a specified function can not be called from a loop.
+  ///
+  /// Loops in callers are not analyzed, so only an entry point of a program
+  /// which is not called explicitly is known to be called outside loops.
+  bool isCalledOutsideLoops(const Function &F) const;
+
+  std::string mInstrEntry;
+};
+
+/// Returns true if dynamic analysis can not clarify traits of memory from
+/// a specified alias node.
+bool isPrecise(const DIAliasTrait &TS) {
+  if (TS.is_any<trait::AddressAccess, trait::DynamicPrivate>())
+    return false;
+  if (hasNoDep(TS))
+    return true;
+  return TS.size() == 1 &&
+         TS.is_any<trait::Private, trait::FirstPrivate, trait::LastPrivate,
+                   trait::SecondToLastPrivate, trait::Induction,
+                   trait::Reduction>();
+}
+}
+
+char InstrumentationPruningPass::ID = 0;
+INITIALIZE_PASS_BEGIN(InstrumentationPruningPass, "instr-llvm-prune",
+  "Instrumentation Pruning", false, false)
+INITIALIZE_PASS_DEPENDENCY(LoopInfoWrapperPass)
+INITIALIZE_PASS_DEPENDENCY(DominatorTreeWrapperPass)
+INITIALIZE_PASS_DEPENDENCY(EstimateMemoryPass)
+INITIALIZE_PASS_DEPENDENCY(DIEstimateMemoryPass)
+INITIALIZE_PASS_DEPENDENCY(DIDependencyAnalysisPass)
+INITIALIZE_PASS_END(InstrumentationPruningPass, "instr-llvm-prune",
+  "Instrumentation Pruning", false, false)
+
+FunctionPass * llvm::createInstrumentationPruningPass(StringRef InstrEntry) {
+  return new InstrumentationPruningPass(InstrEntry);
+}
+
+bool InstrumentationPruningPass::isCalledOutsideLoops(
+    const Function &F) const {
+  if (!F.use_empty())
+    return false;
+  // Use the same entry point as InstrumentationPass.
+  if (!mInstrEntry.empty())
+    return F.getName() == mInstrEntry;
+  auto *EntryPoint = F.getParent()->getFunction("main");
+  if (!EntryPoint)
+    EntryPoint = F.getParent()->getFunction("MAIN_");
+  return EntryPoint == &F;
+}
+
+bool InstrumentationPruningPass::runOnFunction(Function &F) {
+  auto &LI = getAnalysis<LoopInfoWrapperPass>().getLoopInfo();
+  if (LI.empty())
+    return false;
+  auto &DIEMPass = getAnalysis<DIEstimateMemoryPass>();
+  if (!DIEMPass.isConstructed())
+    return false;
+  DIMemoryClientServerInfo DIMInfo(DIEMPass.getAliasTree(), *this, F);
+  if (!DIMInfo.isValid())
+    return false;
+  auto &DT = getAnalysis<DominatorTreeWrapperPass>().getDomTree();
+  auto &AT = getAnalysis<EstimateMemoryPass>().getAliasTree();
+  auto &DL = F.getParent()->getDataLayout();
+  auto *IgnoreMD = MDNode::get(F.getContext(), {});
+  bool IsCalledOutsideLoops = isCalledOutsideLoops(F);
+  // Memory which may be accessed outside the function may have
+  // unknown traits in loops of callers.
+  DenseMap<const AllocaInst *, bool> IsLocalMemory;
+  auto isLocal = [&IsLocalMemory, &DL](const Instruction &I) {
+    auto *AI = dyn_cast<AllocaInst>(
+      GetUnderlyingObject(getLoadStorePointerOperand(&I), DL, 0));
+    if (!AI)
+      return false;
+    auto Info = IsLocalMemory.try_emplace(AI);
+    if (Info.second)
+      Info.first->second = !PointerMayBeCaptured(AI, true, true);
+    return Info.first->second;
+  };
+  unsigned NumInLoops = 0, NumPruned = 0;
+  for (auto &I : instructions(F)) {
+    if (!isa<LoadInst>(I) && !isa<StoreInst>(I))
+      continue;
+    auto *L = LI.getLoopFor(I.getParent());
+    if (!L)
+      continue;
+    ++NumInLoops;
+    if (!IsCalledOutsideLoops && !isLocal(I))
+      continue;
+    auto *EM = AT.find(MemoryLocation::get(&I));
+    if (!EM)
+      continue;
+    auto *DIM =
+      DIMInfo.findFromClient(*EM->getTopLevelParent(), DL, DT).get<Clone>();
+    if (!DIM)
+      continue;
+    bool IsPrecise = true;
+    for (; L && IsPrecise; L = L->getParentLoop()) {
+      auto *DIDepSet = DIMInfo.findFromClient(*L);
+      if (!DIDepSet) {
+        IsPrecise = false;
+        break;
+      }
+      auto TraitItr = DIDepSet->find_as(DIM->getAliasNode());
+      IsPrecise = TraitItr != DIDepSet->end() && isPrecise(*TraitItr);
+    }
+    if (!IsPrecise)
+      continue;
+    LLVM_DEBUG(dbgs() << "[INSTR PRUNE]: ignore "; I.print(dbgs());
+      dbgs() << "\n");
+    I.setMetadata("sapfor.da.ignore", IgnoreMD);
+    ++NumPruned;
+  }
+  NumPrunedAccesses += NumPruned;
+  NumKeptAccesses += NumInLoops - NumPruned;
+  if (NumPruned == 0)
+    return false;
+  F.getContext().diagnose(DiagnosticInfoInlineAsm(
+    Twine("instrumentation of ") + Twine(NumPruned) + " of " +
+    Twine(NumInLoops) + " accesses to memory in loops is omitted in '" +
+    F.getName() + "', their traits have been determined statically",
+    DS_Remark));
+  return true;
+}
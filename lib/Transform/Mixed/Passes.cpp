@@ -29,6 +29,7 @@ using namespace llvm;
 
 void llvm::initializeMixedTransform(PassRegistry &Registry) {
   initializeInstrumentationPassPass(Registry);
+  initializeInstrumentationPruningPassPass(Registry);
   initializeDILoopRetrieverPassPass(Registry);
   initializeDINodeRetrieverPassPass(Registry);
   initializeFlangDummyAliasAnalysisPass(Registry);
@@ -0,0 +1,5 @@
+void foo(double *A) { A[0] = A[1]; }
+//CHECK: Printing analysis 'Dependency Analysis (Metadata)' for function 'foo':
+//CHECK: Printing analysis 'Dependency Analysis (Metadata)' for function 'bar':
+//CHECK-1: Printing analysis 'Dependency Analysis (Metadata)' for function 'bar':
+//CHECK-1: Printing analysis 'Dependency Analysis (Metadata)' for function 'foo':
@@ -0,0 +1 @@
+void bar(double *A) { A[5] = 10; }
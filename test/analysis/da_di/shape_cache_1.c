@@ -0,0 +1,61 @@
+void foo(int *P) {
+  for (int I = 0; I < 10; ++I)
+    P[0] = P[1];
+}
+
+// Accesses in both loops have the same shape. However, the base of accesses
+// in 'bar' changes in each iteration, so results for 'foo' can not be reused.
+void bar(int **Q) {
+  for (int I = 0; I < 10; ++I) {
+    int *P = Q[I];
+    P[0] = P[1];
+  }
+}
+//CHECK: Printing analysis 'Dependency Analysis (Metadata)' for function 'foo':
+//CHECK:  loop at depth 1 shape_cache_1.c:2:3
+//CHECK:    first private:
+//CHECK:     <*P:1, ?>
+//CHECK:    second to last private:
+//CHECK:     <*P:1, ?>
+//CHECK:    induction:
+//CHECK:     <I:2[2:3], 4>:[Int,0,10,1]
+//CHECK:    read only:
+//CHECK:     <P:1, 8>
+//CHECK:    lock:
+//CHECK:     <I:2[2:3], 4>
+//CHECK:    header access:
+//CHECK:     <I:2[2:3], 4>
+//CHECK:    explicit access:
+//CHECK:     <I:2[2:3], 4> | <P:1, 8>
+//CHECK:    explicit access (separate):
+//CHECK:     <I:2[2:3], 4> <P:1, 8>
+//CHECK:    lock (separate):
+//CHECK:     <I:2[2:3], 4>
+//CHECK:    direct access (separate):
+//CHECK:     <*P:1, ?> <I:2[2:3], 4> <P:1, 8>
+//CHECK: Printing analysis 'Dependency Analysis (Metadata)' for function 'bar':
+//CHECK:  loop at depth 1 shape_cache_1.c:9:3
+//CHECK:    private:
+//CHECK:     <P:10[9:32], 8>
+//CHECK:    output:
+//CHECK:     <*P:{11:5|10:10}, ?>
+//CHECK:    anti:
+//CHECK:     <*P:{11:5|10:10}, ?>
+//CHECK:    flow:
+//CHECK:     <*P:{11:5|10:10}, ?>
+//CHECK:    induction:
+//CHECK:     <I:9[9:3], 4>:[Int,0,10,1]
+//CHECK:    read only:
+//CHECK:     <*Q:8, ?> | <Q:8, 8>
+//CHECK:    lock:
+//CHECK:     <I:9[9:3], 4>
+//CHECK:    header access:
+//CHECK:     <I:9[9:3], 4>
+//CHECK:    explicit access:
+//CHECK:     <I:9[9:3], 4> | <P:10[9:32], 8> | <Q:8, 8>
+//CHECK:    explicit access (separate):
+//CHECK:     <I:9[9:3], 4> <P:10[9:32], 8> <Q:8, 8>
+//CHECK:    lock (separate):
+//CHECK:     <I:9[9:3], 4>
+//CHECK:    direct access (separate):
+//CHECK:     <*P:{11:5|10:10}, ?> <*Q:8, ?> <I:9[9:3], 4> <P:10[9:32], 8> <Q:8, 8>
@@ -0,0 +1,93 @@
+double U[100][100];
+
+// Loops in 'foo' and 'bar' access the same global array in the same way.
+// So, results of dependence tests for 'foo' are reused for 'bar'.
+void foo() {
+  for (int I = 2; I < 100; ++I)
+    for (int J = 0; J < 99; ++J)
+      U[I][J] = U[I-1][J] + U[I - 2][J + 1];
+}
+
+void bar() {
+  for (int I = 2; I < 100; ++I)
+    for (int J = 0; J < 99; ++J)
+      U[I][J] = U[I-1][J] + U[I - 2][J + 1];
+}
+//CHECK: Printing analysis 'Dependency Analysis (Metadata)' for function 'foo':
+//CHECK:  loop at depth 1 shape_cache_2.c:6:3
+//CHECK:    private:
+//CHECK:     <J:7[7:5], 4>
+//CHECK:    flow:
+//CHECK:     <U, 80000>:[1:2,-1:0]
+//CHECK:    induction:
+//CHECK:     <I:6[6:3], 4>:[Int,2,100,1]
+//CHECK:    lock:
+//CHECK:     <I:6[6:3], 4>
+//CHECK:    header access:
+//CHECK:     <I:6[6:3], 4>
+//CHECK:    explicit access:
+//CHECK:     <I:6[6:3], 4> | <J:7[7:5], 4>
+//CHECK:    explicit access (separate):
+//CHECK:     <I:6[6:3], 4> <J:7[7:5], 4>
+//CHECK:    lock (separate):
+//CHECK:     <I:6[6:3], 4>
+//CHECK:    direct access (separate):
+//CHECK:     <I:6[6:3], 4> <J:7[7:5], 4> <U, 80000>
+//CHECK:   loop at depth 2 shape_cache_2.c:7:5
+//CHECK:     shared:
+//CHECK:      <U, 80000>
+//CHECK:     induction:
+//CHECK:      <J:7[7:5], 4>:[Int,0,99,1]
+//CHECK:     read only:
+//CHECK:      <I:6[6:3], 4>
+//CHECK:     lock:
+//CHECK:      <J:7[7:5], 4>
+//CHECK:     header access:
+//CHECK:      <J:7[7:5], 4>
+//CHECK:     explicit access:
+//CHECK:      <I:6[6:3], 4> | <J:7[7:5], 4>
+//CHECK:     explicit access (separate):
+//CHECK:      <I:6[6:3], 4> <J:7[7:5], 4>
+//CHECK:     lock (separate):
+//CHECK:      <J:7[7:5], 4>
+//CHECK:     direct access (separate):
+//CHECK:      <I:6[6:3], 4> <J:7[7:5], 4> <U, 80000>
+//CHECK: Printing analysis 'Dependency Analysis (Metadata)' for function 'bar':
+//CHECK:  loop at depth 1 shape_cache_2.c:12:3
+//CHECK:    private:
+//CHECK:     <J:13[13:5], 4>
+//CHECK:    flow:
+//CHECK:     <U, 80000>:[1:2,-1:0]
+//CHECK:    induction:
+//CHECK:     <I:12[12:3], 4>:[Int,2,100,1]
+//CHECK:    lock:
+//CHECK:     <I:12[12:3], 4>
+//CHECK:    header access:
+//CHECK:     <I:12[12:3], 4>
+//CHECK:    explicit access:
+//CHECK:     <I:12[12:3], 4> | <J:13[13:5], 4>
+//CHECK:    explicit access (separate):
+//CHECK:     <I:12[12:3], 4> <J:13[13:5], 4>
+//CHECK:    lock (separate):
+//CHECK:     <I:12[12:3], 4>
+//CHECK:    direct access (separate):
+//CHECK:     <I:12[12:3], 4> <J:13[13:5], 4> <U, 80000>
+//CHECK:   loop at depth 2 shape_cache_2.c:13:5
+//CHECK:     shared:
+//CHECK:      <U, 80000>
+//CHECK:     induction:
+//CHECK:      <J:13[13:5], 4>:[Int,0,99,1]
+//CHECK:     read only:
+//CHECK:      <I:12[12:3], 4>
+//CHECK:     lock:
+//CHECK:      <J:13[13:5], 4>
+//CHECK:     header access:
+//CHECK:      <J:13[13:5], 4>
+//CHECK:     explicit access:
+//CHECK:      <I:12[12:3], 4> | <J:13[13:5], 4>
+//CHECK:     explicit access (separate):
+//CHECK:      <I:12[12:3], 4> <J:13[13:5], 4>
+//CHECK:     lock (separate):
+//CHECK:      <J:13[13:5], 4>
+//CHECK:     direct access (separate):
+//CHECK:      <I:12[12:3], 4> <J:13[13:5], 4> <U, 80000>
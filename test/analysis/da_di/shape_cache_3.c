@@ -0,0 +1,168 @@
+double U[100][100];
+
+// Both loop nests have the same subscripts and bounds, however the second one
+// is guarded by a condition, so the shape of tests differs and results
+// for the first nest are not reused for the second one.
+void foo(int M) {
+  for (int I = 2; I < 100; ++I)
+    for (int J = 0; J < 99; ++J)
+      U[I][J] = U[I-1][J] + U[I - 2][J + 1];
+  if (M > 0)
+    for (int I = 2; I < 100; ++I)
+      for (int J = 0; J < 99; ++J)
+        U[I][J] = U[I-1][J] + U[I - 2][J + 1];
+}
+//CHECK: Printing analysis 'Dependency Analysis (Metadata)' for function 'foo':
+//CHECK:  loop at depth 1 shape_cache_3.c:7:3
+//CHECK:    private:
+//CHECK:     <J:8[8:5], 4>
+//CHECK:    flow:
+//CHECK:     <U, 80000>:[1:2,-1:0]
+//CHECK:    induction:
+//CHECK:     <I:7[7:3], 4>:[Int,2,100,1]
+//CHECK:    lock:
+//CHECK:     <I:7[7:3], 4>
+//CHECK:    header access:
+//CHECK:     <I:7[7:3], 4>
+//CHECK:    explicit access:
+//CHECK:     <I:7[7:3], 4> | <J:8[8:5], 4>
+//CHECK:    explicit access (separate):
+//CHECK:     <I:7[7:3], 4> <J:8[8:5], 4>
+//CHECK:    lock (separate):
+//CHECK:     <I:7[7:3], 4>
+//CHECK:    direct access (separate):
+//CHECK:     <I:7[7:3], 4> <J:8[8:5], 4> <U, 80000>
+//CHECK:   loop at depth 2 shape_cache_3.c:8:5
+//CHECK:     shared:
+//CHECK:      <U, 80000>
+//CHECK:     induction:
+//CHECK:      <J:8[8:5], 4>:[Int,0,99,1]
+//CHECK:     read only:
+//CHECK:      <I:7[7:3], 4>
+//CHECK:     lock:
+//CHECK:      <J:8[8:5], 4>
+//CHECK:     header access:
+//CHECK:      <J:8[8:5], 4>
+//CHECK:     explicit access:
+//CHECK:      <I:7[7:3], 4> | <J:8[8:5], 4>
+//CHECK:     explicit access (separate):
+//CHECK:      <I:7[7:3], 4> <J:8[8:5], 4>
+//CHECK:     lock (separate):
+//CHECK:      <J:8[8:5], 4>
+//CHECK:     direct access (separate):
+//CHECK:      <I:7[7:3], 4> <J:8[8:5], 4> <U, 80000>
+//CHECK:  loop at depth 1 shape_cache_3.c:11:5
+//CHECK:    private:
+//CHECK:     <J:12[12:7], 4>
+//CHECK:    flow:
+//CHECK:     <U, 80000>:[1:2,-1:0]
+//CHECK:    induction:
+//CHECK:     <I:11[11:5], 4>:[Int,2,100,1]
+//CHECK:    lock:
+//CHECK:     <I:11[11:5], 4>
+//CHECK:    header access:
+//CHECK:     <I:11[11:5], 4>
+//CHECK:    explicit access:
+//CHECK:     <I:11[11:5], 4> | <J:12[12:7], 4>
+//CHECK:    explicit access (separate):
+//CHECK:     <I:11[11:5], 4> <J:12[12:7], 4>
+//CHECK:    lock (separate):
+//CHECK:     <I:11[11:5], 4>
+//CHECK:    direct access (separate):
+//CHECK:     <I:11[11:5], 4> <J:12[12:7], 4> <U, 80000>
+//CHECK:   loop at depth 2 shape_cache_3.c:12:7
+//CHECK:     shared:
+//CHECK:      <U, 80000>
+//CHECK:     induction:
+//CHECK:      <J:12[12:7], 4>:[Int,0,99,1]
+//CHECK:     read only:
+//CHECK:      <I:11[11:5], 4>
+//CHECK:     lock:
+//CHECK:      <J:12[12:7], 4>
+//CHECK:     header access:
+//CHECK:      <J:12[12:7], 4>
+//CHECK:     explicit access:
+//CHECK:      <I:11[11:5], 4> | <J:12[12:7], 4>
+//CHECK:     explicit access (separate):
+//CHECK:      <I:11[11:5], 4> <J:12[12:7], 4>
+//CHECK:     lock (separate):
+//CHECK:      <J:12[12:7], 4>
+//CHECK:     direct access (separate):
+//CHECK:      <I:11[11:5], 4> <J:12[12:7], 4> <U, 80000>
+//CHECK-1: Printing analysis 'Dependency Analysis (Metadata)' for function 'foo':
+//CHECK-1:  loop at depth 1 shape_cache_3.c:7:3
+//CHECK-1:    private:
+//CHECK-1:     <J:8[8:5], 4>
+//CHECK-1:    flow:
+//CHECK-1:     <U, 80000>:[1:2,-1:0]
+//CHECK-1:    induction:
+//CHECK-1:     <I:7[7:3], 4>:[Int,2,100,1]
+//CHECK-1:    lock:
+//CHECK-1:     <I:7[7:3], 4>
+//CHECK-1:    header access:
+//CHECK-1:     <I:7[7:3], 4>
+//CHECK-1:    explicit access:
+//CHECK-1:     <I:7[7:3], 4> | <J:8[8:5], 4>
+//CHECK-1:    explicit access (separate):
+//CHECK-1:     <I:7[7:3], 4> <J:8[8:5], 4>
+//CHECK-1:    lock (separate):
+//CHECK-1:     <I:7[7:3], 4>
+//CHECK-1:    direct access (separate):
+//CHECK-1:     <I:7[7:3], 4> <J:8[8:5], 4> <U, 80000>
+//CHECK-1:   loop at depth 2 shape_cache_3.c:8:5
+//CHECK-1:     shared:
+//CHECK-1:      <U, 80000>
+//CHECK-1:     induction:
+//CHECK-1:      <J:8[8:5], 4>:[Int,0,99,1]
+//CHECK-1:     read only:
+//CHECK-1:      <I:7[7:3], 4>
+//CHECK-1:     lock:
+//CHECK-1:      <J:8[8:5], 4>
+//CHECK-1:     header access:
+//CHECK-1:      <J:8[8:5], 4>
+//CHECK-1:     explicit access:
+//CHECK-1:      <I:7[7:3], 4> | <J:8[8:5], 4>
+//CHECK-1:     explicit access (separate):
+//CHECK-1:      <I:7[7:3], 4> <J:8[8:5], 4>
+//CHECK-1:     lock (separate):
+//CHECK-1:      <J:8[8:5], 4>
+//CHECK-1:     direct access (separate):
+//CHECK-1:      <I:7[7:3], 4> <J:8[8:5], 4> <U, 80000>
+//CHECK-1:  loop at depth 1 shape_cache_3.c:11:5
+//CHECK-1:    private:
+//CHECK-1:     <J:12[12:7], 4>
+//CHECK-1:    flow:
+//CHECK-1:     <U, 80000>:[1:2,-1:0]
+//CHECK-1:    induction:
+//CHECK-1:     <I:11[11:5], 4>:[Int,2,100,1]
+//CHECK-1:    lock:
+//CHECK-1:     <I:11[11:5], 4>
+//CHECK-1:    header access:
+//CHECK-1:     <I:11[11:5], 4>
+//CHECK-1:    explicit access:
+//CHECK-1:     <I:11[11:5], 4> | <J:12[12:7], 4>
+//CHECK-1:    explicit access (separate):
+//CHECK-1:     <I:11[11:5], 4> <J:12[12:7], 4>
+//CHECK-1:    lock (separate):
+//CHECK-1:     <I:11[11:5], 4>
+//CHECK-1:    direct access (separate):
+//CHECK-1:     <I:11[11:5], 4> <J:12[12:7], 4> <U, 80000>
+//CHECK-1:   loop at depth 2 shape_cache_3.c:12:7
+//CHECK-1:     shared:
+//CHECK-1:      <U, 80000>
+//CHECK-1:     induction:
+//CHECK-1:      <J:12[12:7], 4>:[Int,0,99,1]
+//CHECK-1:     read only:
+//CHECK-1:      <I:11[11:5], 4>
+//CHECK-1:     lock:
+//CHECK-1:      <J:12[12:7], 4>
+//CHECK-1:     header access:
+//CHECK-1:      <J:12[12:7], 4>
+//CHECK-1:     explicit access:
+//CHECK-1:      <I:11[11:5], 4> | <J:12[12:7], 4>
+//CHECK-1:     explicit access (separate):
+//CHECK-1:      <I:11[11:5], 4> <J:12[12:7], 4>
+//CHECK-1:     lock (separate):
+//CHECK-1:      <J:12[12:7], 4>
+//CHECK-1:     direct access (separate):
+//CHECK-1:      <I:11[11:5], 4> <J:12[12:7], 4> <U, 80000>
@@ -92,6 +92,20 @@ void sapforWriteArrEnd(void *DILoc, void *Addr, void *DIVar, void *ArrBase) {
   printf("DIVar = %s\nDILoc = %s\n\n", DIVar, DILoc);
 }
 
+void sapforReadArrRange(void *DILoc, void *Addr, void *DIVar, void *ArrBase,
+    uint64_t Stride, uint64_t Count) {
+  printf("called sapforReadArrRange\n");
+  printf("DIVar = %s\nDILoc = %s\nStride = %jd\nCount = %ju\n\n",
+    DIVar, DILoc, (int64_t)Stride, Count);
+}
+
+void sapforWriteArrRange(void *DILoc, void *Addr, void *DIVar, void *ArrBase,
+    uint64_t Stride, uint64_t Count) {
+  printf("called sapforWriteArrRange\n");
+  printf("DIVar = %s\nDILoc = %s\nStride = %jd\nCount = %ju\n\n",
+    DIVar, DILoc, (int64_t)Stride, Count);
+}
+
 //===--------------------- Registration of a function ---------------------===//
 void sapforFuncBegin(void *DIFunc) {
   printf("called sapforFuncBegin\n");
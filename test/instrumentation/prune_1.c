@@ -0,0 +1,21 @@
+int G[3];
+
+// Traits of 'G' are known in the loop in 'foo', however there is a 'may'
+// dependence in the loop in 'main' which calls 'foo'. So, accesses to 'G'
+// in 'foo' must be instrumented.
+int foo() {
+  int S = 0;
+  for (int I = 0; I < 3; ++I)
+    S += G[I];
+  return S;
+}
+
+int main() {
+  int S = 0;
+  for (int J = 0; J < 2; ++J) {
+    G[J] = J;
+    S += foo();
+  }
+  return S;
+}
+//CHECK: 6
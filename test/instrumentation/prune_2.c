@@ -0,0 +1,15 @@
+// Array 'A' is private in the loop in 'main' and it is not accessed outside
+// this function. So, accesses to 'A' are not instrumented, only 'A' itself
+// is registered.
+int main() {
+  int S = 0;
+  for (int I = 0; I < 10; ++I) {
+    int A[2];
+    A[0] = I;
+    A[1] = I + 1;
+    S += A[0] + A[1];
+  }
+  return S;
+}
+//CHECK: 1
+//CHECK: called sapforRegArr
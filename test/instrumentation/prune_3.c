@@ -0,0 +1,23 @@
+int T[1];
+int *Q;
+
+// 'bar' is not an entry point, so global 'T' may have unknown traits in loops
+// of callers and accesses to 'T' in 'bar' must be instrumented. Address
+// of 'A' is captured, so accesses to 'A' must be also instrumented.
+int bar() {
+  int S = 0;
+  int A[1];
+  Q = A;
+  for (int I = 0; I < 10; ++I) {
+    T[0] = I;
+    A[0] = T[0];
+    S += A[0];
+  }
+  return S;
+}
+
+int main() {
+  return bar();
+}
+//CHECK: 20
+//CHECK: 20
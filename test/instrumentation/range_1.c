@@ -0,0 +1,63 @@
+double A[100];
+int B[2][20];
+
+// The loop exits from the header, so the store is executed in each iteration
+// except the last one.
+void exit_from_header() {
+  for (int I = 0; I < 100; ++I)
+    A[I] = I;
+}
+
+// Accesses in the inner loop are registered once per each entry to the loop.
+void nested() {
+  for (int I = 0; I < 2; ++I)
+    for (int J = 0; J < 20; ++J)
+      B[I][J] = I + J;
+}
+
+// The loop exits from the latch, so the store is executed in each iteration.
+void exit_from_latch() {
+  int K = 0;
+  do {
+    A[K] = K;
+    ++K;
+  } while (K < 50);
+}
+
+// Loads from A are not affine, so accesses to A are registered one by one.
+// Accesses to B are affine and they are registered once.
+void not_affine() {
+  for (int I = 0; I < 3; ++I)
+    A[I] = A[2 * B[0][I]];
+}
+
+int main() {
+  exit_from_header();
+  nested();
+  exit_from_latch();
+  not_affine();
+  return 0;
+}
+//CHECK: called sapforRegArr
+//CHECK: called sapforRegArr
+//CHECK: called sapforWriteArrRange
+//CHECK: Stride = 8
+//CHECK: Count = 100
+//CHECK: called sapforWriteArrRange
+//CHECK: Stride = 4
+//CHECK: Count = 20
+//CHECK: called sapforWriteArrRange
+//CHECK: Stride = 4
+//CHECK: Count = 20
+//CHECK: called sapforWriteArrRange
+//CHECK: Stride = 8
+//CHECK: Count = 50
+//CHECK: called sapforReadArrRange
+//CHECK: Stride = 4
+//CHECK: Count = 3
+//CHECK: called sapforReadArr
+//CHECK: called sapforWriteArrEnd
+//CHECK: called sapforReadArr
+//CHECK: called sapforWriteArrEnd
+//CHECK: called sapforReadArr
+//CHECK: called sapforWriteArrEnd
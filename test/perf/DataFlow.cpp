@@ -0,0 +1,444 @@
+//===- DataFlow.cpp ------- Data-Flow Solver Benchmark ----------*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2018 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This benchmark compares different iterative data-flow solvers. A reach
+// definition problem is solved for synthetic control-flow graphs which
+// contain a large number of nodes and back edges. The problem is also solved
+// for a synthetic hierarchy of regions to compare the sequential and
+// the concurrent downward solvers.
+//
+//===----------------------------------------------------------------------===//
+
+#include <tsar/Core/tsar-config.h>
+#include <tsar/ADT/DataFlow.h>
+#include <llvm/ADT/BitVector.h>
+#include <llvm/Config/llvm-config.h>
+#include <llvm/Support/raw_ostream.h>
+#include <llvm/Support/ThreadPool.h>
+#include <llvm/Support/Threading.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+using namespace llvm;
+using namespace tsar;
+
+namespace {
+using TimeT = std::chrono::duration<double>;
+
+/// Node of a synthetic control-flow graph.
+struct CFGNode : public SmallDFNode<CFGNode, 4> {
+  /// Definitions which are generated in the node.
+  BitVector Gen;
+  /// Definitions which are killed in the node.
+  BitVector Kill;
+  /// Definitions which reach the node exit.
+  BitVector Out;
+};
+
+/// Synthetic control-flow graph, the first node is an entry node.
+struct SyntheticCFG {
+  std::vector<std::unique_ptr<CFGNode>> Storage;
+  std::vector<CFGNode *> Nodes;
+};
+
+/// Reach definition problem for a synthetic graph.
+struct ReachFwk {
+  unsigned NumDefs = 0;
+  std::size_t NumTransfers = 0;
+};
+
+struct SyntheticRegion;
+
+/// Node of a synthetic region, it may represent an inner region.
+struct RegionNode : public SmallDFNode<RegionNode, 4> {
+  /// Definitions which are generated in the node (in the whole inner region).
+  BitVector Gen;
+  /// Definitions which are killed in the node, it is empty for inner regions.
+  BitVector Kill;
+  /// Definitions which reach the node entry.
+  BitVector In;
+  /// Definitions which reach the node exit.
+  BitVector Out;
+  /// Inner region which is represented by this node.
+  SyntheticRegion *Inner = nullptr;
+};
+
+/// Synthetic region, the first node is an entry node.
+struct SyntheticRegion {
+  std::vector<std::unique_ptr<RegionNode>> Storage;
+  std::vector<RegionNode *> Nodes;
+  std::vector<std::unique_ptr<SyntheticRegion>> RegionStorage;
+  std::vector<SyntheticRegion *> Regions;
+  /// Node of an outer region which represents this region.
+  RegionNode *Parent = nullptr;
+};
+
+/// Reach definition problem for a synthetic hierarchy of regions.
+///
+/// Definitions which reach an entry of a region node are a boundary condition
+/// for the inner region, so outer regions must be solved first.
+struct RegionReachFwk {
+  unsigned NumDefs = 0;
+  std::atomic<std::size_t> NumTransfers{0};
+};
+}
+
+namespace llvm {
+template<> struct GraphTraits<Forward<SyntheticCFG *>> {
+  using NodeRef = CFGNode *;
+  using ChildIteratorType = CFGNode::pred_iterator;
+  static NodeRef getEntryNode(Forward<SyntheticCFG *> G) {
+    return G.Graph->Nodes.front();
+  }
+  static ChildIteratorType child_begin(NodeRef N) { return N->pred_begin(); }
+  static ChildIteratorType child_end(NodeRef N) { return N->pred_end(); }
+  using nodes_iterator = std::vector<CFGNode *>::const_iterator;
+  static nodes_iterator nodes_begin(Forward<SyntheticCFG *> G) {
+    return std::next(G.Graph->Nodes.cbegin());
+  }
+  static nodes_iterator nodes_end(Forward<SyntheticCFG *> G) {
+    return G.Graph->Nodes.cend();
+  }
+};
+
+template<> struct GraphTraits<Inverse<Forward<SyntheticCFG *>>> {
+  using NodeRef = CFGNode *;
+  using ChildIteratorType = CFGNode::succ_iterator;
+  static NodeRef getEntryNode(Inverse<Forward<SyntheticCFG *>> G) {
+    return G.Graph.Graph->Nodes.front();
+  }
+  static ChildIteratorType child_begin(NodeRef N) { return N->succ_begin(); }
+  static ChildIteratorType child_end(NodeRef N) { return N->succ_end(); }
+};
+
+template<> struct GraphTraits<SyntheticRegion *> {
+  using NodeRef = RegionNode *;
+  using ChildIteratorType = RegionNode::pred_iterator;
+  static NodeRef getEntryNode(SyntheticRegion *G) { return G->Nodes.front(); }
+  static ChildIteratorType child_begin(NodeRef N) { return N->pred_begin(); }
+  static ChildIteratorType child_end(NodeRef N) { return N->pred_end(); }
+  using nodes_iterator = std::vector<RegionNode *>::const_iterator;
+  static nodes_iterator nodes_begin(SyntheticRegion *G) {
+    return std::next(G->Nodes.cbegin());
+  }
+  static nodes_iterator nodes_end(SyntheticRegion *G) {
+    return G->Nodes.cend();
+  }
+};
+
+template<> struct GraphTraits<Inverse<SyntheticRegion *>> {
+  using NodeRef = RegionNode *;
+  using ChildIteratorType = RegionNode::succ_iterator;
+  static NodeRef getEntryNode(Inverse<SyntheticRegion *> G) {
+    return G.Graph->Nodes.front();
+  }
+  static ChildIteratorType child_begin(NodeRef N) { return N->succ_begin(); }
+  static ChildIteratorType child_end(NodeRef N) { return N->succ_end(); }
+};
+}
+
+namespace tsar {
+template<> struct DataFlowTraits<ReachFwk *> {
+  using GraphType = Forward<SyntheticCFG *>;
+  using ValueType = BitVector;
+  static ValueType topElement(ReachFwk *Fwk, GraphType) {
+    return BitVector(Fwk->NumDefs);
+  }
+  static ValueType boundaryCondition(ReachFwk *Fwk, GraphType) {
+    return BitVector(Fwk->NumDefs);
+  }
+  static void setValue(ValueType V, CFGNode *N, ReachFwk *) {
+    N->Out = std::move(V);
+  }
+  static const ValueType & getValue(CFGNode *N, ReachFwk *) { return N->Out; }
+  static void initialize(CFGNode *, ReachFwk *, GraphType) {}
+  static void meetOperator(const ValueType &LHS, ValueType &RHS, ReachFwk *,
+      GraphType) {
+    RHS |= LHS;
+  }
+  static bool transferFunction(ValueType V, CFGNode *N, ReachFwk *Fwk,
+      GraphType) {
+    ++Fwk->NumTransfers;
+    V.reset(N->Kill);
+    V |= N->Gen;
+    if (V == N->Out)
+      return false;
+    N->Out = std::move(V);
+    return true;
+  }
+};
+
+template<> struct DataFlowTraits<RegionReachFwk *> {
+  using GraphType = SyntheticRegion *;
+  using ValueType = BitVector;
+  static ValueType topElement(RegionReachFwk *Fwk, GraphType) {
+    return BitVector(Fwk->NumDefs);
+  }
+  static ValueType boundaryCondition(RegionReachFwk *Fwk, GraphType G) {
+    return G->Parent ? G->Parent->In : BitVector(Fwk->NumDefs);
+  }
+  static void setValue(ValueType V, RegionNode *N, RegionReachFwk *) {
+    N->Out = std::move(V);
+  }
+  static const ValueType & getValue(RegionNode *N, RegionReachFwk *) {
+    return N->Out;
+  }
+  static void initialize(RegionNode *, RegionReachFwk *, GraphType) {}
+  static void meetOperator(const ValueType &LHS, ValueType &RHS,
+      RegionReachFwk *, GraphType) {
+    RHS |= LHS;
+  }
+  static bool transferFunction(ValueType V, RegionNode *N,
+      RegionReachFwk *Fwk, GraphType) {
+    ++Fwk->NumTransfers;
+    N->In = V;
+    V.reset(N->Kill);
+    V |= N->Gen;
+    if (V == N->Out)
+      return false;
+    N->Out = std::move(V);
+    return true;
+  }
+};
+
+template<> struct RegionDFTraits<RegionReachFwk *> :
+    DataFlowTraits<RegionReachFwk *> {
+  static void expand(RegionReachFwk *, GraphType) {}
+  static void collapse(RegionReachFwk *, GraphType) {}
+  using region_iterator = std::vector<SyntheticRegion *>::const_iterator;
+  static region_iterator region_begin(GraphType G) {
+    return G->Regions.cbegin();
+  }
+  static region_iterator region_end(GraphType G) { return G->Regions.cend(); }
+};
+}
+
+/// Builds a graph which looks like a large loop nest: each node follows
+/// the previous one, there are some forward branches and back edges.
+static std::unique_ptr<SyntheticCFG> initializeCFG(std::size_t Size,
+    unsigned NumDefs) {
+  auto G = std::make_unique<SyntheticCFG>();
+  for (std::size_t I = 0; I < Size; ++I) {
+    G->Storage.push_back(std::make_unique<CFGNode>());
+    G->Nodes.push_back(G->Storage.back().get());
+    auto &N = *G->Nodes.back();
+    N.Gen.resize(NumDefs);
+    N.Kill.resize(NumDefs);
+    if (I == 0)
+      continue;
+    unsigned Def = std::rand() % NumDefs;
+    N.Gen.set(Def);
+    N.Kill.set(Def);
+    N.Kill.set(std::rand() % NumDefs);
+  }
+  auto addEdge = [&G](std::size_t From, std::size_t To) {
+    G->Nodes[From]->addSuccessor(G->Nodes[To]);
+    G->Nodes[To]->addPredecessor(G->Nodes[From]);
+  };
+  for (std::size_t I = 1; I < Size; ++I) {
+    addEdge(I - 1, I);
+    // Back edges are local to model loops with bodies of moderate size.
+    if (I > 1 && std::rand() % 8 == 0)
+      addEdge(I, I - 1 - std::rand() % std::min<std::size_t>(I - 1, 64));
+    if (I + 2 < Size && std::rand() % 8 == 0)
+      addEdge(I, I + 2 + std::rand() % std::min<std::size_t>(Size - I - 2, 64));
+  }
+  return G;
+}
+
+/// Builds a hierarchy of regions, each region looks like a graph built by
+/// initializeCFG() and some of its nodes are inner regions.
+static std::unique_ptr<SyntheticRegion> initializeRegion(std::size_t Size,
+    unsigned NumDefs, unsigned Depth) {
+  auto G = std::make_unique<SyntheticRegion>();
+  for (std::size_t I = 0; I < Size; ++I) {
+    G->Storage.push_back(std::make_unique<RegionNode>());
+    G->Nodes.push_back(G->Storage.back().get());
+    auto &N = *G->Nodes.back();
+    N.Gen.resize(NumDefs);
+    N.Kill.resize(NumDefs);
+    if (I == 0)
+      continue;
+    if (Depth > 0 && std::rand() % 4 == 0) {
+      G->RegionStorage.push_back(initializeRegion(Size, NumDefs, Depth - 1));
+      auto *Inner = G->RegionStorage.back().get();
+      G->Regions.push_back(Inner);
+      Inner->Parent = &N;
+      N.Inner = Inner;
+      for (auto *InnerN : Inner->Nodes)
+        N.Gen |= InnerN->Gen;
+      continue;
+    }
+    unsigned Def = std::rand() % NumDefs;
+    N.Gen.set(Def);
+    N.Kill.set(Def);
+    N.Kill.set(std::rand() % NumDefs);
+  }
+  auto addEdge = [&G](std::size_t From, std::size_t To) {
+    G->Nodes[From]->addSuccessor(G->Nodes[To]);
+    G->Nodes[To]->addPredecessor(G->Nodes[From]);
+  };
+  for (std::size_t I = 1; I < Size; ++I) {
+    addEdge(I - 1, I);
+    if (I > 1 && std::rand() % 8 == 0)
+      addEdge(I, I - 1 - std::rand() % std::min<std::size_t>(I - 1, 64));
+  }
+  return G;
+}
+
+static void collectResults(const SyntheticRegion &G,
+    std::vector<BitVector> &Results) {
+  for (auto &N : G.Nodes)
+    Results.push_back(N->Out);
+  for (auto *R : G.Regions)
+    collectResults(*R, Results);
+}
+
+static TimeT solveTime(DFSolverKind Solver, SyntheticCFG *G, ReachFwk &Fwk) {
+  auto Start = std::chrono::high_resolution_clock::now();
+  if (Solver == DFSolverKind::Worklist)
+    solveDataFlowWorklist(&Fwk, G);
+  else
+    solveDataFlowIteratively(&Fwk, G);
+  auto End = std::chrono::high_resolution_clock::now();
+  return End - Start;
+}
+
+static std::vector<BitVector> collectResults(const SyntheticCFG &G) {
+  std::vector<BitVector> Results;
+  for (auto &N : G.Nodes)
+    Results.push_back(N->Out);
+  return Results;
+}
+
+bool run(std::size_t Size, unsigned NumDefs, unsigned MaxIter = 5) {
+  TimeT RoundRobin(0), Worklist(0), Sequential(0), Concurrent(0);
+  std::size_t RoundRobinTransfers = 0, WorklistTransfers = 0;
+  bool IsEqual = true, IsRegionEqual = true;
+  ThreadPool Pool(hardware_concurrency());
+  for (unsigned I = 0; I < MaxIter; ++I) {
+    auto G = initializeCFG(Size, NumDefs);
+    auto *GPtr = G.get();
+    ReachFwk RRFwk;
+    RRFwk.NumDefs = NumDefs;
+    RoundRobin += solveTime(DFSolverKind::RoundRobin, GPtr, RRFwk);
+    RoundRobinTransfers += RRFwk.NumTransfers;
+    auto RRResults = collectResults(*G);
+    ReachFwk WLFwk;
+    WLFwk.NumDefs = NumDefs;
+    Worklist += solveTime(DFSolverKind::Worklist, GPtr, WLFwk);
+    WorklistTransfers += WLFwk.NumTransfers;
+    IsEqual &= RRResults == collectResults(*G);
+    // Regions contain less nodes to keep size of the hierarchy moderate.
+    auto R = initializeRegion(std::max<std::size_t>(Size / 64, 2), NumDefs, 3);
+    RegionReachFwk SeqFwk;
+    SeqFwk.NumDefs = NumDefs;
+    auto Start = std::chrono::high_resolution_clock::now();
+    solveDataFlowDownward(&SeqFwk, R.get());
+    Sequential += std::chrono::high_resolution_clock::now() - Start;
+    std::vector<BitVector> SeqResults;
+    collectResults(*R, SeqResults);
+    RegionReachFwk ConFwk;
+    ConFwk.NumDefs = NumDefs;
+    Start = std::chrono::high_resolution_clock::now();
+    solveDataFlowDownward(&ConFwk, R.get(), Pool);
+    Concurrent += std::chrono::high_resolution_clock::now() - Start;
+    std::vector<BitVector> ConResults;
+    collectResults(*R, ConResults);
+    IsRegionEqual &= SeqResults == ConResults;
+    IsRegionEqual &= SeqFwk.NumTransfers == ConFwk.NumTransfers;
+  }
+  outs() << "Results for " << __FILE__ << " benchmark\n";
+  outs() << "  date " << __DATE__ << "\n";
+  outs() << "  compiler ";
+#if defined __GNUC__
+  outs() << "GCC " << __GNUC__;
+#elif defined __clang__
+  outs() << "Clang " << __clang__;
+#elif defined _MSC_VER
+  outs() << "Microsoft " << _MSC_VER;
+#else
+  outs() << "unknown";
+#endif
+  outs() << "\n";
+  outs() << "  LLVM version " << LLVM_VERSION_STRING << "\n";
+  outs() << "  TSAR version " << TSAR_VERSION_STRING << "\n";
+  outs() << "  number of nodes " << Size << "\n";
+  outs() << "  number of definitions " << NumDefs << "\n";
+  outs() << "  number of iterations " << MaxIter << "\n";
+  outs() << "\n";
+  if (IsEqual)
+    outs() << "  solutions are equal\n";
+  else
+    outs() << "  solutions are NOT equal\n";
+  outs() << "\n";
+  outs() << "  round-robin solver time (.s) "
+         << (RoundRobin / MaxIter).count() << "\n";
+  outs() << "  round-robin solver transfer function evaluations "
+         << RoundRobinTransfers / MaxIter << "\n";
+  outs() << "  worklist solver time (.s) " << (Worklist / MaxIter).count()
+         << "\n";
+  outs() << "  worklist solver transfer function evaluations "
+         << WorklistTransfers / MaxIter << "\n";
+  outs() << "\n";
+  if (IsRegionEqual)
+    outs() << "  sequential and concurrent region solutions are equal\n";
+  else
+    outs() << "  sequential and concurrent region solutions are NOT equal\n";
+  outs() << "\n";
+  outs() << "  sequential downward solver time (.s) "
+         << (Sequential / MaxIter).count() << "\n";
+  outs() << "  concurrent downward solver time (.s) "
+         << (Concurrent / MaxIter).count() << "\n";
+  return IsEqual && IsRegionEqual;
+}
+
+int main(int Argc, const char **Argv) {
+  std::string Help =
+    "parameter: <number of nodes> [number of definitions] "
+    "[number of iterations]\n";
+  if (Argc < 2) {
+    errs() << "error: too few arguments\n" << Help;
+    return 1;
+  } else if (Argc > 4) {
+    errs() << "error: too many arguments\n" << Help;
+    return 2;
+  }
+  std::size_t Size = std::atoll(Argv[1]);
+  unsigned NumDefs = (Argc > 2) ? std::atoi(Argv[2]) : 256;
+  unsigned MaxIter = (Argc > 3) ? std::atoi(Argv[3]) : 5;
+  if (Size < 2) {
+    errs() << "error: invalid number of nodes\n" << Help;
+    return 3;
+  }
+  if (NumDefs == 0) {
+    errs() << "error: invalid number of definitions\n" << Help;
+    return 4;
+  }
+  if (MaxIter == 0) {
+    errs() << "error: invalid number of iterations\n" << Help;
+    return 5;
+  }
+  return run(Size, NumDefs, MaxIter) ? 0 : 6;
+}
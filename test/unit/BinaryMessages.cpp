@@ -0,0 +1,259 @@
+//===- BinaryMessages.cpp ---- Binary Messages Test -------------*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2020 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This test checks transcoding of JSON strings to binary messages which are
+// sent by the analysis server. Each message is unescaped and decoded to
+// a textual form which is compared with the expected one. Malformed JSON
+// strings must be rejected.
+//
+//===----------------------------------------------------------------------===//
+
+#include "BinaryMessages.h"
+#include "UnitTest.h"
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/LEB128.h>
+#include <llvm/Support/raw_ostream.h>
+#include <string>
+#include <vector>
+
+using namespace llvm;
+using namespace tsar;
+using namespace tsar::msg;
+using namespace tsar::unittest;
+
+namespace {
+/// Decoder of binary messages, it prints a decoded value in a JSON-like form.
+///
+/// Strings are printed as is, negative integers are printed with '-'.
+class BinaryDecoder {
+public:
+  explicit BinaryDecoder(StringRef Raw) : mRaw(Raw) {}
+
+  bool run(std::string &Out) {
+    if (!mRaw.startswith("\x7FTSB") || mRaw.size() < 5 ||
+        mRaw[4] != BinaryVersion)
+      return false;
+    mPos = 5;
+    uint64_t Size;
+    if (!uleb(Size) || Size != mRaw.size() - mPos)
+      return false;
+    uint64_t NumKeys;
+    if (!uleb(NumKeys))
+      return false;
+    for (uint64_t I = 0; I < NumKeys; ++I) {
+      StringRef Key;
+      if (!string(Key))
+        return false;
+      mKeys.push_back(Key);
+    }
+    raw_string_ostream OS(Out);
+    return value(OS) && mPos == mRaw.size();
+  }
+
+private:
+  bool uleb(uint64_t &Value) {
+    if (mPos >= mRaw.size())
+      return false;
+    const char *Error = nullptr;
+    unsigned Size;
+    auto *Start = reinterpret_cast<const uint8_t *>(mRaw.data()) + mPos;
+    Value = decodeULEB128(Start, &Size,
+      reinterpret_cast<const uint8_t *>(mRaw.data()) + mRaw.size(), &Error);
+    mPos += Size;
+    return !Error;
+  }
+
+  bool string(StringRef &Str) {
+    uint64_t Size;
+    if (!uleb(Size) || Size > mRaw.size() - mPos)
+      return false;
+    Str = mRaw.substr(mPos, Size);
+    mPos += Size;
+    return true;
+  }
+
+  bool value(raw_ostream &OS) {
+    if (mPos >= mRaw.size())
+      return false;
+    auto T = static_cast<BinaryTag>(mRaw[mPos++]);
+    uint64_t Value;
+    StringRef Str;
+    switch (T) {
+    case BinaryTag::Null: OS << "null"; return true;
+    case BinaryTag::False: OS << "false"; return true;
+    case BinaryTag::True: OS << "true"; return true;
+    case BinaryTag::UInt:
+      if (!uleb(Value))
+        return false;
+      OS << Value;
+      return true;
+    case BinaryTag::NegInt:
+      if (!uleb(Value))
+        return false;
+      OS << "-" << Value;
+      return true;
+    case BinaryTag::Number:
+      if (!string(Str))
+        return false;
+      OS << Str;
+      return true;
+    case BinaryTag::String:
+      if (!string(Str))
+        return false;
+      OS << "\"" << Str << "\"";
+      return true;
+    case BinaryTag::Array:
+      if (!uleb(Value))
+        return false;
+      OS << "[";
+      for (uint64_t I = 0; I < Value; ++I) {
+        if (I > 0)
+          OS << ",";
+        if (!value(OS))
+          return false;
+      }
+      OS << "]";
+      return true;
+    case BinaryTag::Object:
+      if (!uleb(Value))
+        return false;
+      OS << "{";
+      for (uint64_t I = 0; I < Value; ++I) {
+        if (I > 0)
+          OS << ",";
+        uint64_t KeyIdx;
+        if (!uleb(KeyIdx) || KeyIdx >= mKeys.size())
+          return false;
+        OS << mKeys[KeyIdx] << ":";
+        if (!value(OS))
+          return false;
+      }
+      OS << "}";
+      return true;
+    }
+    return false;
+  }
+
+  StringRef mRaw;
+  std::size_t mPos = 0;
+  std::vector<StringRef> mKeys;
+};
+
+/// Reverts escaping of bytes which can not be transmitted as is.
+bool unescape(StringRef Message, std::string &Raw) {
+  for (std::size_t I = 0, EI = Message.size(); I < EI; ++I) {
+    if (Message[I] == '\0' || Message[I] == '$')
+      return false;
+    if (Message[I] != BinaryEscape) {
+      Raw += Message[I];
+      continue;
+    }
+    if (++I == EI)
+      return false;
+    Raw += static_cast<char>(Message[I] ^ 0x40);
+  }
+  return true;
+}
+
+void checkRoundTrip(StringRef JSON, StringRef Expected) {
+  std::string Message;
+  if (!encodeBinary(JSON, Message)) {
+    fail("unable to encode '" + JSON + "'");
+    return;
+  }
+  std::string Raw, Decoded;
+  if (!unescape(Message, Raw) || !BinaryDecoder(Raw).run(Decoded)) {
+    fail("unable to decode '" + JSON + "'");
+    return;
+  }
+  check(Decoded == Expected, "'" + JSON + "' is decoded to '" +
+    Decoded + "' instead of '" + Expected + "'");
+}
+
+void checkMalformed(StringRef JSON) {
+  std::string Message;
+  check(!encodeBinary(JSON, Message),
+    "malformed '" + JSON + "' is encoded");
+}
+}
+
+int main() {
+  checkRoundTrip("null", "null");
+  checkRoundTrip(" [ true , false , null ] ", "[true,false,null]");
+  checkRoundTrip("{}", "{}");
+  checkRoundTrip("[]", "[]");
+  checkRoundTrip("{\"a\":{\"b\":[]},\"b\":{\"a\":1}}", "{a:{b:[]},b:{a:1}}");
+  // Integers.
+  checkRoundTrip("[0,1,-0,-1,127,128]", "[0,1,-0,-1,127,128]");
+  checkRoundTrip("18446744073709551615", "18446744073709551615");
+  checkRoundTrip("-9223372036854775808", "-9223372036854775808");
+  checkRoundTrip("-18446744073709551615", "-18446744073709551615");
+  // Integers which do not fit into 64 bits and other numbers are text.
+  checkRoundTrip("18446744073709551616", "18446744073709551616");
+  checkRoundTrip("[1.5,-2e10,3E+2,0.0e-1]", "[1.5,-2e10,3E+2,0.0e-1]");
+  // Escape sequences and Unicode.
+  checkRoundTrip("\"\\\"\\\\\\/\\b\\f\\n\\r\\t\"", "\"\"\\/\b\f\n\r\t\"");
+  checkRoundTrip("\"\\u0041\\u00e9\\u20AC\"", "\"A\xC3\xA9\xE2\x82\xAC\"");
+  checkRoundTrip("\"\\ud83d\\ude00\"", "\"\xF0\x9F\x98\x80\"");
+  checkRoundTrip("\"\xC3\xA9\"", "\"\xC3\xA9\"");
+  // Bytes which are escaped in the underlying connection.
+  checkRoundTrip("\"$\\u0000\\u001b$\"", std::string("\"$\0\x1B$\"", 6));
+  checkRoundTrip("{\"$\":\"$$\"}", "{$:\"$$\"}");
+  // Size of the message is 36 ('$' == 36), so it is escaped in the header.
+  checkRoundTrip("\"012345678901234567890123456789012\"",
+                 "\"012345678901234567890123456789012\"");
+  // Malformed strings.
+  checkMalformed("");
+  checkMalformed("   ");
+  checkMalformed("{");
+  checkMalformed("}");
+  checkMalformed("[1,]");
+  checkMalformed("[1 2]");
+  checkMalformed("{\"a\":1,}");
+  checkMalformed("{\"a\" 1}");
+  checkMalformed("{a:1}");
+  checkMalformed("\"abc");
+  checkMalformed("tru");
+  checkMalformed("nul");
+  checkMalformed("1 2");
+  checkMalformed("-");
+  checkMalformed("01");
+  checkMalformed("1.");
+  checkMalformed(".5");
+  checkMalformed("1e");
+  checkMalformed("1e+");
+  checkMalformed("--1");
+  checkMalformed("+1");
+  checkMalformed("\"\\x\"");
+  checkMalformed("\"\\u12\"");
+  checkMalformed("\"\\u12G4\"");
+  checkMalformed("\"\\ud83d\"");
+  checkMalformed("\"\\ud83d\\u0041\"");
+  checkMalformed("\"\\ude00\"");
+  // Encoding is negotiated by name for each connection.
+  auto E = Encoding::JSON;
+  check(parseEncoding("binary", E) && E == Encoding::Binary,
+    "'binary' encoding is not recognized");
+  check(parseEncoding("json", E) && E == Encoding::JSON,
+    "'json' encoding is not recognized");
+  check(!parseEncoding("xml", E) && E == Encoding::JSON,
+    "unknown encoding is accepted");
+  return finish();
+}
@@ -0,0 +1,137 @@
+//===- FunctionFingerprint.cpp --- Function Fingerprint Test ----*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2020 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This test checks that a fingerprint of a function changes if the function
+// is modified in place and does not change otherwise. Incremental analysis
+// (for example, GlobalDefinedMemory) relies on this property to reuse results
+// for unchanged functions.
+//
+//===----------------------------------------------------------------------===//
+
+#include "UnitTest.h"
+#include <tsar/Support/IRUtils.h>
+#include <llvm/AsmParser/Parser.h>
+#include <llvm/IR/InstIterator.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/SourceMgr.h>
+#include <llvm/Support/raw_ostream.h>
+
+using namespace llvm;
+using namespace tsar;
+using namespace tsar::unittest;
+
+namespace {
+template<class InstTy> InstTy & getFirst(Function &F) {
+  for (auto &I : instructions(F))
+    if (auto *Inst = dyn_cast<InstTy>(&I))
+      return *Inst;
+  llvm_unreachable("Instruction must exist!");
+}
+}
+
+int main() {
+  LLVMContext Ctx;
+  SMDiagnostic Err;
+  auto M = parseAssemblyString(
+    "define i32 @f1(i32* %p, i32 %n) {\n"
+    "entry:\n"
+    "  %x = load i32, i32* %p, align 4\n"
+    "  %s = add nsw i32 %x, %n\n"
+    "  %c = icmp slt i32 %s, %n\n"
+    "  br i1 %c, label %then, label %exit\n"
+    "then:\n"
+    "  store i32 %s, i32* %p, align 4\n"
+    "  br label %exit\n"
+    "exit:\n"
+    "  %r = phi i32 [ %s, %then ], [ %n, %entry ]\n"
+    "  ret i32 %r\n"
+    "}\n"
+    "define i32 @f2(i32* %p, i32 %n) {\n"
+    "entry:\n"
+    "  %x = load i32, i32* %p, align 4\n"
+    "  %s = add nsw i32 %x, %n\n"
+    "  %c = icmp slt i32 %s, %n\n"
+    "  br i1 %c, label %then, label %exit\n"
+    "then:\n"
+    "  store i32 %s, i32* %p, align 4\n"
+    "  br label %exit\n"
+    "exit:\n"
+    "  %r = phi i32 [ %s, %then ], [ %n, %entry ]\n"
+    "  ret i32 %r\n"
+    "}\n",
+    Err, Ctx);
+  if (!M) {
+    Err.print("tsar-function-fingerprint-test", errs());
+    return 1;
+  }
+  auto &F1 = *M->getFunction("f1");
+  auto &F2 = *M->getFunction("f2");
+  FunctionFingerprint Initial(F1);
+  check(Initial == FunctionFingerprint(F1),
+    "fingerprint of an unchanged function differs");
+  check(Initial != FunctionFingerprint(),
+    "fingerprint equals an empty fingerprint");
+  check(Initial != FunctionFingerprint(F2),
+    "fingerprints of different functions with the same body are equal");
+  getFirst<StoreInst>(F2).setAlignment(Align(8));
+  check(Initial == FunctionFingerprint(F1),
+    "fingerprint depends on other functions");
+  auto &Cmp = getFirst<ICmpInst>(F1);
+  Cmp.setPredicate(CmpInst::ICMP_SGT);
+  check(Initial != FunctionFingerprint(F1),
+    "fingerprint does not depend on a predicate");
+  Cmp.setPredicate(CmpInst::ICMP_SLT);
+  check(Initial == FunctionFingerprint(F1),
+    "fingerprint of a restored function differs");
+  auto &Add = getFirst<BinaryOperator>(F1);
+  Add.setHasNoSignedWrap(false);
+  check(Initial != FunctionFingerprint(F1),
+    "fingerprint does not depend on flags");
+  Add.setHasNoSignedWrap(true);
+  auto &Load = getFirst<LoadInst>(F1);
+  Load.setAlignment(Align(8));
+  check(Initial != FunctionFingerprint(F1),
+    "fingerprint does not depend on alignment");
+  Load.setAlignment(Align(4));
+  Cmp.swapOperands();
+  check(Initial != FunctionFingerprint(F1),
+    "fingerprint does not depend on order of operands");
+  Cmp.swapOperands();
+  auto &Phi = getFirst<PHINode>(F1);
+  auto *ThenBB = Phi.getIncomingBlock(0);
+  Phi.setIncomingBlock(0, Phi.getIncomingBlock(1));
+  Phi.setIncomingBlock(1, ThenBB);
+  check(Initial != FunctionFingerprint(F1),
+    "fingerprint does not depend on incoming blocks");
+  Phi.setIncomingBlock(1, Phi.getIncomingBlock(0));
+  Phi.setIncomingBlock(0, ThenBB);
+  check(Initial == FunctionFingerprint(F1),
+    "fingerprint of a restored function differs");
+  // Replace an instruction with the same one.
+  auto *NewAdd = Add.clone();
+  NewAdd->insertBefore(&Add);
+  Add.replaceAllUsesWith(NewAdd);
+  Add.eraseFromParent();
+  check(Initial != FunctionFingerprint(F1),
+    "fingerprint does not depend on identity of instructions");
+  return finish();
+}
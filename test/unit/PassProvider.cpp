@@ -0,0 +1,154 @@
+//===- PassProvider.cpp -- On The Fly Passes Cache Test ---------*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2020 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This test checks that OnTheFlyPassCache never returns results which have
+// been computed for another function. Two different passes are requested
+// for two functions in turn. Passes are required by different module passes,
+// so each request executes a single pass only.
+//
+//===----------------------------------------------------------------------===//
+
+#include "UnitTest.h"
+#include <tsar/Support/PassProvider.h>
+#include <llvm/AsmParser/Parser.h>
+#include <llvm/IR/LegacyPassManager.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/SourceMgr.h>
+#include <llvm/Support/raw_ostream.h>
+#include <string>
+
+using namespace llvm;
+using namespace tsar;
+using namespace tsar::unittest;
+
+namespace {
+/// This pass remembers a name of the last processed function.
+template<unsigned Kind>
+struct FunctionNamePass : public FunctionPass {
+  static char ID;
+  FunctionNamePass() : FunctionPass(ID) {}
+
+  bool runOnFunction(Function &F) override {
+    Name = F.getName().str();
+    ++NumRuns;
+    return false;
+  }
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.setPreservesAll();
+  }
+
+  std::string Name;
+  unsigned NumRuns = 0;
+};
+
+template<unsigned Kind> char FunctionNamePass<Kind>::ID = 0;
+
+using FirstPass = FunctionNamePass<0>;
+using SecondPass = FunctionNamePass<1>;
+
+RegisterPass<FirstPass> FirstRegistration("test-first-name",
+  "Function Name (First)", true, true);
+RegisterPass<SecondPass> SecondRegistration("test-second-name",
+  "Function Name (Second)", true, true);
+
+/// This pass only requires a pass which is executed on the fly.
+struct SecondPassRequester : public ModulePass {
+  static char ID;
+  SecondPassRequester() : ModulePass(ID) {}
+
+  bool runOnModule(Module &M) override { return false; }
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.addRequired<SecondPass>();
+    AU.setPreservesAll();
+  }
+};
+
+char SecondPassRequester::ID = 0;
+
+/// This pass requests results of function passes through a cache.
+struct CacheCheckPass : public ModulePass {
+  static char ID;
+  explicit CacheCheckPass(SecondPassRequester &Requester) :
+    ModulePass(ID), mRequester(&Requester) {}
+
+  bool runOnModule(Module &M) override {
+    OnTheFlyPassCache Cache;
+    auto &F1 = *M.getFunction("f1");
+    auto &F2 = *M.getFunction("f2");
+    auto &R = *mRequester;
+    check(Cache.getAnalysis<FirstPass>(*this, F1).Name, "f1");
+    check(Cache.getAnalysis<SecondPass>(R, F1).Name, "f1");
+    check(Cache.getAnalysis<FirstPass>(*this, F2).Name, "f2");
+    check(Cache.getAnalysis<SecondPass>(R, F2).Name, "f2");
+    // Results for the same function must not be recomputed.
+    auto NumRuns = Cache.getAnalysis<FirstPass>(*this, F2).NumRuns;
+    check(Cache.getAnalysis<SecondPass>(R, F2).Name, "f2");
+    unittest::check(
+      Cache.getAnalysis<FirstPass>(*this, F2).NumRuns == NumRuns,
+      "results for the same function are recomputed");
+    check(Cache.getAnalysis<SecondPass>(R, F1).Name, "f1");
+    check(Cache.getAnalysis<FirstPass>(*this, F1).Name, "f1");
+    Cache.invalidate();
+    check(Cache.getAnalysis<SecondPass>(R, F2).Name, "f2");
+    return false;
+  }
+
+  void getAnalysisUsage(AnalysisUsage &AU) const override {
+    AU.addRequired<FirstPass>();
+    AU.setPreservesAll();
+  }
+
+  void check(StringRef Name, StringRef Expected) {
+    unittest::check(Name == Expected, "results for '" + Name +
+      "' are returned instead of '" + Expected + "'");
+  }
+
+private:
+  SecondPassRequester *mRequester;
+};
+
+char CacheCheckPass::ID = 0;
+}
+
+int main() {
+  LLVMContext Ctx;
+  SMDiagnostic Err;
+  auto M = parseAssemblyString("define void @f1() {\n"
+                               "  ret void\n"
+                               "}\n"
+                               "define void @f2() {\n"
+                               "  ret void\n"
+                               "}\n",
+                               Err, Ctx);
+  if (!M) {
+    Err.print("tsar-pass-provider-test", errs());
+    return 1;
+  }
+  auto *Requester = new SecondPassRequester;
+  auto *P = new CacheCheckPass(*Requester);
+  legacy::PassManager Passes;
+  Passes.add(Requester);
+  Passes.add(P);
+  Passes.run(*M);
+  return finish();
+}
@@ -0,0 +1,214 @@
+//===- ResponseCache.cpp ---- Response Cache Test ---------------*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2020 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This test checks the on-disk cache of responses which is used by the
+// analysis server. A fingerprint of a function must be stable between
+// sessions, it must change if the function, its callers or callees are
+// modified and it must not change if unrelated functions are modified.
+// The cache directory must be pruned according to a specified policy.
+//
+//===----------------------------------------------------------------------===//
+
+#include "ResponseCache.h"
+#include "UnitTest.h"
+#include "tsar/Support/GlobalOptions.h"
+#include <llvm/AsmParser/Parser.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/Error.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/SourceMgr.h>
+#include <llvm/Support/raw_ostream.h>
+#include <chrono>
+
+using namespace llvm;
+using namespace tsar;
+using namespace tsar::unittest;
+
+namespace {
+/// Builds a module where 'main' calls 'caller' and 'other', 'caller' calls
+/// 'f' and 'f' calls 'callee'. Substrings of the module may be replaced
+/// with a specified one.
+std::unique_ptr<Module> parse(LLVMContext &Ctx, StringRef From = "",
+    StringRef To = "") {
+  std::string IR =
+    "@g = global i32 0\n"
+    "define i32 @callee(i32 %x) {\n"
+    "  %r = add nsw i32 %x, 1\n"
+    "  ret i32 %r\n"
+    "}\n"
+    "define void @f(i32* %p) {\n"
+    "entry:\n"
+    "  %x = load i32, i32* %p, align 4, !custom !0\n"
+    "  %0 = call i32 @callee(i32 %x)\n"
+    "  store i32 %0, i32* @g, align 4\n"
+    "  ret void\n"
+    "}\n"
+    "define void @caller() {\n"
+    "  %p = alloca i32, align 4\n"
+    "  call void @f(i32* %p)\n"
+    "  ret void\n"
+    "}\n"
+    "define i32 @other(i32 %n) {\n"
+    "  %r = mul i32 %n, 2\n"
+    "  ret i32 %r\n"
+    "}\n"
+    "define i32 @unrelated(i32 %n) {\n"
+    "  %r = sub i32 %n, 2\n"
+    "  ret i32 %r\n"
+    "}\n"
+    "define i32 @main() {\n"
+    "  call void @caller()\n"
+    "  %r = call i32 @other(i32 1)\n"
+    "  ret i32 %r\n"
+    "}\n"
+    "!0 = !{}\n";
+  if (!From.empty()) {
+    auto Pos = IR.find(From.str());
+    assert(Pos != std::string::npos && "Substring must exist!");
+    IR.replace(Pos, From.size(), To.str());
+  }
+  SMDiagnostic Err;
+  auto M = parseAssemblyString(IR, Err, Ctx);
+  if (!M)
+    Err.print("ResponseCache", errs());
+  return M;
+}
+
+/// Returns a fingerprint of a function with a specified name.
+std::string getFingerprint(Module &M, StringRef Name) {
+  IRFingerprint FP(M);
+  return FP.get(*M.getFunction(Name));
+}
+
+/// Sets access time of a cached response for a specified key.
+void setTime(StringRef Dir, StringRef Key,
+    std::chrono::system_clock::time_point Time) {
+  SmallString<128> Path(Dir);
+  sys::path::append(Path, "llvmcache-" + Key);
+  int FD;
+  if (sys::fs::openFileForRead(Path, FD)) {
+    fail("unable to open a cached response");
+    return;
+  }
+  sys::fs::setLastAccessAndModificationTime(FD,
+    std::chrono::time_point_cast<std::chrono::nanoseconds>(Time));
+  sys::fs::closeFile(FD);
+}
+}
+
+int main() {
+  LLVMContext Ctx;
+  auto M = parse(Ctx);
+  if (!M)
+    return 1;
+  auto F = getFingerprint(*M, "f");
+  check(F == getFingerprint(*M, "f"), "fingerprint is not stable");
+  // Metadata are numbered across a module, their numbers must be ignored.
+  auto Numbering = parse(Ctx, "!0 = !{}\n",
+    "!named = !{!1}\n!0 = !{}\n!1 = !{!\"shift\"}\n");
+  if (!Numbering)
+    return 1;
+  check(F == getFingerprint(*Numbering, "f"),
+    "fingerprint depends on numbering of metadata");
+  auto Unrelated = parse(Ctx, "%r = sub i32 %n, 2", "%r = sub i32 %n, 3");
+  if (!Unrelated)
+    return 1;
+  check(F == getFingerprint(*Unrelated, "f"),
+    "fingerprint depends on an unrelated function");
+  check(getFingerprint(*M, "unrelated") !=
+    getFingerprint(*Unrelated, "unrelated"),
+    "fingerprint does not depend on the function itself");
+  auto Body = parse(Ctx, "align 4, !custom", "align 2, !custom");
+  auto Callee = parse(Ctx, "add nsw i32 %x, 1", "add nsw i32 %x, 2");
+  auto Caller = parse(Ctx, "%p = alloca i32, align 4",
+    "%p = alloca i32, align 8");
+  auto CallerCallee = parse(Ctx, "mul i32 %n, 2", "mul i32 %n, 3");
+  auto Global = parse(Ctx, "@g = global i32 0", "@g = global i32 1");
+  auto Attachment = parse(Ctx, "!0 = !{}\n", "!0 = !{!\"tag\"}\n");
+  if (!Body || !Callee || !Caller || !CallerCallee || !Global || !Attachment)
+    return 1;
+  check(F != getFingerprint(*Body, "f"),
+    "fingerprint does not depend on the function itself");
+  check(F != getFingerprint(*Callee, "f"),
+    "fingerprint does not depend on a callee");
+  check(F != getFingerprint(*Caller, "f"),
+    "fingerprint does not depend on a caller");
+  check(F != getFingerprint(*CallerCallee, "f"),
+    "fingerprint does not depend on a callee of a caller");
+  check(F != getFingerprint(*Global, "f"),
+    "fingerprint does not depend on global variables");
+  check(F != getFingerprint(*Attachment, "f"),
+    "fingerprint does not depend on metadata attached to instructions");
+  check(IRFingerprint(*M).get() != IRFingerprint(*Unrelated).get(),
+    "fingerprint of a module does not depend on all functions");
+  // Check insertion and pruning of responses.
+  SmallString<128> Dir;
+  if (sys::fs::createUniqueDirectory("tsar-response-cache", Dir)) {
+    errs() << "error: unable to create a cache directory\n";
+    return 1;
+  }
+  ResponseCache Disabled("");
+  check(!Disabled.isEnabled() && !Disabled.find("a"),
+    "cache without a directory is enabled");
+  ResponseCache Cache(Dir);
+  auto KeyA = ResponseCache::KeyBuilder().add("a").add("bc").getKey();
+  auto KeyB = ResponseCache::KeyBuilder().add("ab").add("c").getKey();
+  check(KeyA != KeyB, "pieces of a key are not separated");
+  // Content of a file with external analysis results is a part of the key.
+  GlobalOptions GO;
+  SmallString<128> Use(Dir);
+  sys::path::append(Use, "use.json");
+  GO.AnalysisUse = std::string(Use);
+  auto getUseKey = [&GO, &Use](StringRef Content) {
+    std::error_code EC;
+    raw_fd_ostream OS(Use, EC);
+    OS << Content;
+    OS.close();
+    return ResponseCache::KeyBuilder().add(GO).getKey();
+  };
+  auto UseKey = getUseKey("a");
+  check(UseKey == getUseKey("a"), "key of the same options is not stable");
+  check(UseKey != getUseKey("b"),
+    "key does not depend on external analysis results");
+  sys::fs::remove(Use);
+  check(!Cache.find(KeyA), "response is found in an empty cache");
+  Cache.insert(KeyA, "response a");
+  Cache.insert(KeyB, "response b");
+  auto A = Cache.find(KeyA);
+  check(A && *A == "response a", "unable to find a cached response");
+  auto Old = std::chrono::system_clock::now() - std::chrono::hours(1);
+  setTime(Dir, KeyA, Old);
+  setTime(Dir, KeyB, Old);
+  // Access time of a found response is updated, so the other one is evicted.
+  Cache.find(KeyA);
+  auto Policy =
+    parseCachePruningPolicy("prune_interval=0s:cache_size_bytes=15");
+  if (!Policy) {
+    errs() << "error: " << toString(Policy.takeError()) << "\n";
+    return 1;
+  }
+  Cache.prune(*Policy);
+  check(Cache.find(KeyA).hasValue(), "recently used response is evicted");
+  check(!Cache.find(KeyB), "least recently used response is not evicted");
+  sys::fs::remove_directories(Dir);
+  return finish();
+}
@@ -0,0 +1,62 @@
+//===--- UnitTest.h ------- Unit Test Helpers -------------------*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2020 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file contains helpers which are shared between unit tests. A test
+// reports each failed check with fail() or check() and returns the result
+// of finish() from main().
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef TSAR_UNIT_TEST_H
+#define TSAR_UNIT_TEST_H
+
+#include <llvm/ADT/Twine.h>
+#include <llvm/Support/raw_ostream.h>
+
+namespace tsar {
+namespace unittest {
+/// Returns `true` if some of checks have failed.
+inline bool &isFailed() {
+  static bool IsFailed = false;
+  return IsFailed;
+}
+
+/// Prints a specified message and marks the test as failed.
+inline void fail(const llvm::Twine &Message) {
+  llvm::errs() << "error: " << Message << "\n";
+  isFailed() = true;
+}
+
+/// Marks the test as failed if a specified condition does not hold.
+inline void check(bool Condition, const llvm::Twine &Message) {
+  if (!Condition)
+    fail(Message);
+}
+
+/// Returns exit code of the test, prints 'passed' if all checks hold.
+inline int finish() {
+  if (isFailed())
+    return 1;
+  llvm::outs() << "passed\n";
+  return 0;
+}
+}
+}
+#endif//TSAR_UNIT_TEST_H
@@ -0,0 +1,309 @@
+//===- BinaryMessages.cpp --- Binary Messages -------------------*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2020 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This implements a compact binary encoding of server responses.
+//
+//===----------------------------------------------------------------------===//
+
+#include "BinaryMessages.h"
+#include <llvm/ADT/StringMap.h>
+#include <llvm/Support/ConvertUTF.h>
+#include <llvm/Support/LEB128.h>
+#include <vector>
+
+using namespace llvm;
+using namespace tsar;
+using namespace tsar::msg;
+
+namespace {
+/// Appends ULEB128 representation of a specified value to a string.
+void appendULEB128(uint64_t Value, std::string &Out) {
+  uint8_t Buf[16];
+  auto Size = encodeULEB128(Value, Buf);
+  Out.append(reinterpret_cast<const char *>(Buf), Size);
+}
+
+/// Single-pass transcoder of JSON strings to binary messages.
+class BinaryTranscoder {
+  /// Number of elements in an array or an object, which should be inserted
+  /// at a specified offset of encoded value.
+  struct Counter {
+    std::size_t Offset;
+    uint64_t Count;
+  };
+
+public:
+  explicit BinaryTranscoder(StringRef JSON) : mJSON(JSON) {}
+
+  bool run(std::string &Out) {
+    mBody.reserve(mJSON.size() / 2);
+    if (!value())
+      return false;
+    skipSpaces();
+    if (mPos != mJSON.size())
+      return false;
+    std::string Raw;
+    appendULEB128(mKeys.size(), Raw);
+    for (auto &K : mKeys) {
+      appendULEB128(K.size(), Raw);
+      Raw += K;
+    }
+    // Insert number of elements into containers.
+    std::size_t Pos = 0;
+    for (auto &C : mCounters) {
+      Raw.append(mBody, Pos, C.Offset - Pos);
+      appendULEB128(C.Count, Raw);
+      Pos = C.Offset;
+    }
+    Raw.append(mBody, Pos, std::string::npos);
+    std::string Header("\x7FTSB");
+    Header += static_cast<char>(BinaryVersion);
+    appendULEB128(Raw.size(), Header);
+    Out.clear();
+    Out.reserve(Header.size() + Raw.size() + Raw.size() / 64);
+    escape(Header, Out);
+    escape(Raw, Out);
+    return true;
+  }
+
+private:
+  static void escape(StringRef Raw, std::string &Out) {
+    for (char C : Raw)
+      if (C == '\0' || C == '$' || C == BinaryEscape) {
+        Out += BinaryEscape;
+        Out += static_cast<char>(C ^ 0x40);
+      } else {
+        Out += C;
+      }
+  }
+
+  void skipSpaces() {
+    while (mPos < mJSON.size() && isSpace(mJSON[mPos]))
+      ++mPos;
+  }
+
+  static bool isSpace(char C) {
+    return C == ' ' || C == '\t' || C == '\n' || C == '\r';
+  }
+
+  bool consume(char C) {
+    skipSpaces();
+    if (mPos == mJSON.size() || mJSON[mPos] != C)
+      return false;
+    ++mPos;
+    return true;
+  }
+
+  void tag(BinaryTag T) { mBody += static_cast<char>(T); }
+
+  /// Allocates counter of elements for a container which starts here.
+  unsigned startContainer(BinaryTag T) {
+    tag(T);
+    mCounters.push_back({ mBody.size(), 0 });
+    return mCounters.size() - 1;
+  }
+
+  bool value() {
+    skipSpaces();
+    if (mPos == mJSON.size())
+      return false;
+    switch (mJSON[mPos]) {
+    case '{': return object();
+    case '[': return array();
+    case '"':
+      tag(BinaryTag::String);
+      if (!string(mStr))
+        return false;
+      appendULEB128(mStr.size(), mBody);
+      mBody += mStr;
+      return true;
+    case 'n': return literal("null", BinaryTag::Null);
+    case 't': return literal("true", BinaryTag::True);
+    case 'f': return literal("false", BinaryTag::False);
+    default: return number();
+    }
+  }
+
+  bool literal(StringRef L, BinaryTag T) {
+    if (!mJSON.substr(mPos).startswith(L))
+      return false;
+    mPos += L.size();
+    tag(T);
+    return true;
+  }
+
+  /// Parses a number: -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+  bool number() {
+    auto Start = mPos;
+    bool IsNeg = mJSON[mPos] == '-';
+    if (IsNeg)
+      ++mPos;
+    if (mPos == mJSON.size() || !isDigit(mJSON[mPos]))
+      return false;
+    if (mJSON[mPos] == '0')
+      ++mPos;
+    else
+      digits();
+    bool IsInteger = true;
+    if (mPos < mJSON.size() && mJSON[mPos] == '.') {
+      ++mPos;
+      if (!digits())
+        return false;
+      IsInteger = false;
+    }
+    if (mPos < mJSON.size() && (mJSON[mPos] == 'e' || mJSON[mPos] == 'E')) {
+      ++mPos;
+      if (mPos < mJSON.size() && (mJSON[mPos] == '+' || mJSON[mPos] == '-'))
+        ++mPos;
+      if (!digits())
+        return false;
+      IsInteger = false;
+    }
+    auto Text = mJSON.slice(Start, mPos);
+    // Integers which do not fit into 64 bits are stored as text.
+    uint64_t Value;
+    if (IsInteger && !Text.drop_front(IsNeg ? 1 : 0).getAsInteger(10, Value)) {
+      tag(IsNeg ? BinaryTag::NegInt : BinaryTag::UInt);
+      appendULEB128(Value, mBody);
+      return true;
+    }
+    tag(BinaryTag::Number);
+    appendULEB128(Text.size(), mBody);
+    mBody += Text;
+    return true;
+  }
+
+  static bool isDigit(char C) { return C >= '0' && C <= '9'; }
+
+  /// Skips a non-empty sequence of digits, returns false if it is empty.
+  bool digits() {
+    auto Start = mPos;
+    while (mPos < mJSON.size() && isDigit(mJSON[mPos]))
+      ++mPos;
+    return mPos != Start;
+  }
+
+  bool array() {
+    ++mPos;
+    auto Idx = startContainer(BinaryTag::Array);
+    if (consume(']'))
+      return true;
+    do {
+      if (!value())
+        return false;
+      ++mCounters[Idx].Count;
+    } while (consume(','));
+    return consume(']');
+  }
+
+  bool object() {
+    ++mPos;
+    auto Idx = startContainer(BinaryTag::Object);
+    if (consume('}'))
+      return true;
+    do {
+      skipSpaces();
+      if (!string(mStr))
+        return false;
+      auto KeyItr = mKeyIds.try_emplace(mStr, mKeys.size()).first;
+      if (KeyItr->second == mKeys.size())
+        mKeys.push_back(mStr);
+      appendULEB128(KeyItr->second, mBody);
+      if (!consume(':') || !value())
+        return false;
+      ++mCounters[Idx].Count;
+    } while (consume(','));
+    return consume('}');
+  }
+
+  /// Unescapes a JSON string which starts at the current position.
+  bool string(std::string &Str) {
+    if (mPos == mJSON.size() || mJSON[mPos] != '"')
+      return false;
+    ++mPos;
+    Str.clear();
+    while (mPos < mJSON.size()) {
+      auto C = mJSON[mPos++];
+      if (C == '"')
+        return true;
+      if (C != '\\') {
+        Str += C;
+        continue;
+      }
+      if (mPos == mJSON.size())
+        return false;
+      switch (mJSON[mPos++]) {
+      case '"': Str += '"'; break;
+      case '\\': Str += '\\'; break;
+      case '/': Str += '/'; break;
+      case 'b': Str += '\b'; break;
+      case 'f': Str += '\f'; break;
+      case 'n': Str += '\n'; break;
+      case 'r': Str += '\r'; break;
+      case 't': Str += '\t'; break;
+      case 'u': if (!unicode(Str)) return false; break;
+      default: return false;
+      }
+    }
+    return false;
+  }
+
+  /// Converts \uXXXX sequence (possibly a surrogate pair) to UTF-8.
+  bool unicode(std::string &Str) {
+    auto hex = [this](unsigned &Code) {
+      if (mJSON.size() - mPos < 4 ||
+          mJSON.substr(mPos, 4).getAsInteger(16, Code))
+        return false;
+      mPos += 4;
+      return true;
+    };
+    unsigned Code;
+    if (!hex(Code))
+      return false;
+    if (Code >= 0xD800 && Code <= 0xDBFF) {
+      unsigned Low;
+      if (!mJSON.substr(mPos).startswith("\\u"))
+        return false;
+      mPos += 2;
+      if (!hex(Low) || Low < 0xDC00 || Low > 0xDFFF)
+        return false;
+      Code = 0x10000 + ((Code - 0xD800) << 10) + (Low - 0xDC00);
+    }
+    char Buf[UNI_MAX_UTF8_BYTES_PER_CODE_POINT];
+    char *Ptr = Buf;
+    if (!ConvertCodePointToUTF8(Code, Ptr))
+      return false;
+    Str.append(Buf, Ptr);
+    return true;
+  }
+
+  StringRef mJSON;
+  std::size_t mPos = 0;
+  std::string mBody;
+  std::string mStr;
+  std::vector<Counter> mCounters;
+  std::vector<std::string> mKeys;
+  StringMap<unsigned> mKeyIds;
+};
+}
+
+bool tsar::msg::encodeBinary(StringRef JSON, std::string &Out) {
+  return BinaryTranscoder(JSON).run(Out);
+}
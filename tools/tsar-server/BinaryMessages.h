@@ -0,0 +1,113 @@
+//===- BinaryMessages.h ----- Binary Messages -------------------*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2020 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This defines a compact binary encoding of server responses. A client selects
+// encoding for its connection with 'Encoding' field of msg::CommandLine message
+// ("json" or "binary"). JSON encoding is used by default. Requests and
+// responses to msg::CommandLine are always JSON strings, the selected encoding
+// is used for responses to analysis requests only.
+//
+// A binary message has the following layout:
+// - header: "\x7FTSB" followed by a version byte,
+// - ULEB128 size of the rest of the message (unescaped),
+// - table of keys: ULEB128 number of keys, then each key as ULEB128 length
+//   followed by its characters (keys are names of fields from JSON_OBJECT
+//   definitions, so each name is stored once per message),
+// - encoded root value.
+//
+// Each value starts with a tag (see BinaryTag). Unsigned and negative
+// integers which fit into 64 bits are stored as ULEB128 absolute values,
+// other numbers are stored as text. Strings are stored without JSON escapes
+// with a length prefix. Arrays and objects are prefixed with ULEB128 number
+// of elements, an object element is a ULEB128 index of a key followed by
+// a value.
+//
+// Messages are delimited with '$' in the underlying connection, so bytes
+// 0x00, '$' and 0x1B are transmitted as 0x1B followed by the byte XOR 0x40.
+// A client has to unescape a whole message before decoding it.
+//
+// Responses are built as JSON strings and transcoded to binary messages,
+// so binary encoding reduces the size of transmitted data but not the time
+// to build a response.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef TSAR_BINARY_MESSAGES_H
+#define TSAR_BINARY_MESSAGES_H
+
+#include <llvm/ADT/StringRef.h>
+#include <cstdint>
+#include <string>
+
+namespace tsar {
+namespace msg {
+/// Encoding of responses which is negotiated at connection time.
+enum class Encoding : uint8_t { JSON, Binary };
+
+/// Tags of values in a binary message.
+enum class BinaryTag : uint8_t {
+  Null = 1,
+  False,
+  True,
+  UInt,
+  NegInt,
+  Number,
+  String,
+  Array,
+  Object
+};
+
+/// Version of binary encoding.
+constexpr uint8_t BinaryVersion = 1;
+
+/// Escape byte which precedes bytes that can not be transmitted as is.
+constexpr char BinaryEscape = 0x1B;
+
+/// \brief Transcodes a specified JSON string to a binary message.
+///
+/// \return False if JSON string is malformed, `Out` is unspecified in this
+/// case.
+bool encodeBinary(llvm::StringRef JSON, std::string &Out);
+
+/// Finds encoding with a specified name, returns false if a name is unknown.
+inline bool parseEncoding(llvm::StringRef Name, Encoding &E) {
+  if (Name == "json")
+    E = Encoding::JSON;
+  else if (Name == "binary")
+    E = Encoding::Binary;
+  else
+    return false;
+  return true;
+}
+
+/// \brief Encodes a response in a specified encoding.
+///
+/// JSON is used as a fallback if a response can not be encoded.
+inline std::string encode(std::string JSON, Encoding E) {
+  if (E == Encoding::JSON)
+    return JSON;
+  std::string Out;
+  if (!encodeBinary(JSON, Out))
+    return JSON;
+  return Out;
+}
+}
+}
+#endif//TSAR_BINARY_MESSAGES_H
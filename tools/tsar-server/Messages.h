@@ -23,7 +23,8 @@
 // a new message.
 //
 // Each message is a JSON string which is parsed and unparsed with JSON String
-// Serializer from bcl/Json.h file.
+// Serializer from bcl/Json.h file. Responses may be transcoded to a compact
+// binary form (see BinaryMessages.h) if a client requests it.
 //
 //===----------------------------------------------------------------------===//
 
@@ -26,18 +26,28 @@
 #ifndef TSAR_SERVER_PASSES_H
 #define TSAR_SERVER_PASSES_H
 
+#include <cstdint>
+
 namespace bcl {
 class IntrusiveConnection;
 class RedirectIO;
 }
 
+namespace tsar {
+namespace msg {
+enum class Encoding : uint8_t;
+}
+}
+
 namespace llvm {
 class ModulePass;
 class PassRegistry;
 
 /// Create an interaction pass to obtain results of private variables analysis.
-ModulePass * createPrivateServerPass(
-  bcl::IntrusiveConnection &IC, bcl::RedirectIO &StdErr);
+///
+/// Responses to analysis requests are sent in a specified encoding.
+ModulePass * createPrivateServerPass(bcl::IntrusiveConnection &IC,
+  bcl::RedirectIO &StdErr, tsar::msg::Encoding E);
 
 /// Initialize an interaction pass to obtain results of private variables
 /// analysis.
@@ -23,8 +23,10 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "BinaryMessages.h"
 #include "ClangMessages.h"
 #include "Passes.h"
+#include "ResponseCache.h"
 #include "tsar/ADT/SpanningTreeRelation.h"
 #include "tsar/Analysis/AnalysisServer.h"
 #include "tsar/Analysis/Attributes.h"
@@ -63,11 +65,15 @@
 #include <clang/AST/RecursiveASTVisitor.h>
 #include <clang/Basic/Builtins.h>
 #include <clang/Basic/FileManager.h>
+#include <clang/Lex/Lexer.h>
 #include <llvm/ADT/Optional.h>
+#include <llvm/ADT/Statistic.h>
 #include <llvm/Analysis/BasicAliasAnalysis.h>
 #include <llvm/InitializePasses.h>
 #include <llvm/IR/InstIterator.h>
 #include <llvm/Pass.h>
+#include <llvm/Support/CommandLine.h>
+#include <llvm/Support/Error.h>
 #include <llvm/Support/Path.h>
 
 using namespace llvm;
@@ -77,6 +83,17 @@ using ::llvm::Module;
 #undef DEBUG_TYPE
 #define DEBUG_TYPE "server-private"
 
+static cl::opt<std::string> ClServerCacheDir("server-cache-dir",
+  cl::desc("Directory to cache responses to client requests between sessions"),
+  cl::value_desc("path"));
+
+static cl::opt<std::string> ClServerCachePolicy("server-cache-policy",
+  cl::desc("Pruning policy for the cache of responses "
+           "(for example, 'prune_after=24h:cache_size_bytes=64m')"),
+  cl::value_desc("policy"), cl::init("cache_size_bytes=256m"));
+
+STATISTIC(NumCachedResponses, "Number of responses loaded from the cache");
+
 namespace tsar {
 namespace msg {
 /// This message provides list of all analyzed files (including implicitly
@@ -172,12 +189,23 @@ JSON_OBJECT_PAIR_7(Loop,
   Loop & operator=(Loop &&) = default;
 JSON_OBJECT_END(Loop)
 
+/// \brief This message provides a list of loops in a function.
+///
+/// A request may restrict loops which should be sent: loops with a level
+/// less or equal to Depth (0 means no limits) and a range of Count loops
+/// (0 means all loops) starting at First. Loops are ordered by their
+/// start locations. A response contains the number of loops which satisfy
+/// the Depth restriction in Total, so a client can request the next page.
 JSON_OBJECT_BEGIN(LoopTree)
-JSON_OBJECT_ROOT_PAIR_2(LoopTree,
+JSON_OBJECT_ROOT_PAIR_6(LoopTree,
   FunctionID, unsigned,
+  Depth, unsigned,
+  First, unsigned,
+  Count, unsigned,
+  Total, unsigned,
   Loops, std::vector<Loop>)
 
-  LoopTree() : JSON_INIT_ROOT {}
+  LoopTree() : JSON_INIT_ROOT, JSON_INIT(LoopTree, 0, 0, 0, 0, 0) {}
   ~LoopTree() override = default;
 
   LoopTree(const LoopTree &) = default;
@@ -346,14 +374,32 @@ JSON_OBJECT_PAIR_3(AliasEdge,
   AliasEdge & operator=(AliasEdge &&) = default;
 JSON_OBJECT_END(AliasEdge)
 
+/// \brief This message provides an alias tree for a loop.
+///
+/// A request may restrict a part of the tree which should be sent: a subtree
+/// of a node with ID Root (0 means the whole tree), nodes at most Depth levels
+/// below the root (0 means no limits) and a range of Count nodes (0 means all
+/// nodes) starting at First in breadth-first order. Edges to children which
+/// have not been sent are kept, so a client may expand them later with
+/// a subsequent request. A response contains the number of nodes which satisfy
+/// Root and Depth restrictions in Total.
+///
+/// Identifiers of nodes are their positions in the alias tree starting at 1,
+/// so they remain the same between sessions if the analyzed sources are not
+/// changed.
 JSON_OBJECT_BEGIN(AliasTree)
-JSON_OBJECT_ROOT_PAIR_4(AliasTree,
+JSON_OBJECT_ROOT_PAIR_9(AliasTree,
   FuncID, unsigned,
   LoopID, unsigned,
+  Root, std::uintptr_t,
+  Depth, unsigned,
+  First, unsigned,
+  Count, unsigned,
+  Total, unsigned,
   Nodes, std::vector<AliasNode>,
   Edges, std::vector<AliasEdge>)
 
-  AliasTree() : JSON_INIT_ROOT, JSON_INIT(AliasTree, 0) {}
+  AliasTree() : JSON_INIT_ROOT, JSON_INIT(AliasTree, 0, 0, 0, 0, 0, 0, 0) {}
   ~AliasTree() override = default;
 
   AliasTree(const AliasTree &) = default;
@@ -877,8 +923,8 @@ public:
 
   /// Constructor.
   explicit PrivateServerPass(bcl::IntrusiveConnection &IC,
-      bcl::RedirectIO &StdErr) :
-    ModulePass(ID), mConnection(&IC), mStdErr(&StdErr) {
+      bcl::RedirectIO &StdErr, msg::Encoding E) :
+    ModulePass(ID), mConnection(&IC), mStdErr(&StdErr), mEncoding(E) {
     initializePrivateServerPassPass(*PassRegistry::getPassRegistry());
   }
 
@@ -889,6 +935,9 @@ public:
   void getAnalysisUsage(AnalysisUsage &AU) const override;
 
 private:
+  /// Returns JSON response to a specified request.
+  std::string answer(llvm::Module &M, const std::string &Request);
+
   std::string answerStatistic(llvm::Module &M);
   std::string answerFileList();
   std::string answerFunctionList(llvm::Module &M);
@@ -897,6 +946,18 @@ private:
     const msg::CalleeFuncList &Request);
   std::string answerAliasTree(llvm::Module &M, const msg::AliasTree &Request);
 
+  /// Returns a key to cache a response to a specified request which relates
+  /// to a function `F` defined at `D`.
+  ///
+  /// Responses must not contain identifiers which are not stable between
+  /// sessions (for example, addresses of objects).
+  std::string getCacheKey(llvm::StringRef Request, llvm::Function &F,
+    const clang::Decl &D);
+
+  /// Returns a fingerprint of names and contents of all files in the
+  /// translation unit. The main file is ignored if `WithMainFile` is false.
+  std::string getSourcesKey(bool WithMainFile) const;
+
   /// Recursively collect builtin functions in a specified contexs and
   /// inner contexts.
   void collectBuiltinFunctions(clang::DeclContext &DeclCtx,
@@ -904,12 +965,21 @@ private:
 
   bcl::IntrusiveConnection *mConnection;
   bcl::RedirectIO *mStdErr;
+  msg::Encoding mEncoding = msg::Encoding::JSON;
 
   TransformationInfo *mTfmInfo = nullptr;
   TransformationContext *mTfmCtx  = nullptr;
   const GlobalOptions *mGlobalOpts = nullptr;
   AnalysisSocket *mSocket = nullptr;
   GlobalsAAResult * mGlobalsAA = nullptr;
+  ResponseCache mCache{""};
+  Optional<IRFingerprint> mFingerprint;
+  std::string mHeadersKey;
+  std::string mSourcesKey;
+
+  /// Requests from a client often relate to the same function, so passes
+  /// are not executed again in this case.
+  OnTheFlyPassCache mProviders;
 
   /// List of canonical function declarations which is visible to user in GUI.
   /// GUI knowns this function and it can highlight some information if
@@ -1009,7 +1079,70 @@ INITIALIZE_PASS_DEPENDENCY(CanonicalLoopPass)
 INITIALIZE_PASS_END(PrivateServerPass, "server-private",
   "Server Private Pass", true, true)
 
+std::string PrivateServerPass::getCacheKey(StringRef Request, Function &F,
+    const clang::Decl &D) {
+  auto &SrcMgr = mTfmCtx->getContext().getSourceManager();
+  auto &LangOpts = mTfmCtx->getContext().getLangOpts();
+  // Some locations in a response are obtained from AST (for example,
+  // locations of loops which are not presented in IR), so add sources of
+  // the function and its position in a file to the key.
+  auto Src = clang::Lexer::getSourceText(
+    clang::CharSourceRange::getTokenRange(D.getSourceRange()), SrcMgr,
+    LangOpts);
+  auto PLoc = SrcMgr.getPresumedLoc(SrcMgr.getFileLoc(D.getBeginLoc()));
+  std::string Position;
+  raw_string_ostream OS(Position);
+  if (PLoc.isValid())
+    OS << PLoc.getFilename() << ':' << PLoc.getLine() << ':'
+       << PLoc.getColumn();
+  // Results of analysis of a function depend on its callers and callees,
+  // so the fingerprint covers IR of these functions. Included files may
+  // define macros and types the function uses, so they are also added.
+  ResponseCache::KeyBuilder KB;
+  return KB.add(Request)
+    .add(mFingerprint->get(F))
+    .add(*mGlobalOpts)
+    .add(F.getName())
+    .add(OS.str())
+    .add(Src)
+    .add(mHeadersKey)
+    .getKey();
+}
+
+std::string PrivateServerPass::getSourcesKey(bool WithMainFile) const {
+  auto &SrcMgr = mTfmCtx->getContext().getSourceManager();
+  auto *MainFile = SrcMgr.getFileEntryForID(SrcMgr.getMainFileID());
+  // Files are sorted by name because the order of files in a source manager
+  // depends on addresses of file entries.
+  std::vector<std::pair<StringRef, const clang::FileEntry *>> Files;
+  for (auto &Info : make_range(SrcMgr.fileinfo_begin(), SrcMgr.fileinfo_end()))
+    if (WithMainFile || Info.first != MainFile)
+      Files.emplace_back(Info.first->getName(), Info.first);
+  llvm::sort(Files, less_first());
+  ResponseCache::KeyBuilder KB;
+  for (auto &File : Files) {
+    KB.add(File.first);
+    if (auto *Buffer = const_cast<clang::SourceManager &>(SrcMgr)
+          .getMemoryBufferForFile(File.second))
+      KB.add(Buffer->getBuffer());
+  }
+  return KB.getKey();
+}
+
 std::string PrivateServerPass::answerStatistic(llvm::Module &M) {
+  std::string Key;
+  if (mCache.isEnabled()) {
+    ResponseCache::KeyBuilder KB;
+    Key = KB.add("Statistic")
+      .add(mFingerprint->get())
+      .add(*mGlobalOpts)
+      .add(mSourcesKey)
+      .getKey();
+    if (auto Response = mCache.find(Key)) {
+      ++NumCachedResponses;
+      return std::move(*Response);
+    }
+  }
   msg::Statistic Stat;
   auto &Rewriter = mTfmCtx->getRewriter();
   for (auto FI = Rewriter.getSourceMgr().fileinfo_begin(),
@@ -1050,7 +1183,7 @@ std::string PrivateServerPass::answerStatistic(llvm::Module &M) {
     // Analysis are not available for functions without body.
     if (F.isDeclaration())
       continue;
-    auto &Provider = getAnalysis<ServerPrivateProvider>(F);
+    auto &Provider = mProviders.getAnalysis<ServerPrivateProvider>(*this, F);
     auto &LMP = Provider.get<LoopMatcherPass>();
     Loops.first += LMP.getMatcher().size();
     Loops.second += LMP.getUnmatchedAST().size();
@@ -1063,7 +1196,10 @@ std::string PrivateServerPass::answerStatistic(llvm::Module &M) {
     std::make_pair(msg::Analysis::Yes, Loops.first));
   Stat[msg::Statistic::Loops].insert(
     std::make_pair(msg::Analysis::No, Loops.second));
-  return json::Parser<msg::Statistic>::unparseAsObject(Stat);
+  auto Response = json::Parser<msg::Statistic>::unparseAsObject(Stat);
+  if (!Key.empty())
+    mCache.insert(Key, Response);
+  return Response;
 }
 
 std::string PrivateServerPass::answerLoopTree(llvm::Module &M,
@@ -1079,10 +1215,19 @@ std::string PrivateServerPass::answerLoopTree(llvm::Module &M,
       continue;
     if (F.isDeclaration())
       return json::Parser<msg::LoopTree>::unparseAsObject(Request);
+    std::string Key;
+    if (mCache.isEnabled()) {
+      Key = getCacheKey(json::Parser<msg::LoopTree>::unparseAsObject(Request),
+                        F, *Decl);
+      if (auto Response = mCache.find(Key)) {
+        ++NumCachedResponses;
+        return std::move(*Response);
+      }
+    }
     msg::LoopTree LoopTree;
     LoopTree[msg::LoopTree::FunctionID] = Request[msg::LoopTree::FunctionID];
     auto &SrcMgr = mTfmCtx->getContext().getSourceManager();
-    auto &Provider = getAnalysis<ServerPrivateProvider>(F);
+    auto &Provider = mProviders.getAnalysis<ServerPrivateProvider>(*this, F);
     auto &Matcher = Provider.get<LoopMatcherPass>().getMatcher();
     auto &Unmatcher = Provider.get<LoopMatcherPass>().getUnmatchedAST();
     auto &RegionInfo = Provider.get<DFRegionInfoPass>().getRegionInfo();
@@ -1175,7 +1320,27 @@ std::string PrivateServerPass::answerLoopTree(llvm::Module &M,
       Loop[msg::Loop::Level] = Levels.size() + 1;
       Levels.push_back(Loop[msg::Loop::EndLocation]);
     }
-    return json::Parser<msg::LoopTree>::unparseAsObject(LoopTree);
+    auto &Loops = LoopTree[msg::LoopTree::Loops];
+    if (auto Depth = Request[msg::LoopTree::Depth])
+      Loops.erase(std::remove_if(Loops.begin(), Loops.end(),
+        [Depth](msg::Loop &L) { return L[msg::Loop::Level] > Depth; }),
+        Loops.end());
+    LoopTree[msg::LoopTree::Total] = Loops.size();
+    auto First = std::min<std::size_t>(Request[msg::LoopTree::First],
+                                       Loops.size());
+    auto Last = Request[msg::LoopTree::Count]
+      ? std::min<std::size_t>(First + Request[msg::LoopTree::Count],
+                              Loops.size())
+      : Loops.size();
+    Loops.erase(Loops.begin() + Last, Loops.end());
+    Loops.erase(Loops.begin(), Loops.begin() + First);
+    LoopTree[msg::LoopTree::Depth] = Request[msg::LoopTree::Depth];
+    LoopTree[msg::LoopTree::First] = First;
+    LoopTree[msg::LoopTree::Count] = Request[msg::LoopTree::Count];
+    auto Response = json::Parser<msg::LoopTree>::unparseAsObject(LoopTree);
+    if (!Key.empty())
+      mCache.insert(Key, Response);
+    return Response;
   }
   return json::Parser<msg::LoopTree>::unparseAsObject(Request);
 }
@@ -1269,7 +1434,7 @@ std::string PrivateServerPass::answerFunctionList(llvm::Module &M) {
       Func[msg::Function::Traits][msg::FunctionTraits::InOut]
         = msg::Analysis::No;
     if (!F.isDeclaration()) {
-      auto &Provider = getAnalysis<ServerPrivateProvider>(F);
+      auto &Provider = mProviders.getAnalysis<ServerPrivateProvider>(*this, F);
       auto &LMP = Provider.get<LoopMatcherPass>();
       auto &AA = Provider.get<AAResultsWrapperPass>().getAAResults();
       auto &PI = Provider.get<ParallelLoopPass>().getParallelLoopInfo();
@@ -1309,7 +1474,7 @@ std::string PrivateServerPass::answerCalleeFuncList(llvm::Module &M,
       return json::Parser<msg::CalleeFuncList>::unparseAsObject(Request);
     msg::CalleeFuncList StmtList = Request;
     auto &SrcMgr = mTfmCtx->getContext().getSourceManager();
-    auto &Provider = getAnalysis<ServerPrivateProvider>(F);
+    auto &Provider = mProviders.getAnalysis<ServerPrivateProvider>(*this, F);
     auto &Matcher = Provider.get<LoopMatcherPass>().getMatcher();
     auto &Unmatcher = Provider.get<LoopMatcherPass>().getUnmatchedAST();
     auto &FuncInfo = Provider.get<ClangCFTraitsPass>().getFuncInfo();
@@ -1400,8 +1565,17 @@ std::string PrivateServerPass::answerAliasTree(llvm::Module &M,
       continue;
     if (F.isDeclaration())
       return json::Parser<msg::AliasTree>::unparseAsObject(Request);
+    std::string Key;
+    if (mCache.isEnabled()) {
+      Key = getCacheKey(json::Parser<msg::AliasTree>::unparseAsObject(Request),
+                        F, *Decl);
+      if (auto Response = mCache.find(Key)) {
+        ++NumCachedResponses;
+        return std::move(*Response);
+      }
+    }
     auto &SrcMgr = mTfmCtx->getContext().getSourceManager();
-    auto &Provider = getAnalysis<ServerPrivateProvider>(F);
+    auto &Provider = mProviders.getAnalysis<ServerPrivateProvider>(*this, F);
     auto &LoopMatcher = Provider.get<LoopMatcherPass>().getMatcher();
     auto &MemoryMatcher = Provider.get<ClangDIMemoryMatcherPass>().getMatcher();
     if (Request[msg::AliasTree::LoopID]) {
@@ -1439,13 +1613,24 @@ std::string PrivateServerPass::answerAliasTree(llvm::Module &M,
       DenseSet<const DIAliasNode *> Coverage;
       accessCoverage<bcl::SimpleInserter>(DIDepSet, DIAT, Coverage,
                                           mGlobalOpts->IgnoreRedundantMemory);
+      // Identifiers of nodes are their positions in the alias tree. Analysis
+      // builds the same tree for the same IR, so identifiers are stable
+      // between sessions and a client may refer to nodes from cached
+      // responses. Note, that 0 means no node in a request.
+      DenseMap<const DIAliasNode *, std::uintptr_t> NodeIDs;
+      for (auto &N : DIAT)
+        NodeIDs.try_emplace(&N, NodeIDs.size() + 1);
       msg::AliasTree Response;
       Response[msg::AliasTree::FuncID] = Request[msg::AliasTree::FuncID];
       Response[msg::AliasTree::LoopID] = Request[msg::AliasTree::LoopID];
-      for (auto &TS : DIDepSet) {
+      Response[msg::AliasTree::Root] = Request[msg::AliasTree::Root];
+      Response[msg::AliasTree::Depth] = Request[msg::AliasTree::Depth];
+      Response[msg::AliasTree::First] = Request[msg::AliasTree::First];
+      Response[msg::AliasTree::Count] = Request[msg::AliasTree::Count];
+      auto addNode = [&](const DIAliasTrait &TS) {
         Response[msg::AliasTree::Nodes].emplace_back();
         auto &N = Response[msg::AliasTree::Nodes].back();
-        N[msg::AliasNode::ID] = reinterpret_cast<std::uintptr_t>(TS.getNode());
+        N[msg::AliasNode::ID] = NodeIDs.lookup(TS.getNode());
         N[msg::AliasNode::Kind] = TS.getNode()->getKind();
         N[msg::AliasNode::Traits] = TS;
         for (auto &T : TS) {
@@ -1540,10 +1725,55 @@ std::string PrivateServerPass::answerAliasTree(llvm::Module &M,
           if (DIDepSet.find_as(&C) == DIDepSet.end())
             continue;
           Response[msg::AliasTree::Edges].emplace_back(N[msg::AliasNode::ID],
-            reinterpret_cast<std::uintptr_t>(&C), N[msg::AliasNode::Kind]);
+            NodeIDs.lookup(&C), N[msg::AliasNode::Kind]);
         }
+      };
+      if (!Request[msg::AliasTree::Root] && !Request[msg::AliasTree::Depth] &&
+          !Request[msg::AliasTree::First] && !Request[msg::AliasTree::Count]) {
+        for (auto &TS : DIDepSet)
+          addNode(TS);
+        Response[msg::AliasTree::Total] = DIDepSet.size();
+        auto Result = json::Parser<msg::AliasTree>::unparseAsObject(Response);
+        if (!Key.empty())
+          mCache.insert(Key, Result);
+        return Result;
+      }
+      const DIAliasNode *Root = DIAT.getTopLevelNode();
+      if (Request[msg::AliasTree::Root]) {
+        auto Itr = find_if(DIAT, [&Request, &NodeIDs](const DIAliasNode &N) {
+          return NodeIDs.lookup(&N) == Request[msg::AliasTree::Root];
+        });
+        if (Itr == DIAT.end())
+          return json::Parser<msg::AliasTree>::unparseAsObject(Request);
+        Root = &*Itr;
       }
-      return json::Parser<msg::AliasTree>::unparseAsObject(Response);
+      // Visit nodes in breadth-first order, so the top of the tree is sent
+      // at first. Only nodes in the requested range are converted to messages.
+      auto First = Request[msg::AliasTree::First];
+      auto Count = Request[msg::AliasTree::Count];
+      unsigned Total = 0;
+      std::vector<std::pair<const DIAliasNode *, unsigned>> Worklist;
+      Worklist.emplace_back(Root, 0);
+      for (std::size_t I = 0; I < Worklist.size(); ++I) {
+        auto *Curr = Worklist[I].first;
+        auto Level = Worklist[I].second;
+        auto TSItr = DIDepSet.find_as(Curr);
+        if (TSItr != DIDepSet.end()) {
+          if (Total >= First && (!Count || Total - First < Count))
+            addNode(*TSItr);
+          ++Total;
+        }
+        if (Request[msg::AliasTree::Depth] &&
+            Level == Request[msg::AliasTree::Depth])
+          continue;
+        for (auto &C : make_range(Curr->child_begin(), Curr->child_end()))
+          Worklist.emplace_back(&C, Level + 1);
+      }
+      Response[msg::AliasTree::Total] = Total;
+      auto Result = json::Parser<msg::AliasTree>::unparseAsObject(Response);
+      if (!Key.empty())
+        mCache.insert(Key, Result);
+      return Result;
     }
   }
   return json::Parser<msg::AliasTree>::unparseAsObject(Request);
@@ -1562,11 +1792,26 @@ bool PrivateServerPass::runOnModule(llvm::Module &M) {
   assert(mSocket && "Active socket must be specified!");
   mGlobalsAA = &getAnalysis<GlobalsAAWrapperPass>().getResult();
   mGlobalOpts = &getAnalysis<GlobalOptionsImmutableWrapper>().getOptions();
+  mCache = ResponseCache(ClServerCacheDir);
   if (!mTfmCtx || !mTfmCtx->hasInstance()) {
     M.getContext().emitError("can not access sources"
         ": transformation context is not available");
     return false;
   }
+  if (mCache.isEnabled()) {
+    auto Policy = parseCachePruningPolicy(ClServerCachePolicy);
+    if (!Policy) {
+      M.getContext().emitError("invalid cache pruning policy: " +
+        toString(Policy.takeError()));
+      return false;
+    }
+    mCache.prune(*Policy);
+    // Neither IR nor sources are changed while the server is running, so
+    // fingerprints are computed once.
+    mFingerprint.emplace(M);
+    mHeadersKey = getSourcesKey(false);
+    mSourcesKey = getSourcesKey(true);
+  }
   ServerPrivateProvider::initialize<TransformationEnginePass>(
     [this](TransformationEnginePass &TEP) {
       TEP.set(*mTfmInfo);
@@ -1600,32 +1845,37 @@ bool PrivateServerPass::runOnModule(llvm::Module &M) {
   });
   while (mConnection->answer(
       [this, &M](const std::string &Request) -> std::string {
-    msg::Diagnostic Diag(msg::Status::Error);
-    if (mStdErr->isDiff()) {
-      Diag[msg::Diagnostic::Terminal] += mStdErr->diff();
-      return json::Parser<msg::Diagnostic>::unparseAsObject(Diag);
-    }
-    json::Parser<msg::Statistic, msg::FileList, msg::LoopTree,
-      msg::FunctionList, msg::CalleeFuncList, msg::AliasTree> P(Request);
-    auto Obj = P.parse();
-    assert(Obj && "Invalid request!");
-    if (Obj->is<msg::Statistic>())
-      return answerStatistic(M);
-    if (Obj->is<msg::FileList>())
-      return answerFileList();
-    if (Obj->is<msg::LoopTree>())
-      return answerLoopTree(M, Obj->as<msg::LoopTree>());
-    if (Obj->is<msg::FunctionList>())
-      return answerFunctionList(M);
-    if (Obj->is<msg::CalleeFuncList>())
-      return answerCalleeFuncList(M, Obj->as<msg::CalleeFuncList>());
-    if (Obj->is<msg::AliasTree>())
-      return answerAliasTree(M, Obj->as<msg::AliasTree>());
-    llvm_unreachable("Unknown request to server!");
+    return msg::encode(answer(M, Request), mEncoding);
   }));
   return false;
 }
 
+std::string PrivateServerPass::answer(llvm::Module &M,
+    const std::string &Request) {
+  msg::Diagnostic Diag(msg::Status::Error);
+  if (mStdErr->isDiff()) {
+    Diag[msg::Diagnostic::Terminal] += mStdErr->diff();
+    return json::Parser<msg::Diagnostic>::unparseAsObject(Diag);
+  }
+  json::Parser<msg::Statistic, msg::FileList, msg::LoopTree,
+    msg::FunctionList, msg::CalleeFuncList, msg::AliasTree> P(Request);
+  auto Obj = P.parse();
+  assert(Obj && "Invalid request!");
+  if (Obj->is<msg::Statistic>())
+    return answerStatistic(M);
+  if (Obj->is<msg::FileList>())
+    return answerFileList();
+  if (Obj->is<msg::LoopTree>())
+    return answerLoopTree(M, Obj->as<msg::LoopTree>());
+  if (Obj->is<msg::FunctionList>())
+    return answerFunctionList(M);
+  if (Obj->is<msg::CalleeFuncList>())
+    return answerCalleeFuncList(M, Obj->as<msg::CalleeFuncList>());
+  if (Obj->is<msg::AliasTree>())
+    return answerAliasTree(M, Obj->as<msg::AliasTree>());
+  llvm_unreachable("Unknown request to server!");
+}
+
 void PrivateServerPass::getAnalysisUsage(AnalysisUsage &AU) const {
   AU.addRequired<AnalysisSocketImmutableWrapper>();
   AU.addRequired<ServerPrivateProvider>();
@@ -1638,6 +1888,6 @@ void PrivateServerPass::getAnalysisUsage(AnalysisUsage &AU) const {
 }
 
 ModulePass * llvm::createPrivateServerPass(
-    bcl::IntrusiveConnection &IC, bcl::RedirectIO &StdErr) {
-  return new PrivateServerPass(IC, StdErr);
+    bcl::IntrusiveConnection &IC, bcl::RedirectIO &StdErr, msg::Encoding E) {
+  return new PrivateServerPass(IC, StdErr, E);
 }
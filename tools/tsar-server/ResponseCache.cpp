@@ -0,0 +1,373 @@
+//===- ResponseCache.cpp -- On-Disk Cache of Responses ----------*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2020 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This implements an on-disk cache of responses to client requests.
+//
+//===----------------------------------------------------------------------===//
+
+#include "ResponseCache.h"
+#include "tsar/Core/tsar-config.h"
+#include "tsar/Support/GlobalOptions.h"
+#include <llvm/ADT/SmallPtrSet.h>
+#include <llvm/ADT/SmallString.h>
+#include <llvm/Config/llvm-config.h>
+#include <llvm/IR/DebugInfoMetadata.h>
+#include <llvm/IR/InstIterator.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IR/ModuleSlotTracker.h>
+#include <llvm/Support/FileSystem.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/Path.h>
+#include <llvm/Support/raw_ostream.h>
+
+using namespace llvm;
+using namespace tsar;
+
+namespace {
+/// Prints attributes of a function or a call which has NumArgs arguments.
+void printAttributes(const AttributeList &AL, unsigned NumArgs,
+    raw_ostream &OS) {
+  OS << AL.getAsString(AttributeList::FunctionIndex) << '\0'
+     << AL.getAsString(AttributeList::ReturnIndex);
+  for (unsigned I = 0; I < NumArgs; ++I)
+    OS << '\0' << AL.getAsString(AttributeList::FirstArgIndex + I);
+}
+
+/// Prints an operand of an instruction.
+///
+/// Metadata are numbered across the whole module, so only their content
+/// which is important for analysis is printed.
+void printOperand(const Value &V, ModuleSlotTracker &MST, raw_ostream &OS) {
+  auto *MDV = dyn_cast<MetadataAsValue>(&V);
+  if (!MDV) {
+    V.printAsOperand(OS, true, MST);
+    return;
+  }
+  auto *MD = MDV->getMetadata();
+  if (auto *VAM = dyn_cast<ValueAsMetadata>(MD)) {
+    VAM->getValue()->printAsOperand(OS, true, MST);
+  } else if (auto *Var = dyn_cast<DIVariable>(MD)) {
+    OS << "var " << Var->getName();
+  } else if (auto *Expr = dyn_cast<DIExpression>(MD)) {
+    OS << "expr";
+    for (auto Op : Expr->getElements())
+      OS << ' ' << Op;
+  } else {
+    OS << "metadata";
+  }
+}
+
+/// Prints content of metadata attached to an instruction.
+///
+/// Nodes are printed recursively, a node which has been already printed is
+/// referenced by its index in the order of printing, so the result does not
+/// depend on numbering of metadata in the module.
+void printMetadata(const Metadata *MD, ModuleSlotTracker &MST,
+    DenseMap<const Metadata *, unsigned> &Visited, raw_ostream &OS) {
+  if (!MD) {
+    OS << "null";
+    return;
+  }
+  if (auto *S = dyn_cast<MDString>(MD)) {
+    OS << '"' << S->getString() << '"';
+    return;
+  }
+  if (auto *VAM = dyn_cast<ValueAsMetadata>(MD)) {
+    VAM->getValue()->printAsOperand(OS, true, MST);
+    return;
+  }
+  auto Info = Visited.try_emplace(MD, Visited.size());
+  if (!Info.second) {
+    OS << '^' << Info.first->second;
+    return;
+  }
+  auto *N = dyn_cast<MDNode>(MD);
+  if (!N) {
+    OS << "metadata";
+    return;
+  }
+  OS << N->getMetadataID() << (N->isDistinct() ? " distinct" : "") << " {";
+  if (auto *DN = dyn_cast<DINode>(N))
+    OS << DN->getTag() << ' ';
+  for (auto &Op : N->operands()) {
+    printMetadata(Op.get(), MST, Visited, OS);
+    OS << ',';
+  }
+  OS << '}';
+}
+
+std::string getDigest(StringRef Data) {
+  MD5 Hash;
+  Hash.update(Data);
+  MD5::MD5Result Result;
+  Hash.final(Result);
+  return Result.digest().str().str();
+}
+}
+
+IRFingerprint::IRFingerprint(const Module &M) : mModule(&M) {
+  FunctionList AddressTaken;
+  for (auto &F : M)
+    if (F.hasAddressTaken())
+      AddressTaken.push_back(&F);
+  for (auto &F : M)
+    for (auto &I : instructions(F)) {
+      auto *CB = dyn_cast<CallBase>(&I);
+      if (!CB)
+        continue;
+      auto addCall = [this, &F](const Function *Callee) {
+        mCallees[&F].push_back(Callee);
+        mCallers[Callee].push_back(&F);
+      };
+      if (auto *Callee = dyn_cast<Function>(
+            CB->getCalledOperand()->stripPointerCasts()))
+        addCall(Callee);
+      else
+        for (auto *Callee : AddressTaken)
+          addCall(Callee);
+    }
+  std::string Globals;
+  raw_string_ostream OS(Globals);
+  OS << M.getSourceFileName() << '\0' << M.getTargetTriple() << '\0'
+     << M.getDataLayoutStr();
+  ModuleSlotTracker MST(&M, false);
+  for (auto &GV : M.globals()) {
+    OS << '\0' << GV.getName() << ' ' << GV.getLinkage() << ' '
+       << GV.isConstant() << ' ';
+    GV.getValueType()->print(OS);
+    if (GV.hasInitializer()) {
+      OS << ' ';
+      GV.getInitializer()->printAsOperand(OS, true, MST);
+    }
+  }
+  mGlobals = getDigest(OS.str());
+}
+
+StringRef IRFingerprint::getOwn(const Function &F) {
+  auto Itr = mOwn.find(&F);
+  if (Itr != mOwn.end())
+    return Itr->second;
+  std::string IR;
+  raw_string_ostream OS(IR);
+  OS << F.getName() << '\0' << F.getLinkage() << '\0';
+  F.getFunctionType()->print(OS);
+  OS << '\0';
+  printAttributes(F.getAttributes(), F.arg_size(), OS);
+  // Local values are numbered inside the function, so these numbers are
+  // stable if other functions are changed.
+  ModuleSlotTracker MST(mModule, false);
+  MST.incorporateFunction(F);
+  SmallVector<StringRef, 16> MDKindNames;
+  F.getContext().getMDKindNames(MDKindNames);
+  SmallVector<std::pair<unsigned, MDNode *>, 4> MDs;
+  for (auto &BB : F) {
+    OS << '\0';
+    BB.printAsOperand(OS, false, MST);
+    for (auto &I : BB) {
+      OS << '\n' << I.getOpcodeName() << ' '
+         << I.getRawSubclassOptionalData() << ' ';
+      I.getType()->print(OS);
+      if (!I.getType()->isVoidTy()) {
+        OS << ' ';
+        I.printAsOperand(OS, false, MST);
+      }
+      if (auto *Cmp = dyn_cast<CmpInst>(&I)) {
+        OS << ' ' << Cmp->getPredicate();
+      } else if (auto *AI = dyn_cast<AllocaInst>(&I)) {
+        OS << ' ';
+        AI->getAllocatedType()->print(OS);
+        OS << ' ' << AI->getAlign().value();
+      } else if (auto *GEP = dyn_cast<GetElementPtrInst>(&I)) {
+        OS << ' ';
+        GEP->getSourceElementType()->print(OS);
+      } else if (auto *LI = dyn_cast<LoadInst>(&I)) {
+        OS << ' ' << LI->isVolatile() << ' '
+           << static_cast<unsigned>(LI->getOrdering()) << ' '
+           << LI->getAlign().value();
+      } else if (auto *SI = dyn_cast<StoreInst>(&I)) {
+        OS << ' ' << SI->isVolatile() << ' '
+           << static_cast<unsigned>(SI->getOrdering()) << ' '
+           << SI->getAlign().value();
+      } else if (auto *EVI = dyn_cast<ExtractValueInst>(&I)) {
+        for (auto Idx : EVI->indices())
+          OS << ' ' << Idx;
+      } else if (auto *IVI = dyn_cast<InsertValueInst>(&I)) {
+        for (auto Idx : IVI->indices())
+          OS << ' ' << Idx;
+      } else if (auto *CB = dyn_cast<CallBase>(&I)) {
+        OS << ' ';
+        CB->getFunctionType()->print(OS);
+        OS << ' ';
+        printAttributes(CB->getAttributes(), CB->arg_size(), OS);
+      }
+      for (auto &Op : I.operands()) {
+        OS << ' ';
+        printOperand(*Op, MST, OS);
+      }
+      // Debug locations do not affect analysis, however other metadata
+      // (for example, TBAA or loop properties) may do it.
+      I.getAllMetadataOtherThanDebugLoc(MDs);
+      for (auto &KindMD : MDs) {
+        OS << " !" << MDKindNames[KindMD.first] << ' ';
+        DenseMap<const Metadata *, unsigned> Visited;
+        printMetadata(KindMD.second, MST, Visited, OS);
+      }
+    }
+  }
+  return mOwn.try_emplace(&F, getDigest(OS.str())).first->second;
+}
+
+std::string IRFingerprint::get(const Function &F) {
+  auto Itr = mDependencies.find(&F);
+  if (Itr != mDependencies.end())
+    return Itr->second;
+  auto visit = [](const DenseMap<const Function *, FunctionList> &Edges,
+      SmallPtrSetImpl<const Function *> &Visited) {
+    SmallVector<const Function *, 32> Worklist(Visited.begin(), Visited.end());
+    while (!Worklist.empty()) {
+      auto EdgeItr = Edges.find(Worklist.pop_back_val());
+      if (EdgeItr == Edges.end())
+        continue;
+      for (auto *Next : EdgeItr->second)
+        if (Visited.insert(Next).second)
+          Worklist.push_back(Next);
+    }
+  };
+  SmallPtrSet<const Function *, 32> Dependencies;
+  Dependencies.insert(&F);
+  visit(mCallers, Dependencies);
+  visit(mCallees, Dependencies);
+  MD5 Hash;
+  Hash.update(mGlobals);
+  // Traverse functions in the order of the module, so the fingerprint does
+  // not depend on addresses of functions.
+  for (auto &D : *mModule)
+    if (Dependencies.count(&D))
+      Hash.update(getOwn(D));
+  MD5::MD5Result Result;
+  Hash.final(Result);
+  return mDependencies.try_emplace(&F, Result.digest().str().str())
+    .first->second;
+}
+
+std::string IRFingerprint::get() {
+  if (!mWhole.empty())
+    return mWhole;
+  MD5 Hash;
+  Hash.update(mGlobals);
+  for (auto &F : *mModule)
+    Hash.update(getOwn(F));
+  MD5::MD5Result Result;
+  Hash.final(Result);
+  mWhole = Result.digest().str().str();
+  return mWhole;
+}
+
+ResponseCache::KeyBuilder::KeyBuilder() {
+  add(TSAR_VERSION_STRING).add(LLVM_VERSION_STRING)
+    .add(std::to_string(FormatVersion));
+}
+
+ResponseCache::KeyBuilder & ResponseCache::KeyBuilder::add(StringRef Data) {
+  static const uint8_t Separator = 0;
+  mHash.update(Data);
+  // Separate pieces of data to distinguish "ab","c" from "a","bc".
+  mHash.update(makeArrayRef(Separator));
+  return *this;
+}
+
+ResponseCache::KeyBuilder & ResponseCache::KeyBuilder::add(
+    const GlobalOptions &GO) {
+  std::string Options;
+  raw_string_ostream OS(Options);
+  OS << GO.IsSafeTypeCast << GO.InBoundsSubscripts << GO.AnalyzeLibFunc
+     << GO.IgnoreRedundantMemory << GO.UnsafeTfmAnalysis << GO.NoExternalCalls
+     << GO.NoInline << GO.PrintFilenameOnly;
+  for (auto &R : GO.OptRegions)
+    OS << '\0' << R;
+  add(OS.str());
+  // A file with external analysis results may be updated between sessions,
+  // so its content rather than its path is a part of the key.
+  if (GO.AnalysisUse.empty())
+    return add("");
+  auto Buffer = MemoryBuffer::getFile(GO.AnalysisUse);
+  if (!Buffer)
+    return add("unavailable:" + GO.AnalysisUse);
+  return add(getDigest((*Buffer)->getBuffer()));
+}
+
+std::string ResponseCache::KeyBuilder::getKey() {
+  MD5::MD5Result Result;
+  mHash.final(Result);
+  return Result.digest().str().str();
+}
+
+std::string ResponseCache::getPath(StringRef Key) const {
+  SmallString<128> Path(mDir);
+  sys::path::append(Path, "llvmcache-" + Key);
+  return Path.str().str();
+}
+
+Optional<std::string> ResponseCache::find(StringRef Key) const {
+  if (!isEnabled())
+    return None;
+  auto Path = getPath(Key);
+  int FD;
+  if (sys::fs::openFileForRead(Path, FD))
+    return None;
+  auto Buffer = MemoryBuffer::getOpenFile(FD, Path, -1);
+  // Pruning evicts responses which have not been accessed for a long time.
+  sys::fs::setLastAccessAndModificationTime(FD,
+    std::chrono::system_clock::now());
+  sys::fs::closeFile(FD);
+  if (!Buffer)
+    return None;
+  return (*Buffer)->getBuffer().str();
+}
+
+void ResponseCache::prune(const CachePruningPolicy &Policy) const {
+  if (isEnabled())
+    pruneCache(mDir, Policy);
+}
+
+void ResponseCache::insert(StringRef Key, StringRef Response) const {
+  if (!isEnabled() || sys::fs::create_directories(mDir))
+    return;
+  auto Path = getPath(Key);
+  // Write a response to a temporary file at first, so concurrent servers
+  // never observe partially written responses.
+  SmallString<128> TmpPath;
+  int FD;
+  if (sys::fs::createUniqueFile(Path + "-%%%%%%%%.tmp", FD, TmpPath))
+    return;
+  {
+    raw_fd_ostream OS(FD, true);
+    OS << Response;
+    OS.close();
+    if (OS.has_error()) {
+      OS.clear_error();
+      sys::fs::remove(TmpPath);
+      return;
+    }
+  }
+  if (sys::fs::rename(TmpPath, Path))
+    sys::fs::remove(TmpPath);
+}
@@ -0,0 +1,152 @@
+//===- ResponseCache.h ---- On-Disk Cache of Responses ----------*- C++ -*-===//
+//
+//                       Traits Static Analyzer (SAPFOR)
+//
+// Copyright 2020 DVM System Group
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+//===----------------------------------------------------------------------===//
+//
+// This defines an on-disk cache of responses to client requests. A response
+// which relates to a function is keyed by a hash of a request, of IR which
+// analysis of the function depends on, of sources of the function and of
+// global options. So, the cache survives between server sessions and results
+// for unchanged functions are not recomputed if other functions are edited.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef TSAR_RESPONSE_CACHE_H
+#define TSAR_RESPONSE_CACHE_H
+
+#include <llvm/ADT/DenseMap.h>
+#include <llvm/ADT/Optional.h>
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/Support/CachePruning.h>
+#include <llvm/Support/MD5.h>
+#include <string>
+
+namespace llvm {
+class Function;
+class Module;
+}
+
+namespace tsar {
+struct GlobalOptions;
+
+/// Fingerprints of IR which are stable between sessions.
+///
+/// A fingerprint of a function does not depend on numbering of metadata and
+/// of unnamed global values in a module, so it changes only if the function
+/// itself is changed. Metadata which are attached to instructions (including
+/// debug locations) are ignored, so a key should also contain sources
+/// a response is built from.
+class IRFingerprint {
+public:
+  /// Builds a call graph of a specified module, fingerprints of functions are
+  /// computed on demand.
+  ///
+  /// The module must not be changed while the fingerprint is used.
+  explicit IRFingerprint(const llvm::Module &M);
+
+  /// Returns a fingerprint of IR which results of analysis of a specified
+  /// function depend on.
+  ///
+  /// It covers global variables, the function, all functions which may call
+  /// it (transitively) and all functions which may be called from any of
+  /// them (transitively). Defined memory depends on callees and live memory
+  /// depends on callers and on their callees, so other functions do not
+  /// affect results of analysis.
+  std::string get(const llvm::Function &F);
+
+  /// Returns a fingerprint of a whole module.
+  std::string get();
+
+private:
+  using FunctionList = llvm::SmallVector<const llvm::Function *, 8>;
+
+  /// Returns a fingerprint of a specified function only.
+  llvm::StringRef getOwn(const llvm::Function &F);
+
+  const llvm::Module *mModule;
+  std::string mGlobals;
+  llvm::DenseMap<const llvm::Function *, FunctionList> mCallees;
+  llvm::DenseMap<const llvm::Function *, FunctionList> mCallers;
+  llvm::DenseMap<const llvm::Function *, std::string> mOwn;
+  llvm::DenseMap<const llvm::Function *, std::string> mDependencies;
+  std::string mWhole;
+};
+
+/// On-disk cache of responses to client requests.
+///
+/// Each response is stored in a separate file which name has 'llvmcache-'
+/// prefix, so the cache directory can be pruned with llvm::pruneCache().
+class ResponseCache {
+public:
+  /// Builder of a key for a response.
+  class KeyBuilder {
+  public:
+    /// Creates a builder of a key which contains versions of TSAR, LLVM and
+    /// of the format of responses, so responses which have been produced by
+    /// other versions of the server are never reused.
+    KeyBuilder();
+
+    /// Adds arbitrary data to the key.
+    KeyBuilder & add(llvm::StringRef Data);
+
+    /// Adds global options to the key.
+    KeyBuilder & add(const GlobalOptions &GO);
+
+    /// Returns the key, the builder must not be used after that.
+    std::string getKey();
+
+  private:
+    llvm::MD5 mHash;
+  };
+
+  /// Version of the format of cached responses.
+  ///
+  /// It must be incremented if messages sent to a client are changed and
+  /// TSAR version remains the same (for example, in a dirty build).
+  static constexpr unsigned FormatVersion = 2;
+
+  /// Creates a cache which stores responses in a specified directory.
+  ///
+  /// The cache is disabled if the directory is not specified.
+  explicit ResponseCache(llvm::StringRef Dir) : mDir(Dir) {}
+
+  /// Returns true if the cache is enabled.
+  bool isEnabled() const noexcept { return !mDir.empty(); }
+
+  /// Returns a cached response for a specified key if it exists.
+  ///
+  /// Access time of the response is updated, so the least recently used
+  /// responses are evicted at first.
+  llvm::Optional<std::string> find(llvm::StringRef Key) const;
+
+  /// Stores a response for a specified key, errors are ignored.
+  void insert(llvm::StringRef Key, llvm::StringRef Response) const;
+
+  /// Removes expired responses and the least recently used responses
+  /// if the cache exceeds limits of a specified policy.
+  void prune(const llvm::CachePruningPolicy &Policy) const;
+
+private:
+  /// Returns a path to a file which contains a response for a specified key.
+  std::string getPath(llvm::StringRef Key) const;
+
+  std::string mDir;
+};
+}
+#endif//TSAR_RESPONSE_CACHE_H
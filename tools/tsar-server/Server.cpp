@@ -27,10 +27,12 @@
 // bcl::IntrusiveConnection interface.
 //
 // The first request from client should be msg::CommandLine which specifies
-// analysis options and targets for input/output redirection.
+// analysis options, targets for input/output redirection and encoding of
+// responses to analysis requests.
 //
 //===----------------------------------------------------------------------===//
 
+#include "BinaryMessages.h"
 #include "Messages.h"
 #include "Passes.h"
 #include "tsar/Analysis/Clang/Passes.h"
@@ -68,19 +70,23 @@ namespace msg {
 ///
 /// This consists of the following elements:
 /// - list of arguments which contains options and input data,
-/// - specification of an input/output redirection.
+/// - specification of an input/output redirection,
+/// - encoding of responses to analysis requests ("json" by default or
+/// "binary", see BinaryMessages.h).
 JSON_OBJECT_BEGIN(CommandLine)
-JSON_OBJECT_ROOT_PAIR_5(CommandLine,
+JSON_OBJECT_ROOT_PAIR_6(CommandLine,
   Args, std::vector<const char *>,
   Query, const char *,
   Input, const char *,
   Output, const char *,
-  Error, const char *)
+  Error, const char *,
+  Encoding, const char *)
 
   CommandLine() :
     JSON_INIT_ROOT,
     JSON_INIT(CommandLine,
-      std::vector<const char *>(), nullptr, nullptr, nullptr, nullptr) {}
+      std::vector<const char *>(), nullptr, nullptr, nullptr, nullptr,
+      nullptr) {}
 
   ~CommandLine() {
     auto &This = *this;
@@ -95,6 +101,8 @@ JSON_OBJECT_ROOT_PAIR_5(CommandLine,
       delete[] This[CommandLine::Output];
     if (This[CommandLine::Error])
       delete[] This[CommandLine::Error];
+    if (This[CommandLine::Encoding])
+      delete[] This[CommandLine::Encoding];
   }
 
   CommandLine(const CommandLine &) = default;
@@ -111,9 +119,10 @@ namespace {
 class ServerQueryManager : public QueryManager {
 public:
   explicit ServerQueryManager(const GlobalOptions &GO, IntrusiveConnection &C,
-      RedirectIO &StdIn, RedirectIO &StdOut, RedirectIO &StdErr)
+      RedirectIO &StdIn, RedirectIO &StdOut, RedirectIO &StdErr,
+      msg::Encoding E)
     : mGlobalOptions(GO), mConnection(C), mStdIn(StdIn), mStdOut(StdOut),
-      mStdErr(StdErr) {}
+      mStdErr(StdErr), mEncoding(E) {}
 
   void run(llvm::Module *M, TransformationInfo *TfmInfo) override {
     assert(M && "Module must not be null!");
@@ -141,7 +150,7 @@ public:
     // mapping. So, metadata-level memory mapping is a shared resource and
     // synchronization is necessary.
     Passes.add(createAnalysisWaitServerPass());
-    Passes.add(createPrivateServerPass(mConnection, mStdErr));
+    Passes.add(createPrivateServerPass(mConnection, mStdErr, mEncoding));
     Passes.add(createVerifierPass());
     Passes.run(*M);
   }
@@ -154,6 +163,7 @@ private:
   RedirectIO &mStdIn;
   RedirectIO &mStdOut;
   RedirectIO &mStdErr;
+  msg::Encoding mEncoding;
   ASTImportInfo mImportInfo;
 };
 
@@ -167,7 +177,8 @@ void run(IntrusiveConnection C) {
   std::unique_ptr<Tool> Analyzer;
   RedirectIO StdIn, StdOut, StdErr;
   bool IsQuerySet = false;
-  C.answer([&Analyzer, &StdIn, &StdOut, &StdErr, &IsQuerySet](
+  auto Encoding = msg::Encoding::JSON;
+  C.answer([&Analyzer, &StdIn, &StdOut, &StdErr, &IsQuerySet, &Encoding](
       const std::string &Request) -> std::string {
     Parser P(Request);
     msg::CommandLine CL;
@@ -176,6 +187,13 @@ void run(IntrusiveConnection C) {
       Diag.insert(msg::Diagnostic::Error, P.errors());
       return Parser::unparseAsObject(Diag);
     }
+    if (CL[msg::CommandLine::Encoding] &&
+        !msg::parseEncoding(CL[msg::CommandLine::Encoding], Encoding)) {
+      Diag[msg::Diagnostic::Error].push_back(
+        std::string("unknown encoding '") + CL[msg::CommandLine::Encoding] +
+        "'");
+      return Parser::unparseAsObject(Diag);
+    }
     if (CL[msg::CommandLine::Error])
       StdErr = std::move(
         RedirectIO(STDERR_FILENO, CL[msg::CommandLine::Error]));
@@ -220,7 +238,7 @@ void run(IntrusiveConnection C) {
     Analyzer->run();
   } else {
     ServerQueryManager QM(Analyzer->getGlobalOptions(),
-      C, StdIn, StdOut, StdErr);
+      C, StdIn, StdOut, StdErr, Encoding);
     Analyzer->run(&QM);
   }
   C.answer([&StdErr](const std::string &) {
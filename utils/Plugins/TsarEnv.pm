@@ -13,11 +13,19 @@ sub on_prepare {
   my $tsar = $task->get_var('', 'tsar');
   return if !$tsar;
 
+  # Tools to build tests and a directory for intermediate files.
+  my %defaults = (clang => 'clang', opt => 'opt', workdir => '.');
+  my $env = "tsar=$tsar";
+  for (sort keys %defaults) {
+    my $value = $task->get_var('', $_, $defaults{$_});
+    $env .= ",$_=$value";
+  }
+
   for (my $i = $$pind + 1; $i < @$all_tasks; $i++) {
     my $t = $all_tasks->[$i];
     last if $t->plugin eq 'TsarEnv';
     next if $t->plugin ne 'TsarPlugin';
-    my $new_id = $t->id.($t->id->args ? ',' : ':')."tsar=$tsar";
+    my $new_id = $t->id.($t->id->args ? ',' : ':').$env;
     $all_tasks->[$i] = $db->new_task($new_id);
   }
 }